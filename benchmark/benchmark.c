@@ -0,0 +1,112 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "benchmark.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+
+#pragma mark - Private Functions -
+
+#if defined(__linux__)
+static int open_cache_miss_counter(void)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.size = sizeof(attr);
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.disabled = 1;
+	attr.inherit = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+#pragma mark - APIs -
+
+uint64_t benchmark_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t)ts.tv_sec * 1000000000ULL) + (uint64_t)ts.tv_nsec;
+}
+
+void benchmark_start(benchmark_t* b)
+{
+	b->elapsed_ns = 0;
+	b->cache_misses = 0;
+	b->cache_misses_valid = false;
+	b->perf_fd = -1;
+
+#if defined(__linux__)
+	b->perf_fd = open_cache_miss_counter();
+	if(b->perf_fd >= 0)
+	{
+		ioctl(b->perf_fd, PERF_EVENT_IOC_RESET, 0);
+		ioctl(b->perf_fd, PERF_EVENT_IOC_ENABLE, 0);
+	}
+#endif
+
+	b->start_ns = benchmark_now_ns();
+}
+
+void benchmark_stop(benchmark_t* b)
+{
+	b->elapsed_ns = benchmark_now_ns() - b->start_ns;
+
+#if defined(__linux__)
+	if(b->perf_fd >= 0)
+	{
+		uint64_t count = 0;
+
+		ioctl(b->perf_fd, PERF_EVENT_IOC_DISABLE, 0);
+		if(read(b->perf_fd, &count, sizeof(count)) == (ssize_t)sizeof(count))
+		{
+			b->cache_misses = count;
+			b->cache_misses_valid = true;
+		}
+
+		close(b->perf_fd);
+		b->perf_fd = -1;
+	}
+#endif
+}
+
+void benchmark_print_header(void)
+{
+	printf("%-28s %-14s %10s %12s %10s %14s\n", "suite", "workload", "param", "ops", "ns/op",
+		   "cache-misses");
+}
+
+void benchmark_report(const benchmark_t* b, const char* suite, const char* workload,
+					  uint64_t param, uint64_t ops)
+{
+	double ns_per_op = (ops) ? (double)b->elapsed_ns / (double)ops : 0.0;
+
+	printf("%-28s %-14s %10llu %12llu %10.2f ", suite, workload, (unsigned long long)param,
+		   (unsigned long long)ops, ns_per_op);
+
+	if(b->cache_misses_valid)
+	{
+		printf("%14llu\n", (unsigned long long)b->cache_misses);
+	}
+	else
+	{
+		printf("%14s\n", "n/a");
+	}
+}
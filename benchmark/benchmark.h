@@ -0,0 +1,58 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Shared helpers for the benchmark programs in this folder.
+///
+/// A benchmark brackets its measured loop with benchmark_start() and benchmark_stop(), then
+/// prints one result line with benchmark_report(). Each result records the wall-clock time and,
+/// where the kernel allows it, the hardware cache-miss count for the measured region.
+///
+/// Cache misses are read with perf_event_open on Linux. The counter is inherited by threads
+/// created after benchmark_start(), so multi-threaded workloads are counted in full. On other
+/// systems, or when perf events are restricted (see /proc/sys/kernel/perf_event_paranoid),
+/// the cache-miss column is reported as "n/a".
+
+typedef struct
+{
+	uint64_t start_ns;
+	uint64_t elapsed_ns;
+	uint64_t cache_misses;
+	bool cache_misses_valid;
+	int perf_fd;
+} benchmark_t;
+
+/// Returns a monotonic timestamp in nanoseconds
+uint64_t benchmark_now_ns(void);
+
+/// Start timing (and counting cache misses for) a measured region
+void benchmark_start(benchmark_t* b);
+
+/// Stop the measurement started by benchmark_start
+void benchmark_stop(benchmark_t* b);
+
+/// Print the column headers that match benchmark_report
+void benchmark_print_header(void);
+
+/// Print a result line: suite, workload, and parameter identify the measurement,
+/// and ops is the number of operations performed in the measured region
+void benchmark_report(const benchmark_t* b, const char* suite, const char* workload,
+					  uint64_t param, uint64_t ops);
+
+/// Prevent the compiler from optimizing away a computed value
+static inline void benchmark_do_not_optimize(const void* p)
+{
+	__asm__ volatile("" : : "g"(p) : "memory");
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BENCHMARK_H_
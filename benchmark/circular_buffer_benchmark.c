@@ -0,0 +1,190 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "benchmark.h"
+#include "circular_buffer/circular_buffer.h"
+
+/// This file is compiled once per circular buffer backend. The build defines
+/// CIRCULAR_BUFFER_BACKEND to name the backend in the report, and defines
+/// CIRCULAR_BUFFER_THREADSAFE when the backend supports a concurrent producer and consumer.
+
+#ifndef CIRCULAR_BUFFER_BACKEND
+#define CIRCULAR_BUFFER_BACKEND "circular_buffer"
+#endif
+
+/// Approximate number of operations to run for each measurement
+#define OPS_PER_MEASUREMENT (1U << 21)
+
+/// Number of bytes transferred between threads in the SPSC workload
+#define SPSC_TRANSFER_COUNT (1U << 18)
+
+/// Number of bytes examined by each call to circular_buf_peek in the peek workload
+#define PEEK_LOOK_AHEAD 8U
+
+/// Power-of-two capacities are paired with nearby sizes that are not,
+/// since that is where the modulo and no_modulo backends differ
+static const size_t capacities_[] = {
+	16, 17, 255, 256, 1000, 1024, 4095, 4096, 65535, 65536,
+};
+
+#define CAPACITY_COUNT (sizeof(capacities_) / sizeof(capacities_[0]))
+
+static uint8_t storage_[65536];
+
+#pragma mark - Workloads -
+
+/// Repeatedly fill the buffer to capacity, then drain it
+static void bench_put_get(size_t size)
+{
+	cbuf_handle_t cbuf = circular_buf_init(storage_, size);
+	size_t capacity = circular_buf_capacity(cbuf);
+	size_t rounds = OPS_PER_MEASUREMENT / (2 * capacity);
+	uint64_t sum = 0;
+	uint8_t data;
+	benchmark_t b;
+
+	if(rounds == 0)
+	{
+		rounds = 1;
+	}
+
+	benchmark_start(&b);
+
+	for(size_t r = 0; r < rounds; r++)
+	{
+		for(size_t i = 0; i < capacity; i++)
+		{
+			circular_buf_try_put(cbuf, (uint8_t)i);
+		}
+
+		for(size_t i = 0; i < capacity; i++)
+		{
+			circular_buf_get(cbuf, &data);
+			sum += data;
+		}
+	}
+
+	benchmark_stop(&b);
+	benchmark_do_not_optimize(&sum);
+	benchmark_report(&b, CIRCULAR_BUFFER_BACKEND, "put_get", size, rounds * capacity * 2);
+
+	circular_buf_free(cbuf);
+}
+
+/// Keep the buffer half full, looking ahead at the oldest data before consuming
+/// a single byte and adding a new one. This is a typical packet parser pattern.
+static void bench_peek(size_t size)
+{
+	cbuf_handle_t cbuf = circular_buf_init(storage_, size);
+	size_t fill = circular_buf_capacity(cbuf) / 2;
+	size_t look_ahead = (fill < PEEK_LOOK_AHEAD) ? fill : PEEK_LOOK_AHEAD;
+	uint8_t window[PEEK_LOOK_AHEAD];
+	uint64_t sum = 0;
+	uint8_t data;
+	benchmark_t b;
+
+	for(size_t i = 0; i < fill; i++)
+	{
+		circular_buf_try_put(cbuf, (uint8_t)i);
+	}
+
+	benchmark_start(&b);
+
+	for(size_t i = 0; i < OPS_PER_MEASUREMENT; i++)
+	{
+		circular_buf_peek(cbuf, window, (unsigned int)look_ahead);
+		sum += window[0];
+		circular_buf_get(cbuf, &data);
+		circular_buf_try_put(cbuf, data);
+	}
+
+	benchmark_stop(&b);
+	benchmark_do_not_optimize(&sum);
+	benchmark_report(&b, CIRCULAR_BUFFER_BACKEND, "peek", size, OPS_PER_MEASUREMENT);
+
+	circular_buf_free(cbuf);
+}
+
+#ifdef CIRCULAR_BUFFER_THREADSAFE
+static void* spsc_producer(void* arg)
+{
+	cbuf_handle_t cbuf = arg;
+
+	for(uint32_t i = 0; i < SPSC_TRANSFER_COUNT; i++)
+	{
+		while(circular_buf_try_put(cbuf, (uint8_t)i) != 0)
+		{
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+/// Transfer bytes from a producer thread to the calling thread.
+/// The reported time is per byte transferred.
+static void bench_spsc(size_t size)
+{
+	cbuf_handle_t cbuf = circular_buf_init(storage_, size);
+	uint64_t sum = 0;
+	pthread_t producer;
+	uint8_t data;
+	benchmark_t b;
+
+	benchmark_start(&b);
+
+	int r = pthread_create(&producer, NULL, spsc_producer, cbuf);
+	assert(r == 0);
+	(void)r;
+
+	for(uint32_t i = 0; i < SPSC_TRANSFER_COUNT;)
+	{
+		if(circular_buf_get(cbuf, &data) == 0)
+		{
+			sum += data;
+			i++;
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+
+	pthread_join(producer, NULL);
+
+	benchmark_stop(&b);
+	benchmark_do_not_optimize(&sum);
+	benchmark_report(&b, CIRCULAR_BUFFER_BACKEND, "spsc", size, SPSC_TRANSFER_COUNT);
+
+	circular_buf_free(cbuf);
+}
+#endif
+
+#pragma mark - Main -
+
+int main(void)
+{
+	benchmark_print_header();
+
+	for(size_t i = 0; i < CAPACITY_COUNT; i++)
+	{
+		bench_put_get(capacities_[i]);
+	}
+
+	for(size_t i = 0; i < CAPACITY_COUNT; i++)
+	{
+		bench_peek(capacities_[i]);
+	}
+
+#ifdef CIRCULAR_BUFFER_THREADSAFE
+	for(size_t i = 0; i < CAPACITY_COUNT; i++)
+	{
+		bench_spsc(capacities_[i]);
+	}
+#endif
+
+	return 0;
+}
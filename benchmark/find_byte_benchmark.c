@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/// Compares the libc byte search functions against the host's C library over a sweep of
+/// string lengths. The param column is the length in bytes.
+///
+/// strlen(), strchr(), strrchr(), and memchr() share the kernel in
+/// examples/libc/string/find_byte.c. Each call scans the whole string: the character that is
+/// searched for doesn't occur, so strchr() stops at the terminator and memchr() at the end of
+/// the buffer. Two workloads are measured:
+///	- aligned: the string starts on a 64-byte boundary
+///	- unaligned: the string starts 5 bytes past one, so the first block is partial
+///
+/// The libc versions are built with renamed symbols (see examples/libc/meson.build) so that
+/// they can be linked alongside the host's C library.
+
+size_t libc_strlen(const char* str);
+char* libc_strchr(const char* s, int c);
+char* libc_strrchr(const char* s, int c);
+void* libc_memchr(const void* s, int c, size_t n);
+
+#define MAX_LENGTH (1024 * 1024)
+#define MAX_OFFSET 64
+#define BUFFER_SIZE (MAX_LENGTH + MAX_OFFSET + 64)
+#define BYTES_PER_MEASUREMENT (256 * 1024 * 1024)
+#define MIN_OPS 32
+#define MAX_OPS (1U << 24)
+
+/// Not present in the string
+#define ABSENT 'z'
+
+static const size_t lengths_[] = {
+	1, 3, 8, 15, 16, 31, 32, 64, 100, 128, 256, 512, 1024, 4096, 16384, 65536, 262144, 1048576,
+};
+
+#define LENGTH_COUNT (sizeof(lengths_) / sizeof(lengths_[0]))
+
+#pragma mark - Implementations -
+
+typedef struct
+{
+	const char* name;
+	size_t (*strlen_fn)(const char* str);
+	char* (*strchr_fn)(const char* s, int c);
+	char* (*strrchr_fn)(const char* s, int c);
+	void* (*memchr_fn)(const void* s, int c, size_t n);
+} impl_t;
+
+static const impl_t impls_[] = {
+	{"libc", libc_strlen, libc_strchr, libc_strrchr, libc_memchr},
+	{"host", strlen, strchr, strrchr, memchr},
+};
+
+#define IMPL_COUNT (sizeof(impls_) / sizeof(impls_[0]))
+
+typedef enum
+{
+	FN_STRLEN,
+	FN_STRCHR,
+	FN_STRRCHR,
+	FN_MEMCHR,
+	FN_COUNT
+} fn_t;
+
+static const char* fn_names_[FN_COUNT] = {"strlen", "strchr", "strrchr", "memchr"};
+
+static const struct
+{
+	const char* name;
+	size_t offset;
+} workloads_[] = {
+	{"aligned", 0},
+	{"unaligned", 5},
+};
+
+#define WORKLOAD_COUNT (sizeof(workloads_) / sizeof(workloads_[0]))
+
+#pragma mark - Workloads -
+
+static uint64_t op_count(size_t length)
+{
+	uint64_t ops = BYTES_PER_MEASUREMENT / length;
+
+	if(ops > MAX_OPS)
+	{
+		return MAX_OPS;
+	}
+
+	return (ops < MIN_OPS) ? MIN_OPS : ops;
+}
+
+static const void* call(const impl_t* impl, fn_t fn, const char* s, size_t length)
+{
+	switch(fn)
+	{
+		case FN_STRLEN:
+			return s + impl->strlen_fn(s);
+		case FN_STRCHR:
+			return impl->strchr_fn(s, ABSENT);
+		case FN_STRRCHR:
+			return impl->strrchr_fn(s, ABSENT);
+		case FN_MEMCHR:
+		default:
+			return impl->memchr_fn(s, ABSENT, length);
+	}
+}
+
+static void run(const impl_t* impl, fn_t fn, const char* workload, const char* s, size_t length)
+{
+	uint64_t ops = op_count(length);
+	char suite[32];
+	benchmark_t b;
+
+	snprintf(suite, sizeof(suite), "%s_%s", impl->name, fn_names_[fn]);
+
+	// Warm up the caches and page tables
+	benchmark_do_not_optimize(call(impl, fn, s, length));
+
+	benchmark_start(&b);
+
+	for(uint64_t i = 0; i < ops; i++)
+	{
+		benchmark_do_not_optimize(call(impl, fn, s, length));
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, suite, workload, length, ops);
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	char* buffer = aligned_alloc(64, BUFFER_SIZE);
+
+	if(buffer == NULL)
+	{
+		fprintf(stderr, "Failed to allocate the string buffer\n");
+		return 1;
+	}
+
+	memset(buffer, 'a', BUFFER_SIZE);
+
+	benchmark_print_header();
+
+	for(size_t l = 0; l < LENGTH_COUNT; l++)
+	{
+		size_t length = lengths_[l];
+
+		for(size_t w = 0; w < WORKLOAD_COUNT; w++)
+		{
+			char* s = buffer + workloads_[w].offset;
+
+			s[length] = '\0';
+
+			for(size_t i = 0; i < IMPL_COUNT; i++)
+			{
+				for(int fn = 0; fn < FN_COUNT; fn++)
+				{
+					run(&impls_[i], (fn_t)fn, workloads_[w].name, s, length);
+				}
+			}
+
+			s[length] = 'a';
+		}
+	}
+
+	free(buffer);
+
+	return 0;
+}
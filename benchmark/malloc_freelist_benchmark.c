@@ -0,0 +1,317 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/// Replays an allocation trace against the free-list allocators, and reports the latency
+/// distribution of malloc() and free() along with how fragmented the pool is afterwards.
+///
+/// Two allocators are compared. Both are built with renamed symbols so that they can be
+/// linked into the same program as the host's malloc:
+///	- malloc_freelist: examples/libc/malloc_freelist.c
+///	- fl_malloc: the first-fit allocator from examples/c/malloc, which walks and
+///	  defragments the whole free list on every free()
+///
+/// By default, a synthetic trace is generated from a fixed seed, so every run replays the same
+/// operations. A recorded trace can be passed as the first argument instead. Each line is
+/// either "m <slot> <size>" to allocate into a slot or "f <slot>" to free it, with slots
+/// numbered from 0 to TRACE_SLOTS - 1.
+
+void* freelist_malloc(size_t size);
+void freelist_free(void* ptr);
+void freelist_malloc_addblock(void* addr, size_t size);
+
+void* fl_malloc(size_t size);
+void fl_free(void* ptr);
+void fl_addblock(void* addr, size_t size);
+
+#define POOL_SIZE (16 * 1024 * 1024)
+#define TRACE_SLOTS 4096
+#define TRACE_GENERATED_OPS 200000
+
+typedef struct
+{
+	uint32_t slot;
+	uint32_t size; // 0 for free
+} trace_op_t;
+
+typedef struct
+{
+	const char* name;
+	void* (*malloc)(size_t);
+	void (*free)(void*);
+	void (*addblock)(void*, size_t);
+} allocator_t;
+
+static const allocator_t allocators_[] = {
+	{"malloc_freelist", freelist_malloc, freelist_free, freelist_malloc_addblock},
+	{"fl_malloc", fl_malloc, fl_free, fl_addblock},
+};
+
+#define ALLOCATOR_COUNT (sizeof(allocators_) / sizeof(allocators_[0]))
+
+static trace_op_t* trace_ = NULL;
+static size_t trace_len_ = 0;
+static void* slots_[TRACE_SLOTS];
+
+#pragma mark - Trace -
+
+static uint32_t xorshift32(uint32_t* state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+/// Mostly small objects, some medium buffers, and a few large ones
+static uint32_t trace_size(uint32_t* rng)
+{
+	uint32_t r = xorshift32(rng) % 100;
+
+	if(r < 70)
+	{
+		return 16 + (xorshift32(rng) % 240);
+	}
+
+	if(r < 95)
+	{
+		return 256 + (xorshift32(rng) % 3840);
+	}
+
+	return 4096 + (xorshift32(rng) % 61440);
+}
+
+static void trace_generate(void)
+{
+	bool live[TRACE_SLOTS] = {false};
+	uint32_t rng = 0x12345678;
+
+	trace_len_ = TRACE_GENERATED_OPS;
+	trace_ = calloc(trace_len_, sizeof(trace_op_t));
+
+	for(size_t i = 0; i < trace_len_; i++)
+	{
+		uint32_t slot = xorshift32(&rng) % TRACE_SLOTS;
+
+		trace_[i].slot = slot;
+		trace_[i].size = live[slot] ? 0 : trace_size(&rng);
+		live[slot] = !live[slot];
+	}
+}
+
+static int trace_load(const char* path)
+{
+	FILE* f = fopen(path, "r");
+	size_t capacity = 1024;
+	char op;
+	unsigned slot;
+	unsigned size;
+
+	if(!f)
+	{
+		perror(path);
+		return -1;
+	}
+
+	trace_ = malloc(capacity * sizeof(trace_op_t));
+
+	while(fscanf(f, " %c %u", &op, &slot) == 2)
+	{
+		size = 0;
+
+		if(op == 'm' && fscanf(f, "%u", &size) != 1)
+		{
+			break;
+		}
+
+		if(slot >= TRACE_SLOTS)
+		{
+			fprintf(stderr, "%s: slot %u is out of range\n", path, slot);
+			fclose(f);
+			return -1;
+		}
+
+		if(trace_len_ == capacity)
+		{
+			capacity *= 2;
+			trace_ = realloc(trace_, capacity * sizeof(trace_op_t));
+		}
+
+		trace_[trace_len_].slot = slot;
+		trace_[trace_len_].size = size;
+		trace_len_++;
+	}
+
+	fclose(f);
+
+	return 0;
+}
+
+#pragma mark - Replay -
+
+static int compare_u32(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a;
+	uint32_t y = *(const uint32_t*)b;
+
+	return (x > y) - (x < y);
+}
+
+static void print_latency(const char* allocator, const char* op, uint32_t* samples, size_t count)
+{
+	uint64_t total = 0;
+
+	if(count == 0)
+	{
+		return;
+	}
+
+	qsort(samples, count, sizeof(uint32_t), compare_u32);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		total += samples[i];
+	}
+
+	printf("%-16s %-8s %10zu %10.1f %8u %8u %10u\n", allocator, op, count,
+		   (double)total / (double)count, samples[count / 2], samples[(count * 99) / 100],
+		   samples[count - 1]);
+}
+
+/// Binary search for the largest block that can still be allocated
+static size_t largest_allocatable(const allocator_t* a)
+{
+	size_t lo = 0;
+	size_t hi = POOL_SIZE;
+
+	while(lo < hi)
+	{
+		size_t mid = lo + ((hi - lo + 1) / 2);
+		void* p = a->malloc(mid);
+
+		if(p)
+		{
+			a->free(p);
+			lo = mid;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+
+	return lo;
+}
+
+static void replay(const allocator_t* a)
+{
+	uint32_t* malloc_ns = malloc(trace_len_ * sizeof(uint32_t));
+	uint32_t* free_ns = malloc(trace_len_ * sizeof(uint32_t));
+	size_t malloc_count = 0;
+	size_t free_count = 0;
+	size_t failed = 0;
+	size_t live_bytes = 0;
+	size_t slot_size[TRACE_SLOTS] = {0};
+	void* pool = malloc(POOL_SIZE);
+
+	memset(slots_, 0, sizeof(slots_));
+	a->addblock(pool, POOL_SIZE);
+
+	for(size_t i = 0; i < trace_len_; i++)
+	{
+		const trace_op_t* op = &trace_[i];
+		uint64_t start;
+
+		if(op->size)
+		{
+			if(slots_[op->slot])
+			{
+				// A malformed trace: treat it as a free followed by a malloc
+				a->free(slots_[op->slot]);
+				live_bytes -= slot_size[op->slot];
+			}
+
+			start = benchmark_now_ns();
+			slots_[op->slot] = a->malloc(op->size);
+			malloc_ns[malloc_count++] = (uint32_t)(benchmark_now_ns() - start);
+
+			if(slots_[op->slot])
+			{
+				// Touch the memory, as a real program would
+				memset(slots_[op->slot], (int)i, op->size);
+				slot_size[op->slot] = op->size;
+				live_bytes += op->size;
+			}
+			else
+			{
+				slot_size[op->slot] = 0;
+				failed++;
+			}
+		}
+		else if(slots_[op->slot])
+		{
+			start = benchmark_now_ns();
+			a->free(slots_[op->slot]);
+			free_ns[free_count++] = (uint32_t)(benchmark_now_ns() - start);
+
+			slots_[op->slot] = NULL;
+			live_bytes -= slot_size[op->slot];
+		}
+	}
+
+	print_latency(a->name, "malloc", malloc_ns, malloc_count);
+	print_latency(a->name, "free", free_ns, free_count);
+
+	// The pool is shared by live data and allocator overhead. Whatever can't be handed out
+	// as a single block is lost to fragmentation for large requests.
+	size_t largest = largest_allocatable(a);
+	size_t free_bytes = POOL_SIZE - live_bytes;
+	printf("%-16s failed allocations: %zu, live: %zu bytes, largest free block: %zu bytes "
+		   "(%.1f%% of the unused pool)\n\n",
+		   a->name, failed, live_bytes, largest, (100.0 * (double)largest) / (double)free_bytes);
+
+	// The allocators can't be reset, so each gets its own pool that is never reused
+	for(size_t i = 0; i < TRACE_SLOTS; i++)
+	{
+		a->free(slots_[i]);
+	}
+
+	free(malloc_ns);
+	free(free_ns);
+}
+
+#pragma mark - Main -
+
+int main(int argc, char* argv[])
+{
+	if(argc > 1)
+	{
+		if(trace_load(argv[1]) != 0)
+		{
+			return 1;
+		}
+	}
+	else
+	{
+		trace_generate();
+	}
+
+	printf("Replaying %zu operations\n\n", trace_len_);
+	printf("%-16s %-8s %10s %10s %8s %8s %10s\n", "allocator", "op", "count", "mean ns",
+		   "p50 ns", "p99 ns", "max ns");
+
+	for(size_t i = 0; i < ALLOCATOR_COUNT; i++)
+	{
+		replay(&allocators_[i]);
+	}
+
+	free(trace_);
+
+	return 0;
+}
@@ -0,0 +1,186 @@
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/// Measures how malloc_freelist scales with the number of threads that allocate at once.
+///
+/// Each thread runs the same loop of small allocations and frees over its own set of slots,
+/// so the threads only interact through the allocator. The reported time is per operation
+/// across all threads: if the allocator scaled perfectly, it would drop in proportion to the
+/// number of threads (up to the number of cores).
+///
+/// Three allocators are compared:
+///	- global_lock: malloc_freelist built with MALLOC_FREELIST_THREADSAFE
+///	- thread_cache: malloc_freelist built with MALLOC_FREELIST_THREAD_CACHE
+///	- system: the host's malloc, for reference
+
+void* locked_malloc(size_t size);
+void locked_free(void* ptr);
+void locked_malloc_addblock(void* addr, size_t size);
+
+void* cached_malloc(size_t size);
+void cached_free(void* ptr);
+void cached_malloc_addblock(void* addr, size_t size);
+void cached_malloc_thread_cache_flush(void);
+
+#define POOL_SIZE (64 * 1024 * 1024)
+#define OPS_PER_THREAD 200000
+#define SLOTS_PER_THREAD 64
+#define MAX_THREADS 16
+
+typedef struct
+{
+	const char* name;
+	void* (*malloc)(size_t);
+	void (*free)(void*);
+	void (*addblock)(void*, size_t);
+	void (*thread_exit)(void);
+} allocator_t;
+
+static const allocator_t allocators_[] = {
+	{"global_lock", locked_malloc, locked_free, locked_malloc_addblock, NULL},
+	{"thread_cache", cached_malloc, cached_free, cached_malloc_addblock,
+	 cached_malloc_thread_cache_flush},
+	{"system", malloc, free, NULL, NULL},
+};
+
+#define ALLOCATOR_COUNT (sizeof(allocators_) / sizeof(allocators_[0]))
+
+static const unsigned thread_counts_[] = {1, 2, 4, 8, 16};
+
+#define THREAD_COUNT_COUNT (sizeof(thread_counts_) / sizeof(thread_counts_[0]))
+
+#pragma mark - Lock Hooks -
+
+// Both malloc_freelist builds share this lock, but they never run at the same time
+static pthread_mutex_t malloc_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+
+void malloc_lock(void)
+{
+	pthread_mutex_lock(&malloc_mutex_);
+}
+
+void malloc_unlock(void)
+{
+	pthread_mutex_unlock(&malloc_mutex_);
+}
+
+#pragma mark - Workload -
+
+typedef struct
+{
+	const allocator_t* allocator;
+	uint32_t seed;
+} worker_t;
+
+static uint32_t xorshift32(uint32_t* state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+
+	return x;
+}
+
+static void* worker(void* arg)
+{
+	worker_t* w = arg;
+	const allocator_t* a = w->allocator;
+	void* slots[SLOTS_PER_THREAD] = {NULL};
+	uint32_t rng = w->seed;
+
+	for(unsigned i = 0; i < OPS_PER_THREAD; i++)
+	{
+		unsigned slot = xorshift32(&rng) % SLOTS_PER_THREAD;
+
+		if(slots[slot])
+		{
+			a->free(slots[slot]);
+			slots[slot] = NULL;
+		}
+		else
+		{
+			size_t size = 16 + (xorshift32(&rng) % 496);
+
+			slots[slot] = a->malloc(size);
+
+			if(slots[slot])
+			{
+				// Touch the memory, as a real program would
+				*(volatile char*)slots[slot] = (char)i;
+			}
+		}
+	}
+
+	for(unsigned i = 0; i < SLOTS_PER_THREAD; i++)
+	{
+		a->free(slots[i]);
+	}
+
+	if(a->thread_exit)
+	{
+		a->thread_exit();
+	}
+
+	return NULL;
+}
+
+static void run(const allocator_t* a, unsigned thread_count)
+{
+	pthread_t threads[MAX_THREADS];
+	worker_t workers[MAX_THREADS];
+	benchmark_t b;
+
+	benchmark_start(&b);
+
+	for(unsigned i = 0; i < thread_count; i++)
+	{
+		workers[i].allocator = a;
+		workers[i].seed = 0x9e3779b9U * (i + 1);
+		pthread_create(&threads[i], NULL, worker, &workers[i]);
+	}
+
+	for(unsigned i = 0; i < thread_count; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, a->name, "alloc_free", thread_count,
+					 (uint64_t)OPS_PER_THREAD * thread_count);
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	benchmark_print_header();
+
+	for(size_t i = 0; i < ALLOCATOR_COUNT; i++)
+	{
+		const allocator_t* a = &allocators_[i];
+		void* pool = NULL;
+
+		if(a->addblock)
+		{
+			pool = malloc(POOL_SIZE);
+			a->addblock(pool, POOL_SIZE);
+		}
+
+		for(size_t t = 0; t < THREAD_COUNT_COUNT; t++)
+		{
+			run(a, thread_counts_[t]);
+		}
+
+		// The pool stays registered with its allocator, so it is never returned
+		benchmark_do_not_optimize(pool);
+	}
+
+	return 0;
+}
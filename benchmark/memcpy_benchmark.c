@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/// Compares the libc memcpy() and memmove() against the host's C library over a sweep of
+/// copy sizes. The param column is the copy size in bytes.
+///
+/// Three workloads are measured:
+///	- aligned: source and destination are both 64-byte aligned
+///	- unaligned: source and destination are offset by different amounts, so they can't
+///	  both be aligned at the same time
+///	- memmove: the destination overlaps the source, one cache line above it
+///
+/// The libc versions are built with renamed symbols (see examples/libc/meson.build) so that
+/// they can be linked alongside the host's C library.
+
+void* libc_memcpy(void* __restrict dst, const void* __restrict src, size_t n);
+void* libc_memmove(void* dst, const void* src, size_t n);
+
+#define MAX_SIZE (8 * 1024 * 1024)
+#define BUFFER_SIZE (2 * MAX_SIZE + 256)
+#define BYTES_PER_MEASUREMENT (256 * 1024 * 1024)
+#define MIN_OPS 32
+#define MAX_OPS (1U << 24)
+
+static const size_t copy_sizes_[] = {
+	1, 3, 8, 15, 16, 31, 32, 48, 64, 100, 128, 256, 512, 1024, 4096, 16384, 65536, 262144,
+	1048576, 2097152, 4194304, 8388608,
+};
+
+#define COPY_SIZE_COUNT (sizeof(copy_sizes_) / sizeof(copy_sizes_[0]))
+
+#pragma mark - Implementations -
+
+typedef struct
+{
+	const char* name;
+	void* (*copy)(void* dst, const void* src, size_t n);
+	void* (*move)(void* dst, const void* src, size_t n);
+} impl_t;
+
+static const impl_t impls_[] = {
+	{"libc", libc_memcpy, libc_memmove},
+	{"host", memcpy, memmove},
+};
+
+#define IMPL_COUNT (sizeof(impls_) / sizeof(impls_[0]))
+
+#pragma mark - Workloads -
+
+static uint64_t op_count(size_t size)
+{
+	uint64_t ops = BYTES_PER_MEASUREMENT / size;
+
+	if(ops > MAX_OPS)
+	{
+		return MAX_OPS;
+	}
+
+	return (ops < MIN_OPS) ? MIN_OPS : ops;
+}
+
+static void run(const char* suite, const char* workload,
+				void* (*fn)(void* dst, const void* src, size_t n), unsigned char* dst,
+				const unsigned char* src, size_t size)
+{
+	uint64_t ops = op_count(size);
+	benchmark_t b;
+
+	// Warm up the caches and page tables, and let the libc version resolve its dispatch
+	fn(dst, src, size);
+
+	benchmark_start(&b);
+
+	for(uint64_t i = 0; i < ops; i++)
+	{
+		fn(dst, src, size);
+		benchmark_do_not_optimize(dst);
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, suite, workload, size, ops);
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	char suite[32];
+	unsigned char* src;
+	unsigned char* dst;
+	unsigned char* buffer = aligned_alloc(64, BUFFER_SIZE);
+
+	if(buffer == NULL)
+	{
+		fprintf(stderr, "Failed to allocate the copy buffers\n");
+		return 1;
+	}
+
+	memset(buffer, 0x5A, BUFFER_SIZE);
+	src = buffer;
+	dst = buffer + MAX_SIZE + 128;
+
+	benchmark_print_header();
+
+	for(size_t s = 0; s < COPY_SIZE_COUNT; s++)
+	{
+		size_t size = copy_sizes_[s];
+
+		for(size_t i = 0; i < IMPL_COUNT; i++)
+		{
+			snprintf(suite, sizeof(suite), "%s_memcpy", impls_[i].name);
+			run(suite, "aligned", impls_[i].copy, dst, src, size);
+			run(suite, "unaligned", impls_[i].copy, dst + 3, src + 17, size);
+
+			snprintf(suite, sizeof(suite), "%s_memmove", impls_[i].name);
+			run(suite, "memmove", impls_[i].move, src + 64, src, size);
+		}
+	}
+
+	free(buffer);
+
+	return 0;
+}
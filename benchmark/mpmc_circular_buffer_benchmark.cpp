@@ -0,0 +1,124 @@
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "benchmark.h"
+#include "circular_buffer/mpmc_circular_buffer.hpp"
+
+/// Compares mpmc_circular_buffer against a std::queue protected by a mutex, which is what
+/// dispatch.cpp and activeObject use today. Each measurement runs the same number of producer
+/// and consumer threads, and the reported time is per item transferred.
+
+namespace
+{
+constexpr uint32_t kItemCount = 1U << 20;
+constexpr size_t kQueueSize = 1024;
+constexpr unsigned kThreadCounts[] = {1, 2, 4, 8};
+
+class locked_queue
+{
+  public:
+	bool put(uint32_t item)
+	{
+		std::lock_guard<std::mutex> lock(lock_);
+		q_.push(item);
+		return true;
+	}
+
+	std::optional<uint32_t> get()
+	{
+		std::lock_guard<std::mutex> lock(lock_);
+
+		if(q_.empty())
+		{
+			return std::nullopt;
+		}
+
+		auto val = q_.front();
+		q_.pop();
+		return val;
+	}
+
+  private:
+	std::mutex lock_;
+	std::queue<uint32_t> q_;
+};
+
+template<class TQueue>
+void run(TQueue& q, const char* suite, unsigned thread_pairs)
+{
+	const uint32_t items_per_producer = kItemCount / thread_pairs;
+	const uint32_t total = items_per_producer * thread_pairs;
+	std::atomic<uint32_t> consumed{0};
+	std::atomic<uint64_t> sum{0};
+	std::vector<std::thread> threads;
+	benchmark_t b;
+
+	benchmark_start(&b);
+
+	for(unsigned p = 0; p < thread_pairs; p++)
+	{
+		threads.emplace_back([&q, items_per_producer] {
+			for(uint32_t i = 0; i < items_per_producer; i++)
+			{
+				while(!q.put(i))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+
+		threads.emplace_back([&q, &consumed, &sum, total] {
+			uint64_t local_sum = 0;
+
+			while(consumed.load(std::memory_order_relaxed) < total)
+			{
+				auto value = q.get();
+				if(value.has_value())
+				{
+					local_sum += value.value();
+					consumed.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+
+			sum.fetch_add(local_sum, std::memory_order_relaxed);
+		});
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	benchmark_stop(&b);
+	benchmark_do_not_optimize(&sum);
+	benchmark_report(&b, suite, "transfer", thread_pairs, total);
+}
+} // namespace
+
+int main(void)
+{
+	benchmark_print_header();
+
+	for(auto thread_pairs : kThreadCounts)
+	{
+		mpmc_circular_buffer<uint32_t, kQueueSize> q;
+		run(q, "mpmc_circular_buffer", thread_pairs);
+	}
+
+	for(auto thread_pairs : kThreadCounts)
+	{
+		locked_queue q;
+		run(q, "std::queue + std::mutex", thread_pairs);
+	}
+
+	return 0;
+}
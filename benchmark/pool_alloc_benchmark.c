@@ -0,0 +1,163 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "malloc/pool_alloc.h"
+
+/// Compares the fixed-size pool allocator against the general-purpose free-list allocators
+/// for small objects. The param column is the object size in bytes.
+///
+/// Two workloads are measured:
+///	- alloc_free: allocate one object and free it right away
+///	- batch: allocate BATCH_COUNT objects, then free them all in reverse order
+///
+/// The free-list allocators are built with renamed symbols (see meson.build) so that they can
+/// be linked alongside the host's malloc.
+
+void* freelist_malloc(size_t size);
+void freelist_free(void* ptr);
+void freelist_malloc_addblock(void* addr, size_t size);
+
+void* fl_malloc(size_t size);
+void fl_free(void* ptr);
+void fl_addblock(void* addr, size_t size);
+
+#define REGION_SIZE (1024 * 1024)
+#define BATCH_COUNT 256
+#define ALLOC_FREE_OPS (1U << 20)
+#define BATCH_ROUNDS 1024
+
+static const size_t object_sizes_[] = {32, 64, 256};
+
+#define OBJECT_SIZE_COUNT (sizeof(object_sizes_) / sizeof(object_sizes_[0]))
+
+static pool_t pool_;
+static size_t object_size_;
+static void* batch_[BATCH_COUNT];
+
+#pragma mark - Allocators -
+
+// All allocators are called through the same signature: pools have a fixed size,
+// so they ignore the size argument
+typedef struct
+{
+	const char* name;
+	void* (*alloc)(void);
+	void (*free)(void*);
+} allocator_t;
+
+static void* pool_alloc_fn(void)
+{
+	return pool_alloc(&pool_);
+}
+
+static void pool_free_fn(void* ptr)
+{
+	pool_free(&pool_, ptr);
+}
+
+static void* pool_alloc_lockfree_fn(void)
+{
+	return pool_alloc_lockfree(&pool_);
+}
+
+static void pool_free_lockfree_fn(void* ptr)
+{
+	pool_free_lockfree(&pool_, ptr);
+}
+
+static void* freelist_alloc_fn(void)
+{
+	return freelist_malloc(object_size_);
+}
+
+static void* fl_alloc_fn(void)
+{
+	return fl_malloc(object_size_);
+}
+
+static const allocator_t allocators_[] = {
+	{"pool_alloc", pool_alloc_fn, pool_free_fn},
+	{"pool_alloc_lockfree", pool_alloc_lockfree_fn, pool_free_lockfree_fn},
+	{"malloc_freelist", freelist_alloc_fn, freelist_free},
+	{"fl_malloc", fl_alloc_fn, fl_free},
+};
+
+#define ALLOCATOR_COUNT (sizeof(allocators_) / sizeof(allocators_[0]))
+
+#pragma mark - Workloads -
+
+static void run_alloc_free(const allocator_t* a)
+{
+	benchmark_t b;
+
+	benchmark_start(&b);
+
+	for(uint32_t i = 0; i < ALLOC_FREE_OPS; i++)
+	{
+		void* p = a->alloc();
+		benchmark_do_not_optimize(p);
+		a->free(p);
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, a->name, "alloc_free", object_size_, ALLOC_FREE_OPS);
+}
+
+static void run_batch(const allocator_t* a)
+{
+	benchmark_t b;
+
+	benchmark_start(&b);
+
+	for(uint32_t r = 0; r < BATCH_ROUNDS; r++)
+	{
+		for(uint32_t i = 0; i < BATCH_COUNT; i++)
+		{
+			batch_[i] = a->alloc();
+			benchmark_do_not_optimize(batch_[i]);
+		}
+
+		for(uint32_t i = BATCH_COUNT; i > 0; i--)
+		{
+			a->free(batch_[i - 1]);
+		}
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, a->name, "batch", object_size_,
+					 (uint64_t)BATCH_ROUNDS * BATCH_COUNT);
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	void* region = malloc(REGION_SIZE);
+
+	freelist_malloc_addblock(malloc(REGION_SIZE), REGION_SIZE);
+	fl_addblock(malloc(REGION_SIZE), REGION_SIZE);
+
+	benchmark_print_header();
+
+	for(size_t s = 0; s < OBJECT_SIZE_COUNT; s++)
+	{
+		object_size_ = object_sizes_[s];
+
+		if(pool_init(&pool_, region, REGION_SIZE, object_size_, 0) != 0)
+		{
+			fprintf(stderr, "Failed to initialize a pool of %zu byte objects\n", object_size_);
+			return 1;
+		}
+
+		for(size_t i = 0; i < ALLOCATOR_COUNT; i++)
+		{
+			run_alloc_free(&allocators_[i]);
+			run_batch(&allocators_[i]);
+		}
+	}
+
+	free(region);
+
+	return 0;
+}
@@ -0,0 +1,131 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+
+/// Measures how qsort_parallel() scales from 1 to 32 threads, on 4M 16-byte records with a
+/// random key. The libc qsort_r(), which qsort_parallel() uses to sort each run, is the
+/// baseline. The param column is the number of threads, and times are per element.
+///
+/// The array is refilled before each sort, outside of the measured region. Thread creation is
+/// part of qsort_parallel(), so it is measured.
+///
+/// The libc sorting functions are built with renamed symbols (see examples/libc/meson.build)
+/// so that they can be linked alongside the host's C library.
+
+void libc_qsort_r(void* a, size_t n, size_t es, void* thunk,
+				  int (*cmp)(void*, const void*, const void*));
+void libc_qsort_parallel(void* base, size_t n, size_t es,
+						 int (*cmp)(void*, const void*, const void*), void* thunk,
+						 unsigned nthreads);
+
+#define COUNT (4 * 1024 * 1024)
+#define PASSES 3
+
+static const unsigned thread_counts_[] = {1, 2, 4, 8, 16, 32};
+
+#define THREAD_COUNT_COUNT (sizeof(thread_counts_) / sizeof(thread_counts_[0]))
+
+typedef struct
+{
+	uint32_t key;
+	uint32_t id;
+	uint64_t payload;
+} record_t;
+
+static int compare_record(void* thunk, const void* a, const void* b)
+{
+	uint32_t x = ((const record_t*)a)->key;
+	uint32_t y = ((const record_t*)b)->key;
+
+	(void)thunk;
+
+	return (x > y) - (x < y);
+}
+
+static void fill(record_t* v, size_t pass)
+{
+	uint32_t random = (uint32_t)(COUNT + pass * 2654435761U);
+
+	for(size_t i = 0; i < COUNT; i++)
+	{
+		random = random * 1103515245 + 12345;
+		v[i] = (record_t){random, (uint32_t)i, i};
+	}
+}
+
+static int is_sorted(const record_t* v)
+{
+	for(size_t i = 1; i < COUNT; i++)
+	{
+		if(v[i - 1].key > v[i].key)
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/// Sort with qsort_parallel() on threads threads, or with qsort_r() if threads is 0
+static void run(record_t* v, unsigned threads)
+{
+	const char* name = (threads == 0) ? "libc_qsort_r" : "qsort_parallel";
+	benchmark_t total = {0};
+
+	for(size_t pass = 0; pass < PASSES; pass++)
+	{
+		benchmark_t b;
+
+		fill(v, pass);
+		benchmark_start(&b);
+
+		if(threads == 0)
+		{
+			libc_qsort_r(v, COUNT, sizeof(record_t), NULL, compare_record);
+		}
+		else
+		{
+			libc_qsort_parallel(v, COUNT, sizeof(record_t), compare_record, NULL, threads);
+		}
+
+		benchmark_stop(&b);
+		benchmark_do_not_optimize(v);
+
+		total.elapsed_ns += b.elapsed_ns;
+		total.cache_misses += b.cache_misses;
+		total.cache_misses_valid = b.cache_misses_valid;
+	}
+
+	if(!is_sorted(v))
+	{
+		fprintf(stderr, "%s with %u threads didn't sort the array\n", name, threads);
+		exit(1);
+	}
+
+	benchmark_report(&total, name, "record_random", (threads == 0) ? 1 : threads,
+					 (uint64_t)PASSES * COUNT);
+}
+
+int main(void)
+{
+	record_t* v = malloc(COUNT * sizeof(record_t));
+
+	if(v == NULL)
+	{
+		fprintf(stderr, "Failed to allocate the array\n");
+		return 1;
+	}
+
+	benchmark_print_header();
+	run(v, 0);
+
+	for(size_t i = 0; i < THREAD_COUNT_COUNT; i++)
+	{
+		run(v, thread_counts_[i]);
+	}
+
+	free(v);
+
+	return 0;
+}
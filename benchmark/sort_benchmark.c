@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "benchmark.h"
+#include "pdqsort.h"
+
+/// Compares QSORT_DEFINE() (examples/libc/stdlib/pdqsort.h) against the libc qsort() and the
+/// host's C library qsort(), on arrays of 10^3 to 10^7 elements. The param column is the number
+/// of elements, and times are per element.
+///
+/// Three workloads are measured:
+///	- int_random: random ints
+///	- int_sorted: ints that are already sorted, except for one element in a thousand
+///	- record_random: 16-byte records with a random key
+///
+/// Arrays are refilled before each sort, outside of the measured region.
+///
+/// The libc qsort() is built with a renamed symbol (see examples/libc/meson.build) so that it
+/// can be linked alongside the host's C library.
+
+void libc_qsort(void* a, size_t n, size_t es, int (*compar)(const void*, const void*));
+
+#define MAX_COUNT 10000000
+#define ELEMENTS_PER_MEASUREMENT 10000000
+
+static const size_t counts_[] = {1000, 10000, 100000, 1000000, 10000000};
+
+#define COUNT_COUNT (sizeof(counts_) / sizeof(counts_[0]))
+
+typedef struct
+{
+	uint32_t key;
+	uint32_t id;
+	uint64_t payload;
+} record_t;
+
+#define int_less(a, b) ((a) < (b))
+#define record_less(a, b) ((a).key < (b).key)
+
+QSORT_DEFINE(pdq_sort_int, int, int_less)
+QSORT_DEFINE(pdq_sort_record, record_t, record_less)
+
+#pragma mark - Implementations -
+
+static int compare_int(const void* a, const void* b)
+{
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+
+	return (x > y) - (x < y);
+}
+
+static int compare_record(const void* a, const void* b)
+{
+	uint32_t x = ((const record_t*)a)->key;
+	uint32_t y = ((const record_t*)b)->key;
+
+	return (x > y) - (x < y);
+}
+
+static void libc_sort_int(int* v, size_t n)
+{
+	libc_qsort(v, n, sizeof(int), compare_int);
+}
+
+static void libc_sort_record(record_t* v, size_t n)
+{
+	libc_qsort(v, n, sizeof(record_t), compare_record);
+}
+
+static void host_sort_int(int* v, size_t n)
+{
+	qsort(v, n, sizeof(int), compare_int);
+}
+
+static void host_sort_record(record_t* v, size_t n)
+{
+	qsort(v, n, sizeof(record_t), compare_record);
+}
+
+typedef struct
+{
+	const char* name;
+	void (*sort_int)(int* v, size_t n);
+	void (*sort_record)(record_t* v, size_t n);
+} impl_t;
+
+static const impl_t impls_[] = {
+	{"libc_qsort", libc_sort_int, libc_sort_record},
+	{"host_qsort", host_sort_int, host_sort_record},
+	{"pdqsort", pdq_sort_int, pdq_sort_record},
+};
+
+#define IMPL_COUNT (sizeof(impls_) / sizeof(impls_[0]))
+
+#pragma mark - Workloads -
+
+typedef enum
+{
+	WORKLOAD_INT_RANDOM,
+	WORKLOAD_INT_SORTED,
+	WORKLOAD_RECORD_RANDOM,
+	WORKLOAD_COUNT
+} workload_t;
+
+static const char* workload_names_[WORKLOAD_COUNT] = {"int_random", "int_sorted",
+													  "record_random"};
+
+/// Fill the array with the same values for every implementation. Each pass gets different
+/// values, so that the branch predictor can't learn a small array.
+static void fill(void* v, size_t n, workload_t workload, size_t pass)
+{
+	uint32_t random = (uint32_t)(n + pass * 2654435761U);
+
+	for(size_t i = 0; i < n; i++)
+	{
+		random = random * 1103515245 + 12345;
+
+		switch(workload)
+		{
+			case WORKLOAD_INT_RANDOM:
+				((int*)v)[i] = (int)random;
+				break;
+			case WORKLOAD_INT_SORTED:
+				((int*)v)[i] = (i % 1000 == 999) ? (int)random : (int)i;
+				break;
+			case WORKLOAD_RECORD_RANDOM:
+			default:
+				((record_t*)v)[i] = (record_t){random, (uint32_t)i, i};
+				break;
+		}
+	}
+}
+
+static int is_sorted(const void* v, size_t n, workload_t workload)
+{
+	for(size_t i = 1; i < n; i++)
+	{
+		if(workload == WORKLOAD_RECORD_RANDOM ?
+			   ((const record_t*)v)[i - 1].key > ((const record_t*)v)[i].key :
+			   ((const int*)v)[i - 1] > ((const int*)v)[i])
+		{
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static void run(const impl_t* impl, workload_t workload, void* v, size_t n)
+{
+	size_t passes = (n < ELEMENTS_PER_MEASUREMENT) ? ELEMENTS_PER_MEASUREMENT / n : 1;
+	benchmark_t total = {0};
+
+	for(size_t pass = 0; pass < passes; pass++)
+	{
+		benchmark_t b;
+
+		fill(v, n, workload, pass);
+		benchmark_start(&b);
+
+		if(workload == WORKLOAD_RECORD_RANDOM)
+		{
+			impl->sort_record(v, n);
+		}
+		else
+		{
+			impl->sort_int(v, n);
+		}
+
+		benchmark_stop(&b);
+		benchmark_do_not_optimize(v);
+
+		total.elapsed_ns += b.elapsed_ns;
+		total.cache_misses += b.cache_misses;
+		total.cache_misses_valid = b.cache_misses_valid;
+	}
+
+	if(!is_sorted(v, n, workload))
+	{
+		fprintf(stderr, "%s: %s with %zu elements isn't sorted\n", impl->name,
+				workload_names_[workload], n);
+		exit(1);
+	}
+
+	benchmark_report(&total, impl->name, workload_names_[workload], n, (uint64_t)(passes * n));
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	void* v = malloc(MAX_COUNT * sizeof(record_t));
+
+	if(v == NULL)
+	{
+		fprintf(stderr, "Failed to allocate the array\n");
+		return 1;
+	}
+
+	benchmark_print_header();
+
+	for(int workload = 0; workload < WORKLOAD_COUNT; workload++)
+	{
+		for(size_t c = 0; c < COUNT_COUNT; c++)
+		{
+			for(size_t i = 0; i < IMPL_COUNT; i++)
+			{
+				run(&impls_[i], (workload_t)workload, v, counts_[c]);
+			}
+		}
+	}
+
+	free(v);
+
+	return 0;
+}
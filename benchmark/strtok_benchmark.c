@@ -0,0 +1,276 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/// Compares the libc strtok_r() and strcspn() against the host's C library, and against the
+/// nested-loop scan that strtok_r() used before the delimiter bitmap, by tokenizing a
+/// generated CSV file. The param column is the number of delimiter characters. The first two
+/// are ',' and '\n', which occur in the file, and the rest don't, so they only make the set
+/// larger. Times are per field.
+///
+/// Two workloads are measured:
+///	- strtok_r: split the whole file into fields. The file is restored with memcpy() before
+///	  each pass, which is included in the time for every implementation.
+///	- strcspn: walk the fields with s += strcspn(s, delim) + 1, without modifying the file
+///
+/// The libc versions are built with renamed symbols (see examples/libc/meson.build) so that
+/// they can be linked alongside the host's C library.
+
+char* libc_strtok_r(char* s, const char* delim, char** last);
+size_t libc_strcspn(const char* s, const char* reject);
+
+#define CSV_SIZE (1024 * 1024)
+#define PASSES 16
+
+/// Delimiters, in the order that they are added to the set
+static const char delimiters_[] = ",\n;|\t:#@!~^&*$%?";
+
+static const size_t delimiter_counts_[] = {1, 2, 4, 8, 16};
+
+#define DELIMITER_COUNT_COUNT (sizeof(delimiter_counts_) / sizeof(delimiter_counts_[0]))
+
+static char csv_[CSV_SIZE + 1];
+static char buffer_[CSV_SIZE + 1];
+
+#pragma mark - Implementations -
+
+/// The scan that strtok_r() used before the delimiter bitmap, which compares each byte of the
+/// string against each delimiter
+static char* naive_strtok_r(char* s, const char* delim, char** last)
+{
+	const char* spanp;
+	char* tok;
+	int c;
+	int sc;
+
+	if(s == NULL && (s = *last) == NULL)
+	{
+		return NULL;
+	}
+
+cont:
+	c = *s++;
+
+	for(spanp = delim; (sc = *spanp++) != 0;)
+	{
+		if(c == sc)
+		{
+			goto cont;
+		}
+	}
+
+	if(c == 0)
+	{
+		*last = NULL;
+		return NULL;
+	}
+
+	tok = s - 1;
+
+	for(;;)
+	{
+		c = *s++;
+		spanp = delim;
+
+		do
+		{
+			if((sc = *spanp++) == c)
+			{
+				if(c == 0)
+				{
+					s = NULL;
+				}
+				else
+				{
+					s[-1] = '\0';
+				}
+
+				*last = s;
+				return tok;
+			}
+		} while(sc != 0);
+	}
+}
+
+static size_t naive_strcspn(const char* s, const char* reject)
+{
+	const char* p = s;
+
+	for(; *p != '\0'; p++)
+	{
+		for(const char* r = reject; *r != '\0'; r++)
+		{
+			if(*p == *r)
+			{
+				return (size_t)(p - s);
+			}
+		}
+	}
+
+	return (size_t)(p - s);
+}
+
+typedef struct
+{
+	const char* name;
+	char* (*strtok_r_fn)(char* s, const char* delim, char** last);
+	size_t (*strcspn_fn)(const char* s, const char* reject);
+} impl_t;
+
+static const impl_t impls_[] = {
+	{"libc", libc_strtok_r, libc_strcspn},
+	{"host", strtok_r, strcspn},
+	{"naive", naive_strtok_r, naive_strcspn},
+};
+
+#define IMPL_COUNT (sizeof(impls_) / sizeof(impls_[0]))
+
+#pragma mark - Workloads -
+
+/// Fill the file with rows of a timestamp, a sensor name, a reading, and a status
+static void make_csv(void)
+{
+	static const char* names[] = {"temperature", "pressure", "humidity", "voltage", "current"};
+	static const char* statuses[] = {"ok", "warn", "error"};
+	uint32_t random = 1;
+	size_t i = 0;
+
+	while(i < CSV_SIZE)
+	{
+		char row[96];
+		int length;
+
+		random = random * 1103515245 + 12345;
+		length = snprintf(row, sizeof(row), "%zu,%s,%u.%02u,%s\n", i, names[(random >> 16) % 5],
+						  (random >> 8) % 1000, random % 100, statuses[(random >> 20) % 3]);
+
+		for(int k = 0; k < length && i < CSV_SIZE; k++)
+		{
+			csv_[i++] = row[k];
+		}
+	}
+
+	csv_[CSV_SIZE] = '\0';
+}
+
+static uint64_t tokenize(const impl_t* impl, const char* delim)
+{
+	uint64_t fields = 0;
+	char* last = NULL;
+
+	memcpy(buffer_, csv_, sizeof(csv_));
+
+	for(char* tok = impl->strtok_r_fn(buffer_, delim, &last); tok != NULL;
+		tok = impl->strtok_r_fn(NULL, delim, &last))
+	{
+		benchmark_do_not_optimize(tok);
+		fields++;
+	}
+
+	return fields;
+}
+
+static uint64_t walk(const impl_t* impl, const char* delim)
+{
+	uint64_t fields = 0;
+	const char* s = csv_;
+
+	for(;;)
+	{
+		s += impl->strcspn_fn(s, delim);
+		fields++;
+
+		if(*s == '\0')
+		{
+			break;
+		}
+
+		s++;
+	}
+
+	benchmark_do_not_optimize(s);
+
+	return fields;
+}
+
+static void run(const impl_t* impl, size_t delimiter_count)
+{
+	char delim[sizeof(delimiters_)];
+	uint64_t fields = 0;
+	benchmark_t b;
+
+	memcpy(delim, delimiters_, delimiter_count);
+	delim[delimiter_count] = '\0';
+
+	benchmark_start(&b);
+
+	for(unsigned pass = 0; pass < PASSES; pass++)
+	{
+		fields += tokenize(impl, delim);
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, impl->name, "strtok_r", delimiter_count, fields);
+
+	fields = 0;
+	benchmark_start(&b);
+
+	for(unsigned pass = 0; pass < PASSES; pass++)
+	{
+		fields += walk(impl, delim);
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, impl->name, "strcspn", delimiter_count, fields);
+}
+
+/// Every implementation must find the same fields
+static int check(size_t delimiter_count)
+{
+	char delim[sizeof(delimiters_)];
+
+	memcpy(delim, delimiters_, delimiter_count);
+	delim[delimiter_count] = '\0';
+
+	for(size_t i = 1; i < IMPL_COUNT; i++)
+	{
+		if(tokenize(&impls_[i], delim) != tokenize(&impls_[0], delim) ||
+		   walk(&impls_[i], delim) != walk(&impls_[0], delim))
+		{
+			fprintf(stderr, "%s: wrong field count with %zu delimiters\n", impls_[i].name,
+					delimiter_count);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	make_csv();
+	benchmark_print_header();
+
+	for(size_t d = 0; d < DELIMITER_COUNT_COUNT; d++)
+	{
+		if(!check(delimiter_counts_[d]))
+		{
+			return 1;
+		}
+
+		for(size_t i = 0; i < IMPL_COUNT; i++)
+		{
+			run(&impls_[i], delimiter_counts_[d]);
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,227 @@
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "benchmark.h"
+
+/// Compares the libc strstr() and memmem() against the host's C library, and against a
+/// naive first-byte search, over a sweep of needle lengths. The param column is the needle
+/// length in bytes. Every haystack is HAYSTACK_SIZE bytes, and the needle only matches at its
+/// end, so each call scans the whole haystack.
+///
+/// Three workloads are measured:
+///	- text: words from a small vocabulary, searched for a phrase of them
+///	- adversarial: "aaa...a" searched for "aa...ab", where every position matches all but
+///	  the last byte of the needle
+///	- periodic: "aaab" repeated, with a needle made of the same period
+///
+/// For a linear-time search, the adversarial time per call stays flat as the needle grows.
+/// The naive search is quadratic there, so it is only run for short needles.
+///
+/// The libc versions are built with renamed symbols (see examples/libc/meson.build) so that
+/// they can be linked alongside the host's C library.
+
+char* libc_strstr(const char* string, const char* substring);
+void* libc_memmem(const void* l, size_t l_len, const void* s, size_t s_len);
+
+#define HAYSTACK_SIZE (256 * 1024)
+#define MAX_NEEDLE 4096
+#define NAIVE_MAX_NEEDLE 64
+#define OPS 64
+
+static const size_t needle_lengths_[] = {2, 4, 8, 16, 32, 64, 256, 1024, 4096};
+
+#define NEEDLE_LENGTH_COUNT (sizeof(needle_lengths_) / sizeof(needle_lengths_[0]))
+
+static char haystack_[HAYSTACK_SIZE + 1];
+static char needle_[MAX_NEEDLE + 1];
+
+#pragma mark - Implementations -
+
+/// The search that memmem() used before the Two-Way version
+static void* naive_memmem(const void* l, size_t l_len, const void* s, size_t s_len)
+{
+	const char* cur = l;
+	const char* last = cur + l_len - s_len;
+
+	for(; cur <= last; cur++)
+	{
+		if(cur[0] == *(const char*)s && memcmp(cur, s, s_len) == 0)
+		{
+			return (void*)cur;
+		}
+	}
+
+	return NULL;
+}
+
+static char* naive_strstr(const char* string, const char* substring)
+{
+	return naive_memmem(string, strlen(string), substring, strlen(substring));
+}
+
+typedef struct
+{
+	const char* name;
+	char* (*strstr_fn)(const char* string, const char* substring);
+	void* (*memmem_fn)(const void* l, size_t l_len, const void* s, size_t s_len);
+} impl_t;
+
+static const impl_t impls_[] = {
+	{"libc", libc_strstr, libc_memmem},
+	{"host", strstr, memmem},
+	{"naive", naive_strstr, naive_memmem},
+};
+
+#define IMPL_COUNT (sizeof(impls_) / sizeof(impls_[0]))
+
+#pragma mark - Workloads -
+
+/// Fill the haystack with words, and put the needle (a phrase of them) at its end
+static void make_text(size_t needle_length)
+{
+	static const char* words[] = {"error ", "warn ", "info ", "debug ", "timeout ",
+								  "retry ", "socket ", "disk ", "sensor ", "ok "};
+	const size_t word_count = sizeof(words) / sizeof(words[0]);
+	uint32_t random = 1;
+	size_t i = 0;
+
+	while(i < HAYSTACK_SIZE)
+	{
+		const char* word;
+
+		random = random * 1103515245 + 12345;
+		word = words[(random >> 16) % word_count];
+
+		for(size_t k = 0; word[k] != '\0' && i < HAYSTACK_SIZE; k++)
+		{
+			haystack_[i++] = word[k];
+		}
+	}
+
+	// The phrase is made of the same words, but in upper case, so it only matches at the end
+	for(size_t k = 0; k < needle_length; k++)
+	{
+		char c = haystack_[k];
+
+		needle_[k] = (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+	}
+
+	memcpy(haystack_ + HAYSTACK_SIZE - needle_length, needle_, needle_length);
+}
+
+static void make_adversarial(size_t needle_length)
+{
+	memset(haystack_, 'a', HAYSTACK_SIZE);
+	memset(needle_, 'a', needle_length);
+	needle_[needle_length - 1] = 'b';
+	haystack_[HAYSTACK_SIZE - 1] = 'b';
+}
+
+static void make_periodic(size_t needle_length)
+{
+	for(size_t i = 0; i < HAYSTACK_SIZE; i++)
+	{
+		haystack_[i] = (i % 4 == 3) ? 'b' : 'a';
+	}
+
+	for(size_t i = 0; i < needle_length; i++)
+	{
+		needle_[i] = (i % 4 == 3) ? 'b' : 'a';
+	}
+
+	// Break the period in the haystack, except for the match at the end
+	for(size_t i = 511; i < HAYSTACK_SIZE - needle_length; i += 512)
+	{
+		haystack_[i] = 'a';
+	}
+
+	needle_[needle_length - 1] = 'c';
+	haystack_[HAYSTACK_SIZE - 1] = 'c';
+}
+
+static void run(const impl_t* impl, const char* workload, size_t needle_length)
+{
+	uint64_t ops = OPS;
+	const char* expected = haystack_ + HAYSTACK_SIZE - needle_length;
+	char suite[32];
+	benchmark_t b;
+
+	haystack_[HAYSTACK_SIZE] = '\0';
+	needle_[needle_length] = '\0';
+
+	if(impl->strstr_fn(haystack_, needle_) != expected ||
+	   impl->memmem_fn(haystack_, HAYSTACK_SIZE, needle_, needle_length) != expected)
+	{
+		fprintf(stderr, "%s: wrong result for %s, needle length %zu\n", impl->name, workload,
+				needle_length);
+		exit(1);
+	}
+
+	snprintf(suite, sizeof(suite), "%s_strstr", impl->name);
+	benchmark_start(&b);
+
+	for(uint64_t i = 0; i < ops; i++)
+	{
+		benchmark_do_not_optimize(impl->strstr_fn(haystack_, needle_));
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, suite, workload, needle_length, ops);
+
+	snprintf(suite, sizeof(suite), "%s_memmem", impl->name);
+	benchmark_start(&b);
+
+	for(uint64_t i = 0; i < ops; i++)
+	{
+		benchmark_do_not_optimize(
+			impl->memmem_fn(haystack_, HAYSTACK_SIZE, needle_, needle_length));
+	}
+
+	benchmark_stop(&b);
+	benchmark_report(&b, suite, workload, needle_length, ops);
+}
+
+#pragma mark - Main -
+
+int main(void)
+{
+	static const struct
+	{
+		const char* name;
+		void (*make)(size_t needle_length);
+	} workloads[] = {
+		{"text", make_text},
+		{"adversarial", make_adversarial},
+		{"periodic", make_periodic},
+	};
+
+	benchmark_print_header();
+
+	for(size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++)
+	{
+		for(size_t n = 0; n < NEEDLE_LENGTH_COUNT; n++)
+		{
+			size_t needle_length = needle_lengths_[n];
+
+			workloads[w].make(needle_length);
+
+			for(size_t i = 0; i < IMPL_COUNT; i++)
+			{
+				if(impls_[i].memmem_fn == naive_memmem && w > 0 &&
+				   needle_length > NAIVE_MAX_NEEDLE)
+				{
+					continue;
+				}
+
+				run(&impls_[i], workloads[w].name, needle_length);
+			}
+		}
+	}
+
+	return 0;
+}
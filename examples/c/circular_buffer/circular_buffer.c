@@ -1,6 +1,7 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 #include <assert.h>
 
 #include "circular_buffer.h"
@@ -11,7 +12,8 @@ struct circular_buf_t
 	uint8_t* buffer;
 	size_t head;
 	size_t tail;
-	size_t max; // of the buffer
+	size_t max; // of the buffer, in elements
+	size_t elem_size; // in bytes
 	bool full;
 };
 
@@ -22,6 +24,57 @@ static inline size_t advance_headtail_value(size_t value, size_t max)
 	return (value + 1) % max;
 }
 
+static inline size_t advance_headtail_value_by(size_t value, size_t n, size_t max)
+{
+	return (value + n) % max;
+}
+
+static inline uint8_t* elem_ptr(cbuf_handle_t me, size_t pos)
+{
+	return &me->buffer[pos * me->elem_size];
+}
+
+/// Copy a single element. Byte buffers skip the memcpy call.
+static inline void copy_elem(cbuf_handle_t me, void* dst, const void* src)
+{
+	if(me->elem_size == 1)
+	{
+		*(uint8_t*)dst = *(const uint8_t*)src;
+	}
+	else
+	{
+		memcpy(dst, src, me->elem_size);
+	}
+}
+
+/// Copy len elements into the buffer starting at pos, wrapping around the end of the buffer
+static void copy_to_buffer(cbuf_handle_t me, size_t pos, const uint8_t* data, size_t len)
+{
+	size_t first = me->max - pos;
+
+	if(first > len)
+	{
+		first = len;
+	}
+
+	memcpy(elem_ptr(me, pos), data, first * me->elem_size);
+	memcpy(me->buffer, data + (first * me->elem_size), (len - first) * me->elem_size);
+}
+
+/// Copy len elements out of the buffer starting at pos, wrapping around the end of the buffer
+static void copy_from_buffer(cbuf_handle_t me, size_t pos, uint8_t* data, size_t len)
+{
+	size_t first = me->max - pos;
+
+	if(first > len)
+	{
+		first = len;
+	}
+
+	memcpy(data, elem_ptr(me, pos), first * me->elem_size);
+	memcpy(data + (first * me->elem_size), me->buffer, (len - first) * me->elem_size);
+}
+
 static void advance_head_pointer(cbuf_handle_t me)
 {
 	assert(me);
@@ -39,13 +92,19 @@ static void advance_head_pointer(cbuf_handle_t me)
 
 cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size)
 {
-	assert(buffer && size);
+	return circular_buf_init_elem(buffer, size, 1);
+}
+
+cbuf_handle_t circular_buf_init_elem(void* buffer, size_t elem_count, size_t elem_size)
+{
+	assert(buffer && elem_count && elem_size);
 
 	cbuf_handle_t cbuf = malloc(sizeof(circular_buf_t));
 	assert(cbuf);
 
 	cbuf->buffer = buffer;
-	cbuf->max = size;
+	cbuf->max = elem_count;
+	cbuf->elem_size = elem_size;
 	circular_buf_reset(cbuf);
 
 	assert(circular_buf_empty(cbuf));
@@ -98,22 +157,36 @@ size_t circular_buf_capacity(cbuf_handle_t me)
 
 void circular_buf_put(cbuf_handle_t me, uint8_t data)
 {
-	assert(me && me->buffer);
+	assert(me && me->elem_size == 1);
+
+	circular_buf_put_elem(me, &data);
+}
+
+int circular_buf_try_put(cbuf_handle_t me, uint8_t data)
+{
+	assert(me && me->elem_size == 1);
 
-	me->buffer[me->head] = data;
+	return circular_buf_try_put_elem(me, &data);
+}
+
+void circular_buf_put_elem(cbuf_handle_t me, const void* data)
+{
+	assert(me && data && me->buffer);
+
+	copy_elem(me, elem_ptr(me, me->head), data);
 
 	advance_head_pointer(me);
 }
 
-int circular_buf_try_put(cbuf_handle_t me, uint8_t data)
+int circular_buf_try_put_elem(cbuf_handle_t me, const void* data)
 {
 	int r = -1;
 
-	assert(me && me->buffer);
+	assert(me && data && me->buffer);
 
 	if(!circular_buf_full(me))
 	{
-		me->buffer[me->head] = data;
+		copy_elem(me, elem_ptr(me, me->head), data);
 		advance_head_pointer(me);
 		r = 0;
 	}
@@ -121,7 +194,7 @@ int circular_buf_try_put(cbuf_handle_t me, uint8_t data)
 	return r;
 }
 
-int circular_buf_get(cbuf_handle_t me, uint8_t* data)
+int circular_buf_get(cbuf_handle_t me, void* data)
 {
 	assert(me && data && me->buffer);
 
@@ -129,7 +202,7 @@ int circular_buf_get(cbuf_handle_t me, uint8_t* data)
 
 	if(!circular_buf_empty(me))
 	{
-		*data = me->buffer[me->tail];
+		copy_elem(me, data, elem_ptr(me, me->tail));
 		me->tail = advance_headtail_value(me->tail, me->max);
 		me->full = false;
 		r = 0;
@@ -152,10 +225,9 @@ bool circular_buf_full(cbuf_handle_t me)
 	return me->full;
 }
 
-int circular_buf_peek(cbuf_handle_t me, uint8_t* data, unsigned int look_ahead_counter)
+int circular_buf_peek(cbuf_handle_t me, void* data, unsigned int look_ahead_counter)
 {
 	int r = -1;
-	size_t pos;
 
 	assert(me && data && me->buffer);
 
@@ -165,12 +237,105 @@ int circular_buf_peek(cbuf_handle_t me, uint8_t* data, unsigned int look_ahead_c
 		return r;
 	}
 
-	pos = me->tail;
-	for(unsigned int i = 0; i < look_ahead_counter; i++)
+	copy_from_buffer(me, me->tail, data, look_ahead_counter);
+
+	return 0;
+}
+
+int circular_buf_get_range(cbuf_handle_t me, void* data, size_t len)
+{
+	assert(me && data && me->buffer);
+
+	int r = -1;
+
+	if(len <= circular_buf_size(me))
 	{
-		data[i] = me->buffer[pos];
-		pos = advance_headtail_value(pos, me->max);
+		copy_from_buffer(me, me->tail, data, len);
+
+		if(len)
+		{
+			me->tail = advance_headtail_value_by(me->tail, len, me->max);
+			me->full = false;
+		}
+		r = 0;
 	}
 
-	return 0;
+	return r;
+}
+
+int circular_buf_put_range(cbuf_handle_t me, const void* data, size_t len)
+{
+	assert(me && data && me->buffer);
+
+	int r = -1;
+
+	if(len <= circular_buf_capacity(me) - circular_buf_size(me))
+	{
+		copy_to_buffer(me, me->head, data, len);
+
+		if(len)
+		{
+			me->head = advance_headtail_value_by(me->head, len, me->max);
+			me->full = (me->head == me->tail);
+		}
+		r = 0;
+	}
+
+	return r;
+}
+
+size_t circular_buf_write_reserve(cbuf_handle_t me, uint8_t** ptr, size_t max)
+{
+	assert(me && ptr && me->buffer);
+
+	size_t len = 0;
+
+	if(!circular_buf_full(me))
+	{
+		// Free space runs either up to the tail or up to the end of the buffer
+		len = (me->head < me->tail) ? (me->tail - me->head) : (me->max - me->head);
+	}
+
+	*ptr = elem_ptr(me, me->head);
+
+	return (len < max) ? len : max;
+}
+
+void circular_buf_write_commit(cbuf_handle_t me, size_t n)
+{
+	assert(me);
+
+	if(n)
+	{
+		me->head = advance_headtail_value_by(me->head, n, me->max);
+		me->full = (me->head == me->tail);
+	}
+}
+
+size_t circular_buf_read_peek_contiguous(cbuf_handle_t me, const uint8_t** ptr)
+{
+	assert(me && ptr && me->buffer);
+
+	size_t len = 0;
+
+	if(!circular_buf_empty(me))
+	{
+		// If the data wraps, only the segment up to the end of the buffer is contiguous
+		len = (me->tail < me->head) ? (me->head - me->tail) : (me->max - me->tail);
+	}
+
+	*ptr = elem_ptr(me, me->tail);
+
+	return len;
+}
+
+void circular_buf_read_release(cbuf_handle_t me, size_t n)
+{
+	assert(me);
+
+	if(n)
+	{
+		me->tail = advance_headtail_value_by(me->tail, n, me->max);
+		me->full = false;
+	}
 }
@@ -10,12 +10,31 @@ typedef struct circular_buf_t circular_buf_t;
 /// Handle type, the way users interact with the API
 typedef circular_buf_t* cbuf_handle_t;
 
+/// A note on thread safety: circular_buffer_no_modulo_threadsafe.c is safe to use with a
+/// single producer (try_put, put_range, write_reserve/write_commit) and a single consumer
+/// (get, get_range, peek, read_peek_contiguous/read_release) without locks.
+/// The producer may also use put/put_elem, which overwrite the oldest data when the buffer is
+/// full (e.g., for telemetry where old samples should be dropped). In that case, the consumer
+/// must only use get, which detects and skips elements that are dropped while it reads them.
+/// The other implementations require external locking.
+
+/// A note on element sizes: buffers created with circular_buf_init store bytes.
+/// Buffers created with circular_buf_init_elem store fixed-size records (e.g. a sensor sample
+/// struct), and each element is copied in and out with a single fixed-size copy.
+/// All sizes, counts, and lengths in this API are in elements, not bytes.
+
 /// Pass in a storage buffer and size, returns a circular buffer handle
 /// Requires: buffer is not NULL, size > 0 (size > 1 for the threadsafe
 //  version, because it holds size - 1 elements)
 /// Ensures: me has been created and is returned in an empty state
 cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size);
 
+/// Pass in a storage buffer, element count, and element size; returns a circular buffer handle
+/// Requires: buffer is not NULL and holds at least elem_count * elem_size bytes,
+///	elem_count > 0 (elem_count > 1 for the threadsafe version), elem_size > 0
+/// Ensures: me has been created and is returned in an empty state
+cbuf_handle_t circular_buf_init_elem(void* buffer, size_t elem_count, size_t elem_size);
+
 /// Free a circular buffer structure
 /// Requires: me is valid and created by circular_buf_init
 /// Does not free data buffer; owner is responsible for that
@@ -27,21 +46,30 @@ void circular_buf_reset(cbuf_handle_t me);
 
 /// Put that continues to add data if the buffer is full
 /// Old data is overwritten
-/// Note: if you are using the threadsafe version, this API cannot be used, because
-/// it modifies the tail pointer in some cases. Use circular_buf_try_put instead.
+/// Note: if you are using the threadsafe version, the consumer must only use circular_buf_get
+/// while the producer uses this API, because it modifies the tail pointer in some cases.
 /// Requires: me is valid and created by circular_buf_init
 void circular_buf_put(cbuf_handle_t me, uint8_t data);
 
+/// circular_buf_put for buffers created with circular_buf_init_elem
+/// Requires: me is valid, data points to one element
+void circular_buf_put_elem(cbuf_handle_t me, const void* data);
+
 /// Put that rejects new data if the buffer is full
 /// Note: if you are using the threadsafe version, *this* is the put you should use
 /// Requires: me is valid and created by circular_buf_init
 /// Returns 0 on success, -1 if buffer is full
 int circular_buf_try_put(cbuf_handle_t me, uint8_t data);
 
+/// circular_buf_try_put for buffers created with circular_buf_init_elem
+/// Requires: me is valid, data points to one element
+/// Returns 0 on success, -1 if buffer is full
+int circular_buf_try_put_elem(cbuf_handle_t me, const void* data);
+
 /// Retrieve a value from the buffer
-/// Requires: me is valid and created by circular_buf_init
+/// Requires: me is valid and created by circular_buf_init, data can hold one element
 /// Returns 0 on success, -1 if the buffer is empty
-int circular_buf_get(cbuf_handle_t me, uint8_t* data);
+int circular_buf_get(cbuf_handle_t me, void* data);
 
 /// CHecks if the buffer is empty
 /// Requires: me is valid and created by circular_buf_init
@@ -55,7 +83,7 @@ bool circular_buf_full(cbuf_handle_t me);
 
 /// Check the capacity of the buffer
 /// Requires: me is valid and created by circular_buf_init
-/// Returns the maximum capacity of the buffer
+/// Returns the maximum capacity of the buffer, in elements
 size_t circular_buf_capacity(cbuf_handle_t me);
 
 /// Check the number of elements stored in the buffer
@@ -68,9 +96,55 @@ size_t circular_buf_size(cbuf_handle_t me);
 ///		- me is valid and created by circular_buf_init
 ///		- look_ahead_counter is less than or equal to the value returned by circular_buf_size()
 /// Returns 0 if successful, -1 if data is not available
-int circular_buf_peek(cbuf_handle_t me, uint8_t* data, unsigned int look_ahead_counter);
+int circular_buf_peek(cbuf_handle_t me, void* data, unsigned int look_ahead_counter);
+
+/// Retrieve multiple values from the buffer in a single operation
+/// Data is copied out in at most two segments (before and after the wrap point)
+/// Requires:
+///		- me is valid and created by circular_buf_init
+///		- data is not NULL and can hold at least len values
+/// Returns 0 on success, -1 if fewer than len values are stored (nothing is removed)
+int circular_buf_get_range(cbuf_handle_t me, void* data, size_t len);
 
-// TODO: int circular_buf_get_range(circular_buf_t me, uint8_t *data, size_t len);
-// TODO: int circular_buf_put_range(circular_buf_t me, uint8_t * data, size_t len);
+/// Add multiple values to the buffer in a single operation
+/// Like circular_buf_try_put, this rejects new data if there is not enough space,
+/// so it is safe to use with the threadsafe version.
+/// Requires:
+///		- me is valid and created by circular_buf_init
+///		- data is not NULL and contains at least len values
+/// Returns 0 on success, -1 if fewer than len slots are free (nothing is added)
+int circular_buf_put_range(cbuf_handle_t me, const void* data, size_t len);
+
+/// Reserve a contiguous region of free space so data can be written directly into the buffer
+/// (e.g. by a DMA engine or read(2)). The region ends at the wrap point or at the last
+/// free slot, whichever comes first, so it may be smaller than the total free space.
+/// Nothing is added to the buffer until circular_buf_write_commit is called.
+/// Requires:
+///		- me is valid and created by circular_buf_init
+///		- ptr is not NULL
+/// Returns the number of values (at most max) that can be written at *ptr; 0 if the buffer is full
+size_t circular_buf_write_reserve(cbuf_handle_t me, uint8_t** ptr, size_t max);
+
+/// Add values written into a region returned by circular_buf_write_reserve to the buffer
+/// Requires:
+///		- me is valid and created by circular_buf_init
+///		- n is less than or equal to the value returned by the last circular_buf_write_reserve
+void circular_buf_write_commit(cbuf_handle_t me, size_t n);
+
+/// Get a pointer to the oldest stored data, so it can be consumed in place.
+/// The region ends at the wrap point, so it may be smaller than circular_buf_size().
+/// Nothing is removed from the buffer until circular_buf_read_release is called.
+/// Requires:
+///		- me is valid and created by circular_buf_init
+///		- ptr is not NULL
+/// Returns the number of values that can be read at *ptr; 0 if the buffer is empty
+size_t circular_buf_read_peek_contiguous(cbuf_handle_t me, const uint8_t** ptr);
+
+/// Remove values consumed from a region returned by circular_buf_read_peek_contiguous
+/// Requires:
+///		- me is valid and created by circular_buf_init
+///		- n is less than or equal to the value returned by the last
+///		  circular_buf_read_peek_contiguous
+void circular_buf_read_release(cbuf_handle_t me, size_t n);
 
 #endif // CIRCULAR_BUFFER_H_
@@ -1,19 +1,37 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdatomic.h>
+#include <string.h>
 #include <assert.h>
 
 #include "circular_buffer.h"
 
 /// This implementation is threadsafe for a single producer and single consumer
+///
+/// The producer only writes head, and the consumer only writes tail. Each side publishes
+/// its index with a release store after touching the buffer, and reads the other side's
+/// index with an acquire load before touching the buffer. This guarantees that data written
+/// into a slot is visible before the slot is handed to the other side.
+///
+/// put/put_elem overwrite the oldest element when the buffer is full. To drop it, the producer
+/// advances tail with a compare-and-swap, and get advances tail with a compare-and-swap as well.
+/// If the producer drops an element while the consumer is copying it out, the consumer's
+/// exchange fails, and it discards the (possibly torn) copy and retries with the new tail.
+/// tail carries a lap count in its upper bits, so it never returns to a value the consumer
+/// has already seen: an exchange can't succeed just because the producer went all the way
+/// around the buffer. Slot accesses that can race this way use relaxed atomic word and byte
+/// accesses, so the race is well defined and not reported by ThreadSanitizer.
 
 // The definition of our circular buffer structure is hidden from the user
 struct circular_buf_t
 {
 	uint8_t* buffer;
-	size_t head;
-	size_t tail;
-	size_t max; // of the buffer
+	atomic_size_t head; // Only modified by the producer
+	atomic_size_t tail; // Lap count and index. Modified by the consumer, and by put when full
+	size_t max; // of the buffer, in elements
+	size_t elem_size; // in bytes
+	size_t tail_shift; // Number of bits used for the index in tail
 };
 
 #pragma mark - Private Functions -
@@ -28,17 +46,179 @@ static inline size_t advance_headtail_value(size_t value, size_t max)
 	return value;
 }
 
+static inline size_t advance_headtail_value_by(size_t value, size_t n, size_t max)
+{
+	// n <= max, so a single subtraction is enough to wrap
+	value += n;
+	if(value >= max)
+	{
+		value -= max;
+	}
+
+	return value;
+}
+
+static inline uint8_t* elem_ptr(cbuf_handle_t me, size_t pos)
+{
+	return &me->buffer[pos * me->elem_size];
+}
+
+/// Copy len elements into the buffer starting at pos, wrapping around the end of the buffer
+static void copy_to_buffer(cbuf_handle_t me, size_t pos, const uint8_t* data, size_t len)
+{
+	size_t first = me->max - pos;
+
+	if(first > len)
+	{
+		first = len;
+	}
+
+	memcpy(elem_ptr(me, pos), data, first * me->elem_size);
+	memcpy(me->buffer, data + (first * me->elem_size), (len - first) * me->elem_size);
+}
+
+/// Copy len elements out of the buffer starting at pos, wrapping around the end of the buffer
+static void copy_from_buffer(cbuf_handle_t me, size_t pos, uint8_t* data, size_t len)
+{
+	size_t first = me->max - pos;
+
+	if(first > len)
+	{
+		first = len;
+	}
+
+	memcpy(data, elem_ptr(me, pos), first * me->elem_size);
+	memcpy(data + (first * me->elem_size), me->buffer, (len - first) * me->elem_size);
+}
+
+/// Words of the buffer, for relaxed atomic accesses to memory that is declared as bytes
+typedef size_t __attribute__((may_alias)) buf_word_t;
+
+/// The number of bytes before the first word boundary in the buffer, at most n
+static inline size_t unaligned_head(const uint8_t* p, size_t n)
+{
+	size_t head = (size_t)(-(uintptr_t)p & (sizeof(buf_word_t) - 1));
+
+	return (head < n) ? head : n;
+}
+
+/// Store an element with relaxed atomic accesses: aligned words in the middle, and bytes at
+/// the edges. A consumer may be reading this slot if the element that was stored here before
+/// was dropped by put_elem.
+static void store_elem_relaxed(uint8_t* dst, const uint8_t* src, size_t n)
+{
+	size_t i = unaligned_head(dst, n);
+
+	for(size_t j = 0; j < i; j++)
+	{
+		__atomic_store_n(&dst[j], src[j], __ATOMIC_RELAXED);
+	}
+
+	for(; i + sizeof(buf_word_t) <= n; i += sizeof(buf_word_t))
+	{
+		buf_word_t word;
+
+		memcpy(&word, &src[i], sizeof(word));
+		__atomic_store_n((buf_word_t*)&dst[i], word, __ATOMIC_RELAXED);
+	}
+
+	for(; i < n; i++)
+	{
+		__atomic_store_n(&dst[i], src[i], __ATOMIC_RELAXED);
+	}
+}
+
+/// Load an element the same way. The copy may be torn if the producer overwrites the slot:
+/// get detects this and discards the copy.
+static void load_elem_relaxed(uint8_t* dst, const uint8_t* src, size_t n)
+{
+	size_t i = unaligned_head(src, n);
+
+	for(size_t j = 0; j < i; j++)
+	{
+		dst[j] = __atomic_load_n(&src[j], __ATOMIC_RELAXED);
+	}
+
+	for(; i + sizeof(buf_word_t) <= n; i += sizeof(buf_word_t))
+	{
+		buf_word_t word = __atomic_load_n((const buf_word_t*)&src[i], __ATOMIC_RELAXED);
+
+		memcpy(&dst[i], &word, sizeof(word));
+	}
+
+	for(; i < n; i++)
+	{
+		dst[i] = __atomic_load_n(&src[i], __ATOMIC_RELAXED);
+	}
+}
+
+static inline size_t tail_index(cbuf_handle_t me, size_t tail)
+{
+	return tail & (((size_t)1 << me->tail_shift) - 1);
+}
+
+/// Advance a tail value by n elements, bumping the lap count when the index wraps
+static inline size_t advance_tail_value_by(cbuf_handle_t me, size_t tail, size_t n)
+{
+	size_t lap = tail >> me->tail_shift;
+	size_t index = tail_index(me, tail) + n;
+
+	// n <= max, so a single subtraction is enough to wrap
+	if(index >= me->max)
+	{
+		index -= me->max;
+		lap++;
+	}
+
+	return (lap << me->tail_shift) | index;
+}
+
+/// The consumer's current tail index
+static inline size_t load_tail(cbuf_handle_t me, memory_order order)
+{
+	return tail_index(me, atomic_load_explicit(&me->tail, order));
+}
+
+/// The producer's view of the head: only the producer writes it
+static inline size_t producer_head(cbuf_handle_t me)
+{
+	return atomic_load_explicit(&me->head, memory_order_relaxed);
+}
+
+/// Move the tail forward from the consumer side. Only valid when the producer isn't using
+/// put/put_elem, so the consumer is the only one writing tail.
+static inline void consumer_release(cbuf_handle_t me, size_t n)
+{
+	size_t tail = atomic_load_explicit(&me->tail, memory_order_relaxed);
+
+	atomic_store_explicit(&me->tail, advance_tail_value_by(me, tail, n), memory_order_release);
+}
+
 #pragma mark - APIs -
 
 cbuf_handle_t circular_buf_init(uint8_t* buffer, size_t size)
 {
-	assert(buffer && size > 1);
+	return circular_buf_init_elem(buffer, size, 1);
+}
+
+cbuf_handle_t circular_buf_init_elem(void* buffer, size_t elem_count, size_t elem_size)
+{
+	assert(buffer && elem_count > 1 && elem_size);
 
 	cbuf_handle_t cbuf = malloc(sizeof(circular_buf_t));
 	assert(cbuf);
 
 	cbuf->buffer = buffer;
-	cbuf->max = size;
+	cbuf->max = elem_count;
+	cbuf->elem_size = elem_size;
+
+	// The index needs enough bits to hold max - 1; the rest of tail counts laps
+	cbuf->tail_shift = 0;
+	while(((size_t)1 << cbuf->tail_shift) < elem_count)
+	{
+		cbuf->tail_shift++;
+	}
+
 	circular_buf_reset(cbuf);
 
 	assert(circular_buf_empty(cbuf));
@@ -56,30 +236,25 @@ void circular_buf_reset(cbuf_handle_t me)
 {
 	assert(me);
 
-	me->head = 0;
-	me->tail = 0;
+	atomic_store_explicit(&me->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&me->tail, 0, memory_order_relaxed);
 }
 
 size_t circular_buf_size(cbuf_handle_t me)
 {
 	assert(me);
 
-	// We account for the space we can't use for thread safety
-	size_t size = me->max - 1;
+	size_t tail = load_tail(me, memory_order_acquire);
+	size_t head = atomic_load_explicit(&me->head, memory_order_acquire);
 
-	if(!circular_buf_full(me))
+	// When the buffer is full, this evaluates to max - 1:
+	// we account for the space we can't use for thread safety
+	if(head >= tail)
 	{
-		if(me->head >= me->tail)
-		{
-			size = (me->head - me->tail);
-		}
-		else
-		{
-			size = (me->max + me->head - me->tail);
-		}
+		return head - tail;
 	}
 
-	return size;
+	return me->max + head - tail;
 }
 
 size_t circular_buf_capacity(cbuf_handle_t me)
@@ -90,72 +265,106 @@ size_t circular_buf_capacity(cbuf_handle_t me)
 	return me->max - 1;
 }
 
-/// For thread safety, do not use put - use try_put.
-/// Because this version, which will overwrite the existing contents
-/// of the buffer, will involve modifying the tail pointer, which is also
-/// modified by get.
 void circular_buf_put(cbuf_handle_t me, uint8_t data)
 {
-	assert(me && me->buffer);
+	assert(me && me->elem_size == 1);
 
-	me->buffer[me->head] = data;
-	if(circular_buf_full(me))
+	circular_buf_put_elem(me, &data);
+}
+
+int circular_buf_try_put(cbuf_handle_t me, uint8_t data)
+{
+	assert(me && me->elem_size == 1);
+
+	return circular_buf_try_put_elem(me, &data);
+}
+
+/// When the buffer is full, the oldest element is dropped to make room. This is safe while the
+/// consumer is using get; the other consumer APIs assume the producer never moves tail.
+void circular_buf_put_elem(cbuf_handle_t me, const void* data)
+{
+	assert(me && data && me->buffer);
+
+	size_t head = producer_head(me);
+	size_t next = advance_headtail_value(head, me->max);
+
+	// head is always the empty slot, so the consumer can't be reading it for this lap
+	store_elem_relaxed(elem_ptr(me, head), data, me->elem_size);
+
+	size_t tail = atomic_load_explicit(&me->tail, memory_order_acquire);
+	if(next == tail_index(me, tail))
 	{
-		// THIS CONDITION IS NOT THREAD SAFE
-		me->tail = advance_headtail_value(me->tail, me->max);
+		// Drop the oldest element. If the exchange fails, the consumer just removed it.
+		atomic_compare_exchange_strong_explicit(&me->tail, &tail,
+												advance_tail_value_by(me, tail, 1),
+												memory_order_acq_rel, memory_order_acquire);
 	}
 
-	me->head = advance_headtail_value(me->head, me->max);
+	atomic_store_explicit(&me->head, next, memory_order_release);
 }
 
-int circular_buf_try_put(cbuf_handle_t me, uint8_t data)
+int circular_buf_try_put_elem(cbuf_handle_t me, const void* data)
 {
-	assert(me && me->buffer);
+	assert(me && data && me->buffer);
 
 	int r = -1;
 
 	if(!circular_buf_full(me))
 	{
-		me->buffer[me->head] = data;
-		me->head = advance_headtail_value(me->head, me->max);
+		size_t head = producer_head(me);
+
+		store_elem_relaxed(elem_ptr(me, head), data, me->elem_size);
+		atomic_store_explicit(&me->head, advance_headtail_value(head, me->max),
+							  memory_order_release);
 		r = 0;
 	}
 
 	return r;
 }
 
-int circular_buf_get(cbuf_handle_t me, uint8_t* data)
+int circular_buf_get(cbuf_handle_t me, void* data)
 {
 	assert(me && data && me->buffer);
 
-	int r = -1;
+	size_t tail = atomic_load_explicit(&me->tail, memory_order_acquire);
 
-	if(!circular_buf_empty(me))
+	while(tail_index(me, tail) != atomic_load_explicit(&me->head, memory_order_acquire))
 	{
-		*data = me->buffer[me->tail];
-		me->tail = advance_headtail_value(me->tail, me->max);
-		r = 0;
+		load_elem_relaxed(data, elem_ptr(me, tail_index(me, tail)), me->elem_size);
+
+		// If put dropped this element while we were copying it, tail has moved on and the
+		// exchange fails. tail is reloaded, and we try again with the next oldest element.
+		if(atomic_compare_exchange_weak_explicit(&me->tail, &tail,
+												 advance_tail_value_by(me, tail, 1),
+												 memory_order_acq_rel, memory_order_acquire))
+		{
+			return 0;
+		}
 	}
 
-	return r;
+	return -1;
 }
 
 bool circular_buf_empty(cbuf_handle_t me)
 {
 	assert(me);
-	return me->head == me->tail;
+
+	size_t tail = load_tail(me, memory_order_acquire);
+
+	return atomic_load_explicit(&me->head, memory_order_acquire) == tail;
 }
 
 bool circular_buf_full(cbuf_handle_t me)
 {
+	size_t head = atomic_load_explicit(&me->head, memory_order_acquire);
+
 	// We want to check, not advance, so we don't save the output here
-	return advance_headtail_value(me->head, me->max) == me->tail;
+	return advance_headtail_value(head, me->max) == load_tail(me, memory_order_acquire);
 }
 
-int circular_buf_peek(cbuf_handle_t me, uint8_t* data, unsigned int look_ahead_counter)
+int circular_buf_peek(cbuf_handle_t me, void* data, unsigned int look_ahead_counter)
 {
 	int r = -1;
-	size_t pos;
 
 	assert(me && data && me->buffer);
 
@@ -165,12 +374,97 @@ int circular_buf_peek(cbuf_handle_t me, uint8_t* data, unsigned int look_ahead_c
 		return r;
 	}
 
-	pos = me->tail;
-	for(unsigned int i = 0; i < look_ahead_counter; i++)
+	copy_from_buffer(me, load_tail(me, memory_order_relaxed), data, look_ahead_counter);
+
+	return 0;
+}
+
+int circular_buf_get_range(cbuf_handle_t me, void* data, size_t len)
+{
+	assert(me && data && me->buffer);
+
+	int r = -1;
+
+	if(len <= circular_buf_size(me))
 	{
-		data[i] = me->buffer[pos];
-		pos = advance_headtail_value(pos, me->max);
+		copy_from_buffer(me, load_tail(me, memory_order_relaxed), data, len);
+		consumer_release(me, len);
+		r = 0;
 	}
 
-	return 0;
+	return r;
+}
+
+int circular_buf_put_range(cbuf_handle_t me, const void* data, size_t len)
+{
+	assert(me && data && me->buffer);
+
+	int r = -1;
+
+	if(len <= circular_buf_capacity(me) - circular_buf_size(me))
+	{
+		size_t head = producer_head(me);
+
+		copy_to_buffer(me, head, data, len);
+		atomic_store_explicit(&me->head, advance_headtail_value_by(head, len, me->max),
+							  memory_order_release);
+		r = 0;
+	}
+
+	return r;
+}
+
+size_t circular_buf_write_reserve(cbuf_handle_t me, uint8_t** ptr, size_t max)
+{
+	assert(me && ptr && me->buffer);
+
+	size_t head = producer_head(me);
+	size_t tail = load_tail(me, memory_order_acquire);
+	size_t len;
+
+	if(head < tail)
+	{
+		// Free space is between head and tail, minus the slot we keep empty
+		len = tail - head - 1;
+	}
+	else
+	{
+		// Free space runs to the end of the buffer. If the tail is at the start,
+		// the last slot must stay empty so that head doesn't catch up to tail.
+		len = me->max - head - (tail == 0);
+	}
+
+	*ptr = elem_ptr(me, head);
+
+	return (len < max) ? len : max;
+}
+
+void circular_buf_write_commit(cbuf_handle_t me, size_t n)
+{
+	assert(me);
+
+	size_t head = producer_head(me);
+
+	atomic_store_explicit(&me->head, advance_headtail_value_by(head, n, me->max),
+						  memory_order_release);
+}
+
+size_t circular_buf_read_peek_contiguous(cbuf_handle_t me, const uint8_t** ptr)
+{
+	assert(me && ptr && me->buffer);
+
+	size_t tail = load_tail(me, memory_order_relaxed);
+	size_t head = atomic_load_explicit(&me->head, memory_order_acquire);
+
+	*ptr = elem_ptr(me, tail);
+
+	// If the data wraps, only the segment up to the end of the buffer is contiguous
+	return (head >= tail) ? (head - tail) : (me->max - tail);
+}
+
+void circular_buf_read_release(cbuf_handle_t me, size_t n)
+{
+	assert(me);
+
+	consumer_release(me, n);
 }
@@ -11,17 +11,80 @@
 #include <cmocka.h>
 // clang-format on
 
+#include <string.h>
 #include "circular_buffer/circular_buffer.h"
 
 #define CIRCULAR_BUFFER_SIZE 10
 #define PEEK_ARRAY_SIZE 5
+#define MAX_ELEM_SIZE 64
 
-static uint8_t circular_buffer_storage_[CIRCULAR_BUFFER_SIZE] = {0};
+static uint8_t circular_buffer_storage_[CIRCULAR_BUFFER_SIZE * MAX_ELEM_SIZE] = {0};
 static cbuf_handle_t handle_ = NULL;
+static size_t elem_size_ = 1;
 
-static int circular_buffer_setup(void** __unused state)
+// The suite is run once for each of these element sizes
+static size_t elem_sizes_[] = {1, 4, 16, 64};
+
+#pragma mark - Helpers -
+
+// Every byte of an element is derived from its value, so that a partial copy is detected
+static void make_elem(uint8_t* elem, int value)
+{
+	for(size_t i = 0; i < elem_size_; i++)
+	{
+		elem[i] = (uint8_t)(value + i);
+	}
+}
+
+// Byte buffers use the original uint8_t APIs, so they are still covered
+static void put_value(int value)
+{
+	uint8_t elem[MAX_ELEM_SIZE];
+
+	if(elem_size_ == 1)
+	{
+		circular_buf_put(handle_, (uint8_t)value);
+	}
+	else
+	{
+		make_elem(elem, value);
+		circular_buf_put_elem(handle_, elem);
+	}
+}
+
+static int try_put_value(int value)
+{
+	uint8_t elem[MAX_ELEM_SIZE];
+
+	if(elem_size_ == 1)
+	{
+		return circular_buf_try_put(handle_, (uint8_t)value);
+	}
+
+	make_elem(elem, value);
+	return circular_buf_try_put_elem(handle_, elem);
+}
+
+static void assert_elem_equal(const uint8_t* elem, int value)
 {
-	handle_ = circular_buf_init(circular_buffer_storage_, CIRCULAR_BUFFER_SIZE);
+	uint8_t expected[MAX_ELEM_SIZE];
+
+	make_elem(expected, value);
+	assert_memory_equal(elem, expected, elem_size_);
+}
+
+static int circular_buffer_setup(void** state)
+{
+	elem_size_ = *(size_t*)*state;
+
+	if(elem_size_ == 1)
+	{
+		handle_ = circular_buf_init(circular_buffer_storage_, CIRCULAR_BUFFER_SIZE);
+	}
+	else
+	{
+		handle_ = circular_buf_init_elem(circular_buffer_storage_, CIRCULAR_BUFFER_SIZE, elem_size_);
+	}
 
 	return 0;
 }
@@ -33,6 +96,8 @@ static int circular_buffer_teardown(void** __unused state)
 	return 0;
 }
 
+#pragma mark - Tests -
+
 void circular_buffer_init_test(void** __unused state)
 {
 	assert_non_null(handle_);
@@ -51,22 +116,22 @@ void circular_buf_put_get_test(void** __unused state)
 	const int capacity = circular_buf_capacity(handle_);
 	for(int i = 0; i < capacity; i++)
 	{
-		circular_buf_put(handle_, i);
+		put_value(i);
 
 		assert_int_equal(i + 1, circular_buf_size(handle_));
 	}
 
 	// Check overflow condition
-	circular_buf_put(handle_, capacity);
+	put_value(capacity);
 	assert_int_equal(capacity, circular_buf_size(handle_));
 
-	// Check get - we are expecting that one byte has been overwritten
+	// Check get - we are expecting that one element has been overwritten
 	// so we should see that the data is [1..10] instead of [0..9]
 	for(int i = 0; i < capacity; i++)
 	{
-		uint8_t data;
-		circular_buf_get(handle_, &data);
-		assert_int_equal(data, i + 1);
+		uint8_t data[MAX_ELEM_SIZE];
+		circular_buf_get(handle_, data);
+		assert_elem_equal(data, i + 1);
 	}
 }
 
@@ -77,22 +142,22 @@ void circular_buf_try_put_get_test(void** __unused state)
 
 	for(int i = 0; i < capacity; i++)
 	{
-		success = circular_buf_try_put(handle_, i);
+		success = try_put_value(i);
 		assert_int_equal(success, 0);
 		assert_int_equal(i + 1, circular_buf_size(handle_));
 	}
 
 	// Check overflow condition
-	success = circular_buf_try_put(handle_, capacity);
+	success = try_put_value(capacity);
 	assert_int_equal(success, -1);
 
 	// Check get - we are expecting that the previous put failed,
 	// so we should see that the data is [0..9]
 	for(int i = 0; i < capacity; i++)
 	{
-		uint8_t data;
-		circular_buf_get(handle_, &data);
-		assert_int_equal(data, i);
+		uint8_t data[MAX_ELEM_SIZE];
+		circular_buf_get(handle_, data);
+		assert_elem_equal(data, i);
 	}
 }
 
@@ -103,7 +168,7 @@ void circular_buffer_full_test(void** __unused state)
 	for(int i = 0; i < capacity; i++)
 	{
 		assert_false(circular_buf_full(handle_));
-		circular_buf_put(handle_, i);
+		put_value(i);
 	}
 
 	assert_true(circular_buf_full(handle_));
@@ -117,35 +182,36 @@ void circular_buffer_empty_test(void** __unused state)
 
 	for(int i = 0; i < capacity; i++)
 	{
-		circular_buf_put(handle_, i);
+		put_value(i);
 		assert_false(circular_buf_empty(handle_));
 	}
 }
 
 void circular_buffer_get_more_than_stored_test(void** __unused state)
 {
-	uint8_t data;
+	uint8_t data[MAX_ELEM_SIZE];
+	uint8_t zero[MAX_ELEM_SIZE] = {0};
 
 	// We will put one and read two
 
-	circular_buf_put(handle_, 1);
+	put_value(1);
 
-	assert_int_equal(0, circular_buf_get(handle_, &data));
-	assert_int_equal(data, 1);
-	data = 0;
-	assert_int_equal(-1, circular_buf_get(handle_, &data));
-	assert_int_equal(data, 0);
+	assert_int_equal(0, circular_buf_get(handle_, data));
+	assert_elem_equal(data, 1);
+	memset(data, 0, sizeof(data));
+	assert_int_equal(-1, circular_buf_get(handle_, data));
+	assert_memory_equal(data, zero, elem_size_);
 }
 
 void circular_buffer_peek_test(void** __unused state)
 {
 	const int capacity = circular_buf_capacity(handle_);
-	uint8_t peek_data[PEEK_ARRAY_SIZE];
+	uint8_t peek_data[PEEK_ARRAY_SIZE * MAX_ELEM_SIZE];
 
 	// Fill the buffer
 	for(int i = 0; i < capacity; i++)
 	{
-		circular_buf_put(handle_, i);
+		put_value(i);
 	}
 
 	assert_true(circular_buf_full(handle_));
@@ -156,14 +222,14 @@ void circular_buffer_peek_test(void** __unused state)
 
 	for(int i = 0; i < PEEK_ARRAY_SIZE; i++)
 	{
-		assert_int_equal(peek_data[i], i);
+		assert_elem_equal(&peek_data[i * elem_size_], i);
 	}
 
 	for(int i = 0; i < capacity; i++)
 	{
-		uint8_t data;
-		circular_buf_get(handle_, &data);
-		assert_int_equal(data, i);
+		uint8_t data[MAX_ELEM_SIZE];
+		circular_buf_get(handle_, data);
+		assert_elem_equal(data, i);
 	}
 
 	assert_true(circular_buf_empty(handle_));
@@ -175,32 +241,173 @@ void circular_buffer_peek_test(void** __unused state)
 	// Check more than available
 	for(int i = 0; i < 4; i++)
 	{
-		circular_buf_put(handle_, i);
+		put_value(i);
 	}
 	r = circular_buf_peek(handle_, peek_data, PEEK_ARRAY_SIZE);
 	assert_int_equal(r, -1);
 }
 
+void circular_buffer_put_range_get_range_test(void** __unused state)
+{
+	const size_t capacity = circular_buf_capacity(handle_);
+	uint8_t in[CIRCULAR_BUFFER_SIZE * MAX_ELEM_SIZE];
+	uint8_t out[CIRCULAR_BUFFER_SIZE * MAX_ELEM_SIZE] = {0};
+	uint8_t data[MAX_ELEM_SIZE];
+
+	for(size_t i = 0; i < capacity; i++)
+	{
+		make_elem(&in[i * elem_size_], (int)i + 1);
+	}
+
+	// Move the head and tail so that the range operations have to wrap
+	for(int i = 0; i < 3; i++)
+	{
+		try_put_value(0);
+		circular_buf_get(handle_, data);
+	}
+
+	assert_int_equal(0, circular_buf_put_range(handle_, in, capacity));
+	assert_true(circular_buf_full(handle_));
+	assert_int_equal(capacity, circular_buf_size(handle_));
+
+	assert_int_equal(0, circular_buf_get_range(handle_, out, capacity));
+	assert_true(circular_buf_empty(handle_));
+	assert_memory_equal(in, out, capacity * elem_size_);
+
+	// Ranges interleave with the single-value APIs
+	assert_int_equal(0, circular_buf_put_range(handle_, in, 2));
+	assert_int_equal(0, try_put_value(42));
+	assert_int_equal(3, circular_buf_size(handle_));
+	assert_int_equal(0, circular_buf_get(handle_, data));
+	assert_elem_equal(data, 1);
+	assert_int_equal(0, circular_buf_get_range(handle_, out, 2));
+	assert_elem_equal(&out[0], 2);
+	assert_elem_equal(&out[elem_size_], 42);
+
+	// Zero-length ranges are no-ops
+	assert_int_equal(0, circular_buf_put_range(handle_, in, 0));
+	assert_int_equal(0, circular_buf_get_range(handle_, out, 0));
+	assert_true(circular_buf_empty(handle_));
+}
+
+void circular_buffer_range_limits_test(void** __unused state)
+{
+	const size_t capacity = circular_buf_capacity(handle_);
+	uint8_t in[(CIRCULAR_BUFFER_SIZE + 1) * MAX_ELEM_SIZE] = {0};
+	uint8_t out[(CIRCULAR_BUFFER_SIZE + 1) * MAX_ELEM_SIZE] = {0};
+
+	// Can't get data that isn't stored
+	assert_int_equal(-1, circular_buf_get_range(handle_, out, 1));
+
+	// Can't put more than the capacity
+	assert_int_equal(-1, circular_buf_put_range(handle_, in, capacity + 1));
+	assert_true(circular_buf_empty(handle_));
+
+	// Can't put more than the remaining space, and nothing is added on failure
+	assert_int_equal(0, circular_buf_put_range(handle_, in, capacity - 1));
+	assert_int_equal(-1, circular_buf_put_range(handle_, in, 2));
+	assert_int_equal(capacity - 1, circular_buf_size(handle_));
+
+	// Can't get more than is stored, and nothing is removed on failure
+	assert_int_equal(-1, circular_buf_get_range(handle_, out, capacity));
+	assert_int_equal(capacity - 1, circular_buf_size(handle_));
+}
+
+void circular_buffer_reserve_commit_test(void** __unused state)
+{
+	const size_t capacity = circular_buf_capacity(handle_);
+	uint8_t* write_ptr;
+	const uint8_t* read_ptr;
+
+	// An empty buffer offers its whole capacity, limited by max
+	assert_int_equal(capacity,
+					 circular_buf_write_reserve(handle_, &write_ptr, CIRCULAR_BUFFER_SIZE));
+	assert_int_equal(3, circular_buf_write_reserve(handle_, &write_ptr, 3));
+
+	for(int i = 0; i < 3; i++)
+	{
+		make_elem(&write_ptr[i * elem_size_], i);
+	}
+
+	// Nothing is added until the data is committed
+	assert_true(circular_buf_empty(handle_));
+	circular_buf_write_commit(handle_, 3);
+	assert_int_equal(3, circular_buf_size(handle_));
+
+	assert_int_equal(3, circular_buf_read_peek_contiguous(handle_, &read_ptr));
+	for(int i = 0; i < 3; i++)
+	{
+		assert_elem_equal(&read_ptr[i * elem_size_], i);
+	}
+
+	// Nothing is removed until the data is released
+	assert_int_equal(3, circular_buf_size(handle_));
+	circular_buf_read_release(handle_, 3);
+	assert_true(circular_buf_empty(handle_));
+
+	// Head and tail are now at 3, so the next region stops at the end of the buffer
+	size_t first = circular_buf_write_reserve(handle_, &write_ptr, CIRCULAR_BUFFER_SIZE);
+	assert_int_equal(CIRCULAR_BUFFER_SIZE - 3, first);
+	memset(write_ptr, 0xA5, first * elem_size_);
+	circular_buf_write_commit(handle_, first);
+
+	// And the rest of the free space starts over at the beginning of the storage
+	size_t second = circular_buf_write_reserve(handle_, &write_ptr, CIRCULAR_BUFFER_SIZE);
+	assert_int_equal(capacity - first, second);
+	assert_ptr_equal(write_ptr, circular_buffer_storage_);
+	memset(write_ptr, 0x5A, second * elem_size_);
+	circular_buf_write_commit(handle_, second);
+
+	assert_true(circular_buf_full(handle_));
+	assert_int_equal(0, circular_buf_write_reserve(handle_, &write_ptr, CIRCULAR_BUFFER_SIZE));
+
+	// Contiguous reads also stop at the end of the buffer
+	assert_int_equal(first, circular_buf_read_peek_contiguous(handle_, &read_ptr));
+	assert_int_equal(read_ptr[0], 0xA5);
+	assert_int_equal(read_ptr[(first * elem_size_) - 1], 0xA5);
+	circular_buf_read_release(handle_, first);
+
+	assert_int_equal(second, circular_buf_read_peek_contiguous(handle_, &read_ptr));
+	assert_ptr_equal(read_ptr, circular_buffer_storage_);
+	assert_int_equal(read_ptr[0], 0x5A);
+	circular_buf_read_release(handle_, second);
+
+	assert_true(circular_buf_empty(handle_));
+	assert_int_equal(0, circular_buf_read_peek_contiguous(handle_, &read_ptr));
+}
+
 #pragma mark - Public Functions -
 
-int circular_buffer_test_suite(void)
+#define circular_buffer_unit_test(test, elem_size)                               \
+	cmocka_unit_test_prestate_setup_teardown(test, circular_buffer_setup, \
+											 circular_buffer_teardown, elem_size)
+
+static int circular_buffer_run_tests(size_t* elem_size, const char* name)
 {
 	const struct CMUnitTest circular_buffer_tests[] = {
-		cmocka_unit_test_setup_teardown(circular_buffer_init_test, circular_buffer_setup,
-										circular_buffer_teardown),
-		cmocka_unit_test_setup_teardown(circular_buf_put_get_test, circular_buffer_setup,
-										circular_buffer_teardown),
-		cmocka_unit_test_setup_teardown(circular_buf_try_put_get_test, circular_buffer_setup,
-										circular_buffer_teardown),
-		cmocka_unit_test_setup_teardown(circular_buffer_full_test, circular_buffer_setup,
-										circular_buffer_teardown),
-		cmocka_unit_test_setup_teardown(circular_buffer_empty_test, circular_buffer_setup,
-										circular_buffer_teardown),
-		cmocka_unit_test_setup_teardown(circular_buffer_get_more_than_stored_test,
-										circular_buffer_setup, circular_buffer_teardown),
-		cmocka_unit_test_setup_teardown(circular_buffer_peek_test, circular_buffer_setup,
-										circular_buffer_teardown),
+		circular_buffer_unit_test(circular_buffer_init_test, elem_size),
+		circular_buffer_unit_test(circular_buf_put_get_test, elem_size),
+		circular_buffer_unit_test(circular_buf_try_put_get_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_full_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_empty_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_get_more_than_stored_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_peek_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_put_range_get_range_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_range_limits_test, elem_size),
+		circular_buffer_unit_test(circular_buffer_reserve_commit_test, elem_size),
 	};
 
-	return cmocka_run_group_tests(circular_buffer_tests, NULL, NULL);
+	return cmocka_run_group_tests_name(name, circular_buffer_tests, NULL, NULL);
+}
+
+int circular_buffer_test_suite(void)
+{
+	int overall_result = 0;
+
+	overall_result |= circular_buffer_run_tests(&elem_sizes_[0], "circular_buffer_elem_size_1");
+	overall_result |= circular_buffer_run_tests(&elem_sizes_[1], "circular_buffer_elem_size_4");
+	overall_result |= circular_buffer_run_tests(&elem_sizes_[2], "circular_buffer_elem_size_16");
+	overall_result |= circular_buffer_run_tests(&elem_sizes_[3], "circular_buffer_elem_size_64");
+
+	return overall_result;
 }
@@ -0,0 +1,222 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include "circular_buffer/circular_buffer.h"
+
+/// These tests only apply to circular_buffer_no_modulo_threadsafe.c. A producer thread and
+/// the test thread hammer the same buffer, so build them with -fsanitize=thread to check
+/// for data races as well as lost, duplicated, or torn elements.
+
+#define THREADSAFE_BUFFER_SIZE 16
+#define TRANSFER_COUNT 100000
+
+/// Each word of the element is derived from the value, so a torn copy is detected
+typedef struct
+{
+	uint32_t value;
+	uint32_t check[3];
+} sample_t;
+
+static sample_t storage_[THREADSAFE_BUFFER_SIZE];
+static cbuf_handle_t handle_ = NULL;
+
+#pragma mark - Helpers -
+
+static sample_t make_sample(uint32_t value)
+{
+	sample_t s = {value, {~value, value * 3, value ^ 0xA5A5A5A5}};
+	return s;
+}
+
+static bool sample_is_valid(const sample_t* s)
+{
+	sample_t expected = make_sample(s->value);
+
+	return (s->check[0] == expected.check[0]) && (s->check[1] == expected.check[1]) &&
+		   (s->check[2] == expected.check[2]);
+}
+
+static void* overwrite_producer(void* arg)
+{
+	(void)arg;
+
+	for(uint32_t i = 0; i < TRANSFER_COUNT; i++)
+	{
+		sample_t s = make_sample(i);
+		circular_buf_put_elem(handle_, &s);
+
+		if((i % 64) == 0)
+		{
+			// Give the consumer a chance to run on single-core machines
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void* try_put_producer(void* arg)
+{
+	(void)arg;
+
+	for(uint32_t i = 0; i < TRANSFER_COUNT; i++)
+	{
+		sample_t s = make_sample(i);
+
+		while(circular_buf_try_put_elem(handle_, &s) != 0)
+		{
+			sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static int threadsafe_setup(void** state)
+{
+	(void)state;
+
+	handle_ = circular_buf_init_elem(storage_, THREADSAFE_BUFFER_SIZE, sizeof(sample_t));
+
+	return 0;
+}
+
+static int threadsafe_teardown(void** state)
+{
+	(void)state;
+
+	circular_buf_free(handle_);
+
+	return 0;
+}
+
+#pragma mark - Tests -
+
+static void circular_buffer_put_overwrites_oldest(void** state)
+{
+	(void)state;
+
+	size_t capacity = circular_buf_capacity(handle_);
+	size_t extra = 5;
+	sample_t s;
+
+	for(uint32_t i = 0; i < capacity + extra; i++)
+	{
+		s = make_sample(i);
+		circular_buf_put_elem(handle_, &s);
+	}
+
+	assert_true(circular_buf_full(handle_));
+
+	// The oldest elements were dropped, and the rest come out in order
+	for(uint32_t i = extra; i < capacity + extra; i++)
+	{
+		assert_int_equal(circular_buf_get(handle_, &s), 0);
+		assert_int_equal(s.value, i);
+		assert_true(sample_is_valid(&s));
+	}
+
+	assert_true(circular_buf_empty(handle_));
+}
+
+static void circular_buffer_overwrite_two_threads(void** state)
+{
+	(void)state;
+
+	pthread_t producer;
+	uint32_t received = 0;
+	uint32_t last = 0;
+	sample_t s;
+
+	assert_int_equal(pthread_create(&producer, NULL, overwrite_producer, NULL), 0);
+
+	// Drain until the producer is done and the buffer is empty. Elements may be dropped,
+	// but the ones we get must be intact, in order, and never repeated.
+	while(true)
+	{
+		if(circular_buf_get(handle_, &s) == 0)
+		{
+			assert_true(sample_is_valid(&s));
+
+			if(received)
+			{
+				assert_true(s.value > last);
+			}
+
+			last = s.value;
+			received++;
+		}
+		else if(last == TRANSFER_COUNT - 1)
+		{
+			break;
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+
+	assert_int_equal(pthread_join(producer, NULL), 0);
+
+	assert_true(received > 0);
+	assert_true(received <= TRANSFER_COUNT);
+	assert_true(circular_buf_empty(handle_));
+}
+
+static void circular_buffer_try_put_two_threads(void** state)
+{
+	(void)state;
+
+	pthread_t producer;
+	sample_t s;
+
+	assert_int_equal(pthread_create(&producer, NULL, try_put_producer, NULL), 0);
+
+	// Nothing is dropped without put, so every element arrives in order
+	for(uint32_t i = 0; i < TRANSFER_COUNT;)
+	{
+		if(circular_buf_get(handle_, &s) == 0)
+		{
+			assert_int_equal(s.value, i);
+			assert_true(sample_is_valid(&s));
+			i++;
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+
+	assert_int_equal(pthread_join(producer, NULL), 0);
+
+	assert_true(circular_buf_empty(handle_));
+}
+
+#pragma mark - Public Functions -
+
+int circular_buffer_threadsafe_test_suite(void)
+{
+	const struct CMUnitTest circular_buffer_threadsafe_tests[] = {
+		cmocka_unit_test_setup_teardown(circular_buffer_put_overwrites_oldest, threadsafe_setup,
+										threadsafe_teardown),
+		cmocka_unit_test_setup_teardown(circular_buffer_overwrite_two_threads, threadsafe_setup,
+										threadsafe_teardown),
+		cmocka_unit_test_setup_teardown(circular_buffer_try_put_two_threads, threadsafe_setup,
+										threadsafe_teardown),
+	};
+
+	return cmocka_run_group_tests(circular_buffer_threadsafe_tests, NULL, NULL);
+}
@@ -0,0 +1,11 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef CIRCULAR_BUFFER_THREADSAFE_TESTS_H_
+#define CIRCULAR_BUFFER_THREADSAFE_TESTS_H_
+
+int circular_buffer_threadsafe_test_suite(void);
+
+#endif // CIRCULAR_BUFFER_THREADSAFE_TESTS_H_
@@ -0,0 +1,155 @@
+#include "arena_alloc.h"
+#include <assert.h>
+#include <stdalign.h>
+
+#pragma mark - Definitions -
+
+/**
+ * Simple macro for making sure memory addresses are aligned
+ * to the nearest power of two
+ */
+#ifndef align_up
+	#define align_up(num, align) (((num) + ((align)-1)) & ~((align)-1))
+#endif
+
+// The alignment that arena_alloc() guarantees, as malloc() does
+#define ARENA_DEFAULT_ALIGN alignof(max_align_t)
+
+#pragma mark - Private Functions -
+
+/// Each region starts with its chunk header, followed by the memory we hand out
+static inline uint8_t* chunk_begin(arena_chunk_t* chunk)
+{
+	return (uint8_t*)(chunk + 1);
+}
+
+#pragma mark - APIs -
+
+void arena_init(arena_t* arena)
+{
+	assert(arena);
+
+	arena->first = NULL;
+	arena->last = NULL;
+	arena->current = NULL;
+	arena->ptr = NULL;
+}
+
+int arena_addblock(arena_t* arena, void* addr, size_t size)
+{
+	arena_chunk_t* chunk;
+	uintptr_t end = (uintptr_t)addr + size;
+
+	assert(arena);
+
+	// Align the header so that it can be accessed safely
+	chunk = (arena_chunk_t*)align_up((uintptr_t)addr, alignof(arena_chunk_t));
+
+	if(!addr || (uintptr_t)chunk_begin(chunk) >= end)
+	{
+		return -1;
+	}
+
+	chunk->next = NULL;
+	chunk->end = (uint8_t*)end;
+
+	if(arena->last)
+	{
+		arena->last->next = chunk;
+	}
+	else
+	{
+		arena->first = chunk;
+		arena->current = chunk;
+		arena->ptr = chunk_begin(chunk);
+	}
+
+	arena->last = chunk;
+
+	return 0;
+}
+
+void* arena_alloc(arena_t* arena, size_t size)
+{
+	return arena_alloc_aligned(arena, size, ARENA_DEFAULT_ALIGN);
+}
+
+void* arena_alloc_aligned(arena_t* arena, size_t size, size_t align)
+{
+	arena_chunk_t* chunk;
+	uintptr_t ptr;
+
+	assert(arena);
+	assert(align && (align & (align - 1)) == 0);
+
+	if(size == 0)
+	{
+		return NULL;
+	}
+
+	chunk = arena->current;
+	ptr = (uintptr_t)arena->ptr;
+
+	// The fast path only checks the current region. When it is full, the rest of it is
+	// abandoned and we move on to the next region that can fit the request.
+	while(chunk)
+	{
+		uintptr_t p = align_up(ptr, align);
+
+		if(p >= ptr && p <= (uintptr_t)chunk->end && ((uintptr_t)chunk->end - p) >= size)
+		{
+			arena->current = chunk;
+			arena->ptr = (uint8_t*)(p + size);
+			return (void*)p;
+		}
+
+		chunk = chunk->next;
+		ptr = chunk ? (uintptr_t)chunk_begin(chunk) : 0;
+	}
+
+	// Leave the arena unchanged, so a smaller request can still use the current region
+	return NULL;
+}
+
+arena_marker_t arena_mark(const arena_t* arena)
+{
+	arena_marker_t marker;
+
+	assert(arena);
+
+	marker.chunk = arena->current;
+	marker.ptr = arena->ptr;
+
+	return marker;
+}
+
+void arena_rollback(arena_t* arena, arena_marker_t marker)
+{
+	assert(arena);
+
+	if(marker.chunk)
+	{
+		arena->current = marker.chunk;
+		arena->ptr = marker.ptr;
+	}
+	else
+	{
+		// The marker was taken before any memory was added
+		arena_reset(arena);
+	}
+}
+
+void arena_reset(arena_t* arena)
+{
+	assert(arena);
+
+	arena->current = arena->first;
+	arena->ptr = arena->first ? chunk_begin(arena->first) : NULL;
+}
+
+size_t arena_remaining(const arena_t* arena)
+{
+	assert(arena);
+
+	return arena->current ? (size_t)(arena->current->end - arena->ptr) : 0;
+}
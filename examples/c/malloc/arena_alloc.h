@@ -0,0 +1,90 @@
+#ifndef ARENA_ALLOC_H_
+#define ARENA_ALLOC_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif //__cplusplus
+
+	/**
+	 * Arena (bump pointer) allocator
+	 *
+	 * An arena hands out memory by advancing a pointer through a list of regions, so an
+	 * allocation is a few instructions. Individual allocations are never freed: instead, the
+	 * whole arena is reset at once when the work that used it is done, such as handling a
+	 * request. Markers allow part of the arena to be released, like a stack.
+	 *
+	 * Memory is supplied with arena_addblock(), in the same way as malloc_addblock().
+	 * Regions are used in the order they were added, and each one is chained to the next.
+	 *
+	 * An arena is not thread safe. The contents of these structs are private; they are only
+	 * declared here so that arenas and markers can be statically allocated.
+	 */
+	typedef struct arena_chunk
+	{
+		struct arena_chunk* next;
+		uint8_t* end;
+	} arena_chunk_t;
+
+	typedef struct
+	{
+		arena_chunk_t* first;
+		arena_chunk_t* last;
+		arena_chunk_t* current;
+		uint8_t* ptr; // The next free byte in current
+	} arena_t;
+
+	/// A position in an arena, see arena_mark()
+	typedef struct
+	{
+		arena_chunk_t* chunk;
+		uint8_t* ptr;
+	} arena_marker_t;
+
+	/**
+	 * Initialize an empty arena. Memory must be added with arena_addblock() before
+	 * anything can be allocated.
+	 */
+	void arena_init(arena_t* arena);
+
+	/**
+	 * Add a region of memory to the end of the arena
+	 * @returns 0 on success, or -1 if the region is too small to be used
+	 */
+	int arena_addblock(arena_t* arena, void* addr, size_t size);
+
+	/**
+	 * Allocate memory that is suitably aligned for any type
+	 * @returns a pointer to the memory, or NULL if the arena is out of space
+	 */
+	void* arena_alloc(arena_t* arena, size_t size);
+
+	/**
+	 * Allocate memory with the requested alignment, which must be a power of two
+	 * @returns a pointer to the memory, or NULL if the arena is out of space
+	 */
+	void* arena_alloc_aligned(arena_t* arena, size_t size, size_t align);
+
+	/// Record the current position of the arena
+	arena_marker_t arena_mark(const arena_t* arena);
+
+	/**
+	 * Release everything that was allocated after the marker was taken, in O(1).
+	 * Markers taken after this one are invalidated.
+	 */
+	void arena_rollback(arena_t* arena, arena_marker_t marker);
+
+	/// Release every allocation in the arena in O(1). The regions stay in the arena.
+	void arena_reset(arena_t* arena);
+
+	/// The number of bytes that can still be allocated from the current region
+	size_t arena_remaining(const arena_t* arena);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif // ARENA_ALLOC_H_
@@ -0,0 +1,234 @@
+#include "pool_alloc.h"
+#include <assert.h>
+
+#pragma mark - Definitions -
+
+/**
+ * Simple macro for making sure memory addresses are aligned
+ * to the nearest power of two
+ */
+#ifndef align_up
+	#define align_up(num, align) (((num) + ((align)-1)) & ~((align)-1))
+#endif
+
+/*
+ * The list head packs a slot index and an ABA tag into one word, so that the lock-free
+ * variant only needs a single-word compare-and-swap. This works on every target, including
+ * 32-bit MCUs without a double-word CAS, at the cost of limiting a pool to 65534 slots there.
+ *
+ * The tag is incremented on every allocation. Without it, this interleaving would corrupt the
+ * list: thread A reads head = X and next = Y, then thread B allocates X and Y and frees X.
+ * The head is X again, so A's CAS succeeds and installs Y, which is still in use.
+ */
+#define INDEX_BITS (sizeof(uintptr_t) * 4)
+#define INDEX_MASK (((uintptr_t)1 << INDEX_BITS) - 1)
+#define MAX_SLOT_COUNT (INDEX_MASK - 1)
+
+#pragma mark - Private Functions -
+
+static inline uintptr_t make_head(uintptr_t index, uintptr_t tag)
+{
+	return (tag << INDEX_BITS) | index;
+}
+
+static inline uintptr_t head_index(uintptr_t head)
+{
+	return head & INDEX_MASK;
+}
+
+static inline uintptr_t head_tag(uintptr_t head)
+{
+	return head >> INDEX_BITS;
+}
+
+/// Slot indices start at 1, so that 0 can mark the end of the list
+static inline void* slot_at(const pool_t* pool, uintptr_t index)
+{
+	return pool->base + ((index - 1) * pool->slot_size);
+}
+
+static inline uintptr_t slot_index(const pool_t* pool, const void* ptr)
+{
+	return ((uintptr_t)((const uint8_t*)ptr - pool->base) / pool->slot_size) + 1;
+}
+
+/*
+ * In the lock-free variant, a thread may read the link of a slot that another thread has
+ * just allocated and is writing to. The value it reads is discarded because its CAS fails,
+ * but the access itself must be atomic to be well defined.
+ */
+static inline uintptr_t load_link(const void* slot)
+{
+	return __atomic_load_n((const uintptr_t*)slot, __ATOMIC_RELAXED);
+}
+
+static inline void store_link(void* slot, uintptr_t index)
+{
+	__atomic_store_n((uintptr_t*)slot, index, __ATOMIC_RELAXED);
+}
+
+#pragma mark - APIs -
+
+int pool_init(pool_t* pool, void* region, size_t region_size, size_t slot_size, size_t align)
+{
+	uintptr_t start;
+	uintptr_t end;
+	size_t count;
+
+	if(!pool || !region || slot_size == 0 || (align & (align - 1)))
+	{
+		return -1;
+	}
+
+	// Free slots store a link in their first word, which must be aligned
+	if(align < sizeof(uintptr_t))
+	{
+		align = sizeof(uintptr_t);
+	}
+
+	if(slot_size < sizeof(uintptr_t))
+	{
+		slot_size = sizeof(uintptr_t);
+	}
+
+	slot_size = align_up(slot_size, align);
+	start = align_up((uintptr_t)region, align);
+	end = (uintptr_t)region + region_size;
+
+	if(start >= end || (end - start) < slot_size)
+	{
+		return -1;
+	}
+
+	count = (end - start) / slot_size;
+	if(count > MAX_SLOT_COUNT)
+	{
+		count = MAX_SLOT_COUNT;
+	}
+
+	pool->base = (uint8_t*)start;
+	pool->slot_size = slot_size;
+	pool->slot_count = count;
+
+	// Link the slots in address order, so that a new pool hands them out sequentially
+	for(uintptr_t i = 1; i < count; i++)
+	{
+		store_link(slot_at(pool, i), i + 1);
+	}
+
+	store_link(slot_at(pool, count), 0);
+	atomic_init(&pool->head, make_head(1, 0));
+
+	return 0;
+}
+
+void* pool_alloc(pool_t* pool)
+{
+	uintptr_t head;
+	void* slot;
+
+	assert(pool);
+
+	head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+	if(head_index(head) == 0)
+	{
+		return NULL;
+	}
+
+	slot = slot_at(pool, head_index(head));
+	atomic_store_explicit(&pool->head, make_head(load_link(slot), head_tag(head) + 1),
+						  memory_order_relaxed);
+
+	return slot;
+}
+
+void pool_free(pool_t* pool, void* ptr)
+{
+	uintptr_t head;
+
+	assert(pool);
+
+	if(ptr)
+	{
+		assert(pool_owns(pool, ptr));
+
+		head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+		store_link(ptr, head_index(head));
+		atomic_store_explicit(&pool->head, make_head(slot_index(pool, ptr), head_tag(head)),
+							  memory_order_relaxed);
+	}
+}
+
+void* pool_alloc_lockfree(pool_t* pool)
+{
+	uintptr_t head;
+	uintptr_t next;
+	void* slot;
+
+	assert(pool);
+
+	// Acquire pairs with the release in pool_free_lockfree, so the link we read is current
+	head = atomic_load_explicit(&pool->head, memory_order_acquire);
+
+	do
+	{
+		if(head_index(head) == 0)
+		{
+			return NULL;
+		}
+
+		slot = slot_at(pool, head_index(head));
+		next = make_head(load_link(slot), head_tag(head) + 1);
+	} while(!atomic_compare_exchange_weak_explicit(&pool->head, &head, next,
+												   memory_order_acquire, memory_order_acquire));
+
+	return slot;
+}
+
+void pool_free_lockfree(pool_t* pool, void* ptr)
+{
+	uintptr_t head;
+	uintptr_t index;
+
+	assert(pool);
+
+	if(ptr)
+	{
+		assert(pool_owns(pool, ptr));
+
+		index = slot_index(pool, ptr);
+		head = atomic_load_explicit(&pool->head, memory_order_relaxed);
+
+		// Pushing can't suffer from ABA, so the tag is left unchanged
+		do
+		{
+			store_link(ptr, head_index(head));
+		} while(!atomic_compare_exchange_weak_explicit(&pool->head, &head,
+													   make_head(index, head_tag(head)),
+													   memory_order_release, memory_order_relaxed));
+	}
+}
+
+size_t pool_capacity(const pool_t* pool)
+{
+	assert(pool);
+
+	return pool->slot_count;
+}
+
+size_t pool_slot_size(const pool_t* pool)
+{
+	assert(pool);
+
+	return pool->slot_size;
+}
+
+bool pool_owns(const pool_t* pool, const void* ptr)
+{
+	const uint8_t* p = ptr;
+
+	assert(pool);
+
+	return (p >= pool->base) && (p < pool->base + (pool->slot_count * pool->slot_size)) &&
+		   (((size_t)(p - pool->base) % pool->slot_size) == 0);
+}
@@ -0,0 +1,90 @@
+#ifndef POOL_ALLOC_H_
+#define POOL_ALLOC_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif //__cplusplus
+
+	/**
+	 * Fixed-size object pool
+	 *
+	 * A pool carves a caller-supplied region into equally sized slots, and hands them out
+	 * in O(1). Free slots are kept on an intrusive singly linked list: the first word of each
+	 * free slot holds the link to the next one, so the pool needs no memory of its own.
+	 *
+	 * Use a pool for objects that are created and destroyed often, like message buffers,
+	 * so that they don't fragment the general-purpose heap.
+	 *
+	 * pool_alloc() and pool_free() may only be used from one thread at a time.
+	 * pool_alloc_lockfree() and pool_free_lockfree() may be called from any number of
+	 * threads at once. Use one pair or the other for a given pool, not both.
+	 *
+	 * The contents of this struct are private; it is only declared here so that
+	 * pools can be statically allocated.
+	 */
+	typedef struct
+	{
+		uint8_t* base;
+		size_t slot_size;
+		size_t slot_count;
+
+		/**
+		 * The first free slot, tagged to prevent ABA problems in the lock-free variant.
+		 * The low half holds the slot index + 1 (0 for an empty pool), and the high half
+		 * holds a counter that changes every time a slot is allocated.
+		 */
+		atomic_uintptr_t head;
+	} pool_t;
+
+	/**
+	 * Initialize a pool
+	 *
+	 * @param pool The pool to initialize
+	 * @param region The memory that will hold the slots. It must outlive the pool.
+	 * @param region_size The size of region in bytes
+	 * @param slot_size The size of each object. Rounded up to a multiple of align.
+	 * @param align The alignment of each object. Must be a power of two, or 0 for pointer
+	 *	alignment.
+	 * @returns 0 on success, or -1 if the arguments are invalid or the region can't hold a
+	 *	single slot.
+	 */
+	int pool_init(pool_t* pool, void* region, size_t region_size, size_t slot_size,
+				  size_t align);
+
+	/**
+	 * Allocate a slot from the pool.
+	 * @returns a pointer to the slot, or NULL if the pool is empty
+	 */
+	void* pool_alloc(pool_t* pool);
+
+	/**
+	 * Return a slot to the pool. ptr must have come from this pool, or be NULL.
+	 */
+	void pool_free(pool_t* pool, void* ptr);
+
+	/// Thread-safe version of pool_alloc(), using a compare-and-swap on the tagged list head
+	void* pool_alloc_lockfree(pool_t* pool);
+
+	/// Thread-safe version of pool_free(), using a compare-and-swap on the tagged list head
+	void pool_free_lockfree(pool_t* pool, void* ptr);
+
+	/// The number of slots in the pool
+	size_t pool_capacity(const pool_t* pool);
+
+	/// The size of each slot, after rounding up for alignment
+	size_t pool_slot_size(const pool_t* pool);
+
+	/// Check whether ptr points to a slot in this pool
+	bool pool_owns(const pool_t* pool, const void* ptr);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif // POOL_ALLOC_H_
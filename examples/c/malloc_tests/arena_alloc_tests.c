@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdalign.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "malloc/arena_alloc.h"
+
+#define REGION_SIZE 1024
+
+static _Alignas(64) uint8_t region_a_[REGION_SIZE];
+static _Alignas(64) uint8_t region_b_[REGION_SIZE];
+static arena_t arena_;
+
+#pragma mark - Helpers -
+
+static bool in_region(const void* p, size_t size, const uint8_t* region)
+{
+	const uint8_t* b = p;
+
+	return (b >= region) && (b + size <= region + REGION_SIZE);
+}
+
+static int arena_setup(void** state)
+{
+	(void)state;
+
+	arena_init(&arena_);
+
+	return 0;
+}
+
+#pragma mark - Tests -
+
+static void arena_empty_test(void** state)
+{
+	(void)state;
+
+	assert_null(arena_alloc(&arena_, 1));
+	assert_int_equal(0, arena_remaining(&arena_));
+
+	// Too small to hold anything
+	assert_int_equal(-1, arena_addblock(&arena_, region_a_, sizeof(arena_chunk_t)));
+	assert_int_equal(-1, arena_addblock(&arena_, NULL, REGION_SIZE));
+	assert_null(arena_alloc(&arena_, 1));
+}
+
+static void arena_alloc_test(void** state)
+{
+	uint8_t* p[4];
+	(void)state;
+
+	assert_int_equal(0, arena_addblock(&arena_, region_a_, REGION_SIZE));
+	assert_null(arena_alloc(&arena_, 0));
+
+	for(int i = 0; i < 4; i++)
+	{
+		p[i] = arena_alloc(&arena_, 10);
+		assert_non_null(p[i]);
+		assert_true(in_region(p[i], 10, region_a_));
+		assert_int_equal(0, (uintptr_t)p[i] & (alignof(max_align_t) - 1));
+		memset(p[i], i, 10);
+	}
+
+	// Allocations are handed out in address order, and don't overlap
+	for(int i = 1; i < 4; i++)
+	{
+		assert_true(p[i] >= p[i - 1] + 10);
+	}
+
+	for(int i = 0; i < 4; i++)
+	{
+		for(int j = 0; j < 10; j++)
+		{
+			assert_int_equal(i, p[i][j]);
+		}
+	}
+}
+
+static void arena_aligned_test(void** state)
+{
+	(void)state;
+
+	assert_int_equal(0, arena_addblock(&arena_, region_a_ + 1, REGION_SIZE - 1));
+
+	for(size_t align = 1; align <= 256; align <<= 1)
+	{
+		uint8_t* p = arena_alloc_aligned(&arena_, 3, align);
+
+		assert_non_null(p);
+		assert_int_equal(0, (uintptr_t)p & (align - 1));
+	}
+}
+
+static void arena_exhaustion_test(void** state)
+{
+	size_t remaining;
+	(void)state;
+
+	assert_int_equal(0, arena_addblock(&arena_, region_a_, REGION_SIZE));
+	remaining = arena_remaining(&arena_);
+
+	// A failed allocation leaves the arena unchanged
+	assert_null(arena_alloc_aligned(&arena_, remaining + 1, 1));
+	assert_int_equal(remaining, arena_remaining(&arena_));
+
+	assert_non_null(arena_alloc_aligned(&arena_, remaining, 1));
+	assert_int_equal(0, arena_remaining(&arena_));
+	assert_null(arena_alloc_aligned(&arena_, 1, 1));
+}
+
+static void arena_chained_regions_test(void** state)
+{
+	void* p;
+	(void)state;
+
+	assert_int_equal(0, arena_addblock(&arena_, region_a_, REGION_SIZE));
+	assert_int_equal(0, arena_addblock(&arena_, region_b_, REGION_SIZE));
+
+	p = arena_alloc(&arena_, REGION_SIZE / 2);
+	assert_true(in_region(p, REGION_SIZE / 2, region_a_));
+
+	// Doesn't fit in the rest of the first region
+	p = arena_alloc(&arena_, REGION_SIZE * 3 / 4);
+	assert_true(in_region(p, REGION_SIZE * 3 / 4, region_b_));
+
+	// Too big for any region
+	assert_null(arena_alloc(&arena_, REGION_SIZE));
+	assert_non_null(arena_alloc(&arena_, 16));
+}
+
+static void arena_marker_test(void** state)
+{
+	arena_marker_t start;
+	arena_marker_t middle;
+	void* before;
+	void* p;
+	(void)state;
+
+	// A marker taken before memory is added rolls back to the start
+	start = arena_mark(&arena_);
+
+	assert_int_equal(0, arena_addblock(&arena_, region_a_, REGION_SIZE));
+	assert_int_equal(0, arena_addblock(&arena_, region_b_, REGION_SIZE));
+
+	before = arena_alloc(&arena_, 64);
+	middle = arena_mark(&arena_);
+	p = arena_alloc(&arena_, 64);
+
+	// Move into the second region, then roll back across the region boundary
+	assert_true(in_region(arena_alloc(&arena_, REGION_SIZE - 64), REGION_SIZE - 64, region_b_));
+
+	arena_rollback(&arena_, middle);
+	assert_ptr_equal(p, arena_alloc(&arena_, 64));
+
+	arena_rollback(&arena_, start);
+	assert_ptr_equal(before, arena_alloc(&arena_, 64));
+}
+
+static void arena_reset_test(void** state)
+{
+	void* first;
+	(void)state;
+
+	assert_int_equal(0, arena_addblock(&arena_, region_a_, REGION_SIZE));
+	assert_int_equal(0, arena_addblock(&arena_, region_b_, REGION_SIZE));
+
+	first = arena_alloc(&arena_, 32);
+
+	while(arena_alloc(&arena_, 100))
+	{
+	}
+
+	arena_reset(&arena_);
+	assert_ptr_equal(first, arena_alloc(&arena_, 32));
+}
+
+#pragma mark - Public Functions -
+
+int arena_alloc_test_suite(void)
+{
+	const struct CMUnitTest arena_alloc_tests[] = {
+		cmocka_unit_test_setup(arena_empty_test, arena_setup),
+		cmocka_unit_test_setup(arena_alloc_test, arena_setup),
+		cmocka_unit_test_setup(arena_aligned_test, arena_setup),
+		cmocka_unit_test_setup(arena_exhaustion_test, arena_setup),
+		cmocka_unit_test_setup(arena_chained_regions_test, arena_setup),
+		cmocka_unit_test_setup(arena_marker_test, arena_setup),
+		cmocka_unit_test_setup(arena_reset_test, arena_setup),
+	};
+
+	return cmocka_run_group_tests_name("arena_alloc", arena_alloc_tests, NULL, NULL);
+}
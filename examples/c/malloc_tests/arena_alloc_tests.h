@@ -0,0 +1,11 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef ARENA_ALLOC_TESTS_H_
+#define ARENA_ALLOC_TESTS_H_
+
+int arena_alloc_test_suite(void);
+
+#endif // ARENA_ALLOC_TESTS_H_
@@ -0,0 +1,269 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+#include "malloc/pool_alloc.h"
+
+#define REGION_SIZE 4096
+#define THREAD_COUNT 4
+#define ITERATIONS_PER_THREAD 20000
+#define SLOTS_PER_THREAD 8
+
+static _Alignas(64) uint8_t region_[REGION_SIZE];
+static pool_t pool_;
+
+#pragma mark - Helpers -
+
+/// Fill every slot and check that none of them overlap or leave the region
+static size_t drain_pool(void** slots, size_t max)
+{
+	size_t count = 0;
+	void* p;
+
+	while((p = pool_alloc(&pool_)) != NULL)
+	{
+		assert_true(count < max);
+		assert_true(pool_owns(&pool_, p));
+		assert_true((uint8_t*)p >= region_);
+		assert_true((uint8_t*)p + pool_slot_size(&pool_) <= region_ + REGION_SIZE);
+		memset(p, (int)count, pool_slot_size(&pool_));
+		slots[count++] = p;
+	}
+
+	// Nothing was overwritten by a later allocation
+	for(size_t i = 0; i < count; i++)
+	{
+		for(size_t j = 0; j < pool_slot_size(&pool_); j++)
+		{
+			assert_int_equal((uint8_t)i, ((uint8_t*)slots[i])[j]);
+		}
+	}
+
+	return count;
+}
+
+#pragma mark - Tests -
+
+static void pool_init_test(void** state)
+{
+	(void)state;
+
+	assert_int_equal(0, pool_init(&pool_, region_, REGION_SIZE, 32, 0));
+	assert_int_equal(32, pool_slot_size(&pool_));
+	assert_int_equal(REGION_SIZE / 32, pool_capacity(&pool_));
+
+	// Tiny objects still need room for the free list link
+	assert_int_equal(0, pool_init(&pool_, region_, REGION_SIZE, 1, 0));
+	assert_int_equal(sizeof(uintptr_t), pool_slot_size(&pool_));
+
+	// Sizes are rounded up to the alignment
+	assert_int_equal(0, pool_init(&pool_, region_, REGION_SIZE, 40, 32));
+	assert_int_equal(64, pool_slot_size(&pool_));
+}
+
+static void pool_init_invalid_test(void** state)
+{
+	(void)state;
+
+	assert_int_equal(-1, pool_init(NULL, region_, REGION_SIZE, 32, 0));
+	assert_int_equal(-1, pool_init(&pool_, NULL, REGION_SIZE, 32, 0));
+	assert_int_equal(-1, pool_init(&pool_, region_, REGION_SIZE, 0, 0));
+	assert_int_equal(-1, pool_init(&pool_, region_, REGION_SIZE, 32, 24));
+	assert_int_equal(-1, pool_init(&pool_, region_, 16, 32, 0));
+
+	// Aligning the start of the region leaves no room for a slot
+	assert_int_equal(-1, pool_init(&pool_, region_ + 1, 64, 32, 64));
+}
+
+static void pool_alloc_free_test(void** state)
+{
+	void* slots[REGION_SIZE / 64];
+	size_t count;
+	(void)state;
+
+	assert_int_equal(0, pool_init(&pool_, region_, REGION_SIZE, 64, 0));
+
+	count = drain_pool(slots, REGION_SIZE / 64);
+	assert_int_equal(pool_capacity(&pool_), count);
+	assert_null(pool_alloc(&pool_));
+
+	// A freed slot is the next one allocated
+	pool_free(&pool_, slots[3]);
+	assert_ptr_equal(slots[3], pool_alloc(&pool_));
+
+	for(size_t i = 0; i < count; i++)
+	{
+		pool_free(&pool_, slots[i]);
+	}
+
+	// Every slot can be allocated again
+	assert_int_equal(count, drain_pool(slots, REGION_SIZE / 64));
+
+	pool_free(&pool_, NULL);
+}
+
+static void pool_alignment_test(void** state)
+{
+	static const size_t alignments[] = {0, 8, 16, 32, 64, 128};
+	void* slots[REGION_SIZE / 8];
+	(void)state;
+
+	for(size_t a = 0; a < sizeof(alignments) / sizeof(alignments[0]); a++)
+	{
+		size_t align = alignments[a] ? alignments[a] : sizeof(void*);
+
+		// Start the region off by one byte, so the pool has to align it
+		assert_int_equal(0, pool_init(&pool_, region_ + 1, REGION_SIZE - 1, 24, alignments[a]));
+
+		size_t count = drain_pool(slots, REGION_SIZE / 8);
+		assert_int_equal(pool_capacity(&pool_), count);
+
+		for(size_t i = 0; i < count; i++)
+		{
+			assert_int_equal(0, (uintptr_t)slots[i] & (align - 1));
+		}
+	}
+}
+
+static void pool_owns_test(void** state)
+{
+	void* p;
+	(void)state;
+
+	assert_int_equal(0, pool_init(&pool_, region_, REGION_SIZE, 32, 0));
+	p = pool_alloc(&pool_);
+
+	assert_true(pool_owns(&pool_, p));
+	assert_false(pool_owns(&pool_, (uint8_t*)p + 1));
+	assert_false(pool_owns(&pool_, region_ + REGION_SIZE));
+	assert_false(pool_owns(&pool_, &pool_));
+}
+
+static void pool_lockfree_single_thread_test(void** state)
+{
+	void* slots[REGION_SIZE / 32];
+	size_t count = 0;
+	void* p;
+	(void)state;
+
+	assert_int_equal(0, pool_init(&pool_, region_, REGION_SIZE, 32, 0));
+
+	while((p = pool_alloc_lockfree(&pool_)) != NULL)
+	{
+		slots[count++] = p;
+	}
+
+	assert_int_equal(pool_capacity(&pool_), count);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		pool_free_lockfree(&pool_, slots[i]);
+	}
+
+	assert_int_equal(count, drain_pool(slots, REGION_SIZE / 32));
+}
+
+#pragma mark - Multi-threaded Tests -
+
+// Worker threads only count errors: cmocka assertions must run on the test thread
+static atomic_uint thread_errors_;
+
+/// Each thread holds a few slots at a time, stamps them with its ID, and checks that no
+/// other thread was handed the same slot before freeing it.
+static void* lockfree_worker(void* arg)
+{
+	uintptr_t id = (uintptr_t)arg;
+	uintptr_t* held[SLOTS_PER_THREAD] = {NULL};
+
+	for(unsigned i = 0; i < ITERATIONS_PER_THREAD; i++)
+	{
+		unsigned s = i % SLOTS_PER_THREAD;
+
+		if(held[s])
+		{
+			if(held[s][1] != id || held[s][2] != i - SLOTS_PER_THREAD)
+			{
+				atomic_fetch_add(&thread_errors_, 1);
+			}
+
+			pool_free_lockfree(&pool_, held[s]);
+			held[s] = NULL;
+		}
+
+		held[s] = pool_alloc_lockfree(&pool_);
+
+		if(held[s])
+		{
+			// The first word is the free list link, so stamp the words after it
+			held[s][1] = id;
+			held[s][2] = i;
+		}
+		else
+		{
+			sched_yield();
+		}
+	}
+
+	for(unsigned s = 0; s < SLOTS_PER_THREAD; s++)
+	{
+		pool_free_lockfree(&pool_, held[s]);
+	}
+
+	return NULL;
+}
+
+static void pool_lockfree_threads_test(void** state)
+{
+	pthread_t threads[THREAD_COUNT];
+	void* slots[THREAD_COUNT * SLOTS_PER_THREAD];
+	(void)state;
+
+	// Fewer slots than the threads want in total, so they compete for the same ones
+	assert_int_equal(0, pool_init(&pool_, region_, (THREAD_COUNT * SLOTS_PER_THREAD / 2) * 32, 32, 0));
+	atomic_store(&thread_errors_, 0);
+
+	for(uintptr_t i = 0; i < THREAD_COUNT; i++)
+	{
+		assert_int_equal(0, pthread_create(&threads[i], NULL, lockfree_worker, (void*)(i + 1)));
+	}
+
+	for(unsigned i = 0; i < THREAD_COUNT; i++)
+	{
+		pthread_join(threads[i], NULL);
+	}
+
+	assert_int_equal(0, atomic_load(&thread_errors_));
+
+	// No slot was lost or duplicated
+	assert_int_equal(pool_capacity(&pool_), drain_pool(slots, THREAD_COUNT * SLOTS_PER_THREAD));
+}
+
+#pragma mark - Public Functions -
+
+int pool_alloc_test_suite(void)
+{
+	const struct CMUnitTest pool_alloc_tests[] = {
+		cmocka_unit_test(pool_init_test),
+		cmocka_unit_test(pool_init_invalid_test),
+		cmocka_unit_test(pool_alloc_free_test),
+		cmocka_unit_test(pool_alignment_test),
+		cmocka_unit_test(pool_owns_test),
+		cmocka_unit_test(pool_lockfree_single_thread_test),
+		cmocka_unit_test(pool_lockfree_threads_test),
+	};
+
+	return cmocka_run_group_tests_name("pool_alloc", pool_alloc_tests, NULL, NULL);
+}
@@ -0,0 +1,11 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef POOL_ALLOC_TESTS_H_
+#define POOL_ALLOC_TESTS_H_
+
+int pool_alloc_test_suite(void);
+
+#endif // POOL_ALLOC_TESTS_H_
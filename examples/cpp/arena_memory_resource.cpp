@@ -0,0 +1,123 @@
+// Copyright 2021 Embedded Artistry LLC
+
+#include <cstdint>
+#include <map>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "memory_resource/arena_memory_resource.hpp"
+
+namespace
+{
+constexpr size_t kArenaSize = 4096;
+
+bool in_buffer(const void* p, const uint8_t* buffer, size_t size)
+{
+	auto b = static_cast<const uint8_t*>(p);
+	return b >= buffer && b < buffer + size;
+}
+} // namespace
+
+TEST_CASE("Arena memory resource")
+{
+	alignas(64) static uint8_t buffer[kArenaSize];
+	arena_memory_resource arena(buffer, sizeof(buffer));
+
+	SECTION("Containers allocate from the arena")
+	{
+		std::pmr::vector<uint32_t> v(&arena);
+
+		for(uint32_t i = 0; i < 100; i++)
+		{
+			v.push_back(i);
+		}
+
+		CHECK(in_buffer(v.data(), buffer, sizeof(buffer)));
+		CHECK(v[99] == 99);
+
+		std::pmr::string s("a string that is too long for the small string buffer", &arena);
+		CHECK(in_buffer(s.data(), buffer, sizeof(buffer)));
+	}
+
+	SECTION("Allocations honor the requested alignment")
+	{
+		for(size_t align = 1; align <= 64; align <<= 1)
+		{
+			void* p = arena.allocate(3, align);
+			CHECK((reinterpret_cast<uintptr_t>(p) & (align - 1)) == 0);
+		}
+	}
+
+#if defined(__cpp_exceptions)
+	// Without exceptions, running out of space aborts
+	SECTION("Running out of space throws std::bad_alloc")
+	{
+		CHECK_THROWS_AS(arena.allocate(kArenaSize), std::bad_alloc);
+
+		// The failed request didn't use up the arena
+		CHECK_NOTHROW(arena.allocate(kArenaSize / 2));
+	}
+#endif
+
+	SECTION("Reset makes the whole arena available again")
+	{
+		auto remaining = arena.remaining();
+		void* first = arena.allocate(128);
+
+		CHECK(arena.allocate(256) != nullptr);
+		arena.reset();
+
+		CHECK(arena.remaining() == remaining);
+		CHECK(arena.allocate(128) == first);
+	}
+
+	SECTION("Only equal to itself")
+	{
+		arena_memory_resource other;
+
+		CHECK(arena.is_equal(arena));
+		CHECK_FALSE(arena.is_equal(other));
+	}
+}
+
+TEST_CASE("Arena scopes release their allocations")
+{
+	alignas(64) static uint8_t buffer[kArenaSize];
+	arena_memory_resource arena(buffer, sizeof(buffer));
+	auto remaining = arena.remaining();
+
+	{
+		arena_scope outer(arena);
+		std::pmr::map<int, std::pmr::string> m(&arena);
+
+		m.emplace(1, "one");
+
+		{
+			arena_scope inner(arena);
+			std::pmr::vector<int> v(100, 0, &arena);
+			CHECK(arena.remaining() < remaining);
+		}
+
+		// The inner scope's memory is reused, and the map's is untouched
+		m.emplace(2, "two");
+		CHECK(m.at(1) == "one");
+	}
+
+	CHECK(arena.remaining() == remaining);
+}
+
+TEST_CASE("Arena memory resource chains regions")
+{
+	alignas(64) static uint8_t first[256];
+	alignas(64) static uint8_t second[kArenaSize];
+	arena_memory_resource arena(first, sizeof(first));
+
+	CHECK(arena.add_block(second, sizeof(second)));
+
+	std::pmr::vector<uint8_t> v(&arena);
+	v.reserve(1024);
+
+	CHECK(in_buffer(v.data(), second, sizeof(second)));
+}
@@ -1,6 +1,8 @@
 // Copyright 2021 Embedded Artistry LLC
 
+#include <chrono>
 #include <cstdio>
+#include <thread>
 #include <catch2/catch_test_macros.hpp>
 #include "circular_buffer/circular_buffer.hpp"
 
@@ -79,3 +81,52 @@ TEST_CASE("Circular buffer operations")
 		}
 	}
 }
+
+TEST_CASE("Circular buffer blocking operations")
+{
+	using namespace std::chrono_literals;
+	circular_buffer<uint32_t, 10> cbuf;
+
+	SECTION("get_wait times out on an empty buffer")
+	{
+		auto start = std::chrono::steady_clock::now();
+		auto value = cbuf.get_wait(10ms);
+
+		CHECK(value.has_value() == false);
+		CHECK(std::chrono::steady_clock::now() - start >= 10ms);
+	}
+
+	SECTION("put_wait times out on a full buffer instead of overwriting")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			CHECK(cbuf.put_wait(i, 0ms) == true);
+		}
+
+		CHECK(cbuf.put_wait(cbuf.capacity(), 10ms) == false);
+
+		auto value = cbuf.get();
+		CHECK(value.has_value() == true);
+		CHECK(0 == value.value());
+	}
+
+	SECTION("Blocking transfer between two threads")
+	{
+		constexpr uint32_t kCount = 10000;
+
+		std::thread producer([&cbuf] {
+			for(uint32_t i = 0; i < kCount; i++)
+			{
+				cbuf.put_wait(i);
+			}
+		});
+
+		for(uint32_t i = 0; i < kCount; i++)
+		{
+			CHECK(i == cbuf.get_wait());
+		}
+
+		producer.join();
+		CHECK(cbuf.empty() == true);
+	}
+}
@@ -2,8 +2,11 @@
 #define CIRCULAR_BUFFER_HPP_
 
 #include <array>
+#include <chrono>
 #include <mutex>
 #include <optional>
+#include <utility>
+#include "event_count.hpp"
 
 template<class T, size_t TElemCount>
 class circular_buffer
@@ -25,6 +28,29 @@ class circular_buffer
 		head_ = (head_ + 1) % TElemCount;
 
 		full_ = head_ == tail_;
+
+		not_empty_.notify_all();
+	}
+
+	/// Add an item to the buffer, sleeping while the buffer is full.
+	/// Unlike put(), this never overwrites data.
+	/// Returns false if the buffer is still full after the timeout.
+	template<class Rep, class Period>
+	bool put_wait(T item, const std::chrono::duration<Rep, Period>& timeout) noexcept
+	{
+		return not_full_.wait_for(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+								  [this, &item] {
+									  return try_put_(item);
+								  });
+	}
+
+	/// Add an item to the buffer, sleeping until there is room.
+	/// Unlike put(), this never overwrites data.
+	void put_wait(T item) noexcept
+	{
+		not_full_.wait_for(std::chrono::nanoseconds::max(), [this, &item] {
+			return try_put_(item);
+		});
 	}
 
 	std::optional<T> get() const noexcept
@@ -41,14 +67,47 @@ class circular_buffer
 		full_ = false;
 		tail_ = (tail_ + 1) % TElemCount;
 
+		not_full_.notify_all();
+
 		return val;
 	}
 
+	/// Remove the oldest item from the buffer, sleeping while the buffer is empty.
+	/// Returns std::nullopt if the buffer is still empty after the timeout.
+	template<class Rep, class Period>
+	std::optional<T> get_wait(const std::chrono::duration<Rep, Period>& timeout) const noexcept
+	{
+		std::optional<T> val;
+
+		not_empty_.wait_for(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+							[this, &val] {
+								val = get();
+								return val.has_value();
+							});
+
+		return val;
+	}
+
+	/// Remove the oldest item from the buffer, sleeping until one is available.
+	T get_wait() const noexcept
+	{
+		std::optional<T> val;
+
+		not_empty_.wait_for(std::chrono::nanoseconds::max(), [this, &val] {
+			val = get();
+			return val.has_value();
+		});
+
+		return std::move(*val);
+	}
+
 	void reset() noexcept
 	{
 		std::lock_guard<std::recursive_mutex> lock(mutex_);
 		head_ = tail_;
 		full_ = false;
+
+		not_full_.notify_all();
 	}
 
 	bool empty() const noexcept
@@ -95,7 +154,25 @@ class circular_buffer
 	}
 
   private:
+	/// Moves from item only if it was added to the buffer
+	bool try_put_(T& item) noexcept
+	{
+		std::lock_guard<std::recursive_mutex> lock(mutex_);
+
+		if(full_)
+		{
+			return false;
+		}
+
+		put(std::move(item));
+
+		return true;
+	}
+
 	mutable std::recursive_mutex mutex_;
+	/// Sleeping threads wait on these without holding mutex_
+	mutable event_count not_empty_;
+	mutable event_count not_full_;
 	mutable std::array<T, TElemCount> buf_;
 	mutable size_t head_ = 0;
 	mutable size_t tail_ = 0;
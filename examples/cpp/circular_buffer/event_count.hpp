@@ -0,0 +1,172 @@
+#ifndef EVENT_COUNT_HPP_
+#define EVENT_COUNT_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#if defined(__linux__)
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+/** Lets threads sleep until a lock-free condition might have changed
+ *
+ * The circular buffers use this to block in get_wait() while the buffer is empty, and in
+ * put_wait() while it is full. Waiters only park when their operation fails, and notifiers
+ * only make a system call when a thread is actually parked. While nobody is waiting,
+ * notify_all() is a fence and a load, so the non-blocking put() and get() stay wait-free.
+ *
+ * A waiter registers itself and then retries its operation before parking. A notifier publishes
+ * its state change and then checks for registered waiters. The two seq_cst fences guarantee
+ * that either the waiter's retry sees the new state, or the notifier sees the waiter and wakes
+ * it. The epoch counter closes the gap between the waiter's retry and the moment it parks:
+ * parking fails immediately if a notification arrived in between.
+ *
+ * On Linux, waiters park on the epoch counter with a futex. Other systems fall back to a
+ * mutex and condition variable, which are only touched when a thread is parked.
+ */
+class event_count
+{
+  public:
+	explicit event_count() = default;
+
+	/** Call try_op until it succeeds, sleeping between attempts.
+	 *
+	 * @param timeout How long to wait. std::chrono::nanoseconds::max() waits forever.
+	 * @param try_op A callable returning true once the operation succeeded.
+	 * @returns true if try_op succeeded, false if the timeout expired first.
+	 */
+	template<class TTryOp>
+	bool wait_for(std::chrono::nanoseconds timeout, TTryOp try_op) noexcept
+	{
+		// Fast path: no registration, no clock reads
+		if(try_op())
+		{
+			return true;
+		}
+
+		const bool forever = timeout == std::chrono::nanoseconds::max();
+		const auto deadline = forever ? std::chrono::steady_clock::time_point::max()
+									  : std::chrono::steady_clock::now() + timeout;
+
+		while(true)
+		{
+			auto key = prepare_wait();
+
+			if(try_op())
+			{
+				cancel_wait();
+				return true;
+			}
+
+			auto remaining = forever ? std::chrono::nanoseconds::max()
+									 : std::chrono::duration_cast<std::chrono::nanoseconds>(
+										   deadline - std::chrono::steady_clock::now());
+
+			if(remaining.count() <= 0)
+			{
+				cancel_wait();
+				return false;
+			}
+
+			wait(key, remaining);
+		}
+	}
+
+	/// Wake every waiting thread. Call after publishing the state change they are waiting for.
+	void notify_all() noexcept
+	{
+		// Pairs with the fence in prepare_wait()
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if(waiters_.load(std::memory_order_relaxed) != 0)
+		{
+			epoch_.fetch_add(1, std::memory_order_seq_cst);
+			wake_all();
+		}
+	}
+
+  private:
+	uint32_t prepare_wait() noexcept
+	{
+		waiters_.fetch_add(1, std::memory_order_relaxed);
+		// Pairs with the fence in notify_all()
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		// Acquire pairs with the fetch_add() in notify_all(): if this reads the new epoch, the
+		// caller's try_op() also sees the state published before it
+		return epoch_.load(std::memory_order_acquire);
+	}
+
+	void cancel_wait() noexcept
+	{
+		waiters_.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	/// Returns on notification, timeout, or spurious wakeup
+	void wait(uint32_t key, std::chrono::nanoseconds timeout) noexcept
+	{
+#if defined(__linux__)
+		struct timespec ts;
+		struct timespec* ts_ptr = nullptr;
+
+		if(timeout != std::chrono::nanoseconds::max())
+		{
+			ts.tv_sec = static_cast<time_t>(timeout.count() / 1000000000);
+			ts.tv_nsec = static_cast<long>(timeout.count() % 1000000000);
+			ts_ptr = &ts;
+		}
+
+		// Returns immediately if epoch_ no longer matches key
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAIT_PRIVATE, key, ts_ptr,
+				nullptr, 0);
+#else
+		std::unique_lock<std::mutex> lock(mutex_);
+		auto notified = [this, key] {
+			return epoch_.load(std::memory_order_relaxed) != key;
+		};
+
+		if(timeout == std::chrono::nanoseconds::max())
+		{
+			cv_.wait(lock, notified);
+		}
+		else
+		{
+			cv_.wait_for(lock, timeout, notified);
+		}
+#endif
+
+		cancel_wait();
+	}
+
+	void wake_all() noexcept
+	{
+#if defined(__linux__)
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX,
+				nullptr, nullptr, 0);
+#else
+		// Taking the lock ensures a waiter is either parked or will see the new epoch
+		std::lock_guard<std::mutex> lock(mutex_);
+		cv_.notify_all();
+#endif
+	}
+
+	static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t),
+				  "futex requires std::atomic<uint32_t> to have the layout of uint32_t");
+
+	std::atomic<uint32_t> epoch_{0};
+	std::atomic<uint32_t> waiters_{0};
+#if !defined(__linux__)
+	std::mutex mutex_;
+	std::condition_variable cv_;
+#endif
+};
+
+#endif // EVENT_COUNT_HPP_
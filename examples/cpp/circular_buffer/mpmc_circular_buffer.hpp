@@ -0,0 +1,202 @@
+#ifndef MPMC_CIRCULAR_BUFFER_HPP_
+#define MPMC_CIRCULAR_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+/** Lock-free bounded multi-producer, multi-consumer circular buffer
+ *
+ * This is a sibling of spsc_circular_buffer<T, N> for queues with any number of producers
+ * and consumers, such as a dispatch queue that is fed by several threads and drained by a
+ * pool of worker threads. The design is Dmitry Vyukov's bounded MPMC queue.
+ *
+ * Each slot carries a sequence number that says whose turn it is to use the slot:
+ *
+ *	- seq == pos: the slot is free, and the producer that claims position pos may write it
+ *	- seq == pos + 1: the slot holds data, and the consumer that claims position pos may read it
+ *
+ * Producers claim a position by advancing head_ with a CAS, write the data, and then publish
+ * the slot with a release store of the sequence number. Consumers do the same with tail_, and
+ * hand the slot back to the producers for the next lap by storing pos + TElemCount.
+ * Producers only contend with other producers (and consumers with other consumers) on the CAS;
+ * the data itself is handed over through the slot's sequence number.
+ *
+ * As with spsc_circular_buffer, put() does not overwrite old data when the buffer is full.
+ *
+ * @tparam T The type of element stored in the buffer. Must be default constructible.
+ * @tparam TElemCount The number of elements in the buffer. Must be a power of two.
+ */
+template<class T, size_t TElemCount>
+class mpmc_circular_buffer
+{
+	static_assert(TElemCount >= 2 && (TElemCount & (TElemCount - 1)) == 0,
+				  "mpmc_circular_buffer size must be a power of two");
+
+  public:
+	explicit mpmc_circular_buffer() noexcept
+	{
+		reset();
+	}
+
+	/// Add an item to the buffer. Safe to call from multiple threads.
+	/// Returns false if the buffer is full and the item was not added.
+	bool put(const T& item) noexcept
+	{
+		return put_(item);
+	}
+
+	/// Move an item into the buffer. Safe to call from multiple threads.
+	/// Returns false if the buffer is full. In that case, item is not moved from,
+	/// so the caller can retry with the same object.
+	bool put(T&& item) noexcept
+	{
+		return put_(std::move(item));
+	}
+
+	/// Remove the oldest item from the buffer. Safe to call from multiple threads.
+	/// Returns std::nullopt if the buffer is empty.
+	std::optional<T> get() noexcept
+	{
+		auto pos = tail_.load(std::memory_order_relaxed);
+		cell* c;
+
+		while(true)
+		{
+			c = &buf_[pos & kIndexMask];
+			auto seq = c->seq.load(std::memory_order_acquire);
+			auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+			if(diff == 0)
+			{
+				// The slot holds data: try to claim it. On failure, pos is reloaded.
+				if(tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				// The slot has not been written yet
+				return std::nullopt;
+			}
+			else
+			{
+				// Another consumer claimed this position first
+				pos = tail_.load(std::memory_order_relaxed);
+			}
+		}
+
+		auto val = std::move(c->data);
+		c->seq.store(pos + TElemCount, std::memory_order_release);
+
+		return val;
+	}
+
+	/// Reset the buffer to an empty state.
+	/// Not thread safe: no producer or consumer may be active.
+	void reset() noexcept
+	{
+		for(size_t i = 0; i < TElemCount; i++)
+		{
+			buf_[i].seq.store(i, std::memory_order_relaxed);
+		}
+
+		head_.store(0, std::memory_order_relaxed);
+		tail_.store(0, std::memory_order_relaxed);
+	}
+
+	/// The result is a snapshot, and may be stale by the time the caller acts on it
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	/// The result is a snapshot, and may be stale by the time the caller acts on it
+	bool full() const noexcept
+	{
+		return size() == TElemCount;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return TElemCount;
+	}
+
+	/// The result is a snapshot, and may be stale by the time the caller acts on it.
+	/// Positions that have been claimed but not yet written or read are counted as stored.
+	size_t size() const noexcept
+	{
+		// Read tail first: head can only grow, so head - tail never underflows
+		auto tail = tail_.load(std::memory_order_acquire);
+		auto head = head_.load(std::memory_order_acquire);
+		auto size = head - tail;
+
+		// Both counters may have moved on between the two loads
+		return (size > TElemCount) ? TElemCount : size;
+	}
+
+  private:
+	/// Shared implementation of the copy and move put() overloads
+	template<class U>
+	bool put_(U&& item) noexcept
+	{
+		auto pos = head_.load(std::memory_order_relaxed);
+		cell* c;
+
+		while(true)
+		{
+			c = &buf_[pos & kIndexMask];
+			auto seq = c->seq.load(std::memory_order_acquire);
+			auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+			if(diff == 0)
+			{
+				// The slot is free: try to claim it. On failure, pos is reloaded.
+				if(head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+				{
+					break;
+				}
+			}
+			else if(diff < 0)
+			{
+				// The slot still holds data from the previous lap
+				return false;
+			}
+			else
+			{
+				// Another producer claimed this position first
+				pos = head_.load(std::memory_order_relaxed);
+			}
+		}
+
+		c->data = std::forward<U>(item);
+		c->seq.store(pos + 1, std::memory_order_release);
+
+		return true;
+	}
+
+	/// Assumed cache line size. std::hardware_destructive_interference_size is not
+	/// available in all of the standard libraries we build with.
+	static constexpr size_t kCacheLineSize = 64;
+	static constexpr size_t kIndexMask = TElemCount - 1;
+
+	struct cell
+	{
+		std::atomic<size_t> seq;
+		T data;
+	};
+
+	/// Shared by all producers
+	alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+
+	/// Shared by all consumers
+	alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+
+	alignas(kCacheLineSize) std::array<cell, TElemCount> buf_{};
+};
+
+#endif // MPMC_CIRCULAR_BUFFER_HPP_
@@ -0,0 +1,210 @@
+#ifndef SPSC_CIRCULAR_BUFFER_HPP_
+#define SPSC_CIRCULAR_BUFFER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <utility>
+#include "event_count.hpp"
+
+/** Lock-free single-producer, single-consumer circular buffer
+ *
+ * This is a sibling of circular_buffer<T, N> for the common case where exactly one thread
+ * (or ISR) puts data into the buffer and exactly one thread gets data out of it. Instead of
+ * taking a mutex on every operation, the producer owns head_ and the consumer owns tail_.
+ * Each side publishes its index with a release store and observes the other side's index
+ * with an acquire load, which is enough to guarantee that a slot's contents are visible
+ * before the slot is handed over.
+ *
+ * head_ and tail_ are free-running counters. Because TElemCount is a power of two, the
+ * slot index is computed with a mask instead of a modulo, and head_ - tail_ is always the
+ * number of stored elements (even when the counters wrap). This lets us use every slot in
+ * the buffer without a separate full flag.
+ *
+ * The producer and consumer indices live on separate cache lines so that the two threads
+ * don't invalidate each other's cache line on every operation. Each side also keeps a cached
+ * copy of the other side's index, so the shared line is only read when the cached value says
+ * the buffer looks full (producer) or empty (consumer).
+ *
+ * Unlike circular_buffer<T, N>, put() does not overwrite old data when the buffer is full:
+ * doing so would require the producer to modify tail_, which belongs to the consumer.
+ *
+ * Instead of polling, the producer can block in put_wait() while the buffer is full, and the
+ * consumer can block in get_wait() while it is empty. Threads only sleep when the ring is
+ * actually full or empty (see event_count). put() and get() only check whether the other side
+ * is sleeping, so they remain wait-free.
+ *
+ * @tparam T The type of element stored in the buffer.
+ * @tparam TElemCount The number of elements in the buffer. Must be a power of two.
+ */
+template<class T, size_t TElemCount>
+class spsc_circular_buffer
+{
+	static_assert(TElemCount > 0 && (TElemCount & (TElemCount - 1)) == 0,
+				  "spsc_circular_buffer size must be a power of two");
+
+  public:
+	explicit spsc_circular_buffer() = default;
+
+	/// Producer only: add an item to the buffer.
+	/// Returns false if the buffer is full and the item was not added.
+	bool put(T item) noexcept
+	{
+		return put_(item);
+	}
+
+	/// Producer only: add an item to the buffer, sleeping while the buffer is full.
+	/// Returns false if the buffer is still full after the timeout.
+	template<class Rep, class Period>
+	bool put_wait(T item, const std::chrono::duration<Rep, Period>& timeout) noexcept
+	{
+		return not_full_.wait_for(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+								  [this, &item] {
+									  return put_(item);
+								  });
+	}
+
+	/// Producer only: add an item to the buffer, sleeping until there is room.
+	void put_wait(T item) noexcept
+	{
+		not_full_.wait_for(std::chrono::nanoseconds::max(), [this, &item] {
+			return put_(item);
+		});
+	}
+
+	/// Consumer only: remove the oldest item from the buffer.
+	/// Returns std::nullopt if the buffer is empty.
+	std::optional<T> get() noexcept
+	{
+		auto tail = tail_.load(std::memory_order_relaxed);
+
+		if(tail == head_cache_)
+		{
+			head_cache_ = head_.load(std::memory_order_acquire);
+
+			if(tail == head_cache_)
+			{
+				return std::nullopt;
+			}
+		}
+
+		auto val = std::move(buf_[tail & kIndexMask]);
+		tail_.store(tail + 1, std::memory_order_release);
+		not_full_.notify_all();
+
+		return val;
+	}
+
+	/// Consumer only: remove the oldest item from the buffer, sleeping while the buffer is empty.
+	/// Returns std::nullopt if the buffer is still empty after the timeout.
+	template<class Rep, class Period>
+	std::optional<T> get_wait(const std::chrono::duration<Rep, Period>& timeout) noexcept
+	{
+		std::optional<T> val;
+
+		not_empty_.wait_for(std::chrono::duration_cast<std::chrono::nanoseconds>(timeout),
+							[this, &val] {
+								val = get();
+								return val.has_value();
+							});
+
+		return val;
+	}
+
+	/// Consumer only: remove the oldest item from the buffer, sleeping until one is available.
+	T get_wait() noexcept
+	{
+		std::optional<T> val;
+
+		not_empty_.wait_for(std::chrono::nanoseconds::max(), [this, &val] {
+			val = get();
+			return val.has_value();
+		});
+
+		return std::move(*val);
+	}
+
+	/// Reset the buffer to an empty state.
+	/// Not thread safe: neither the producer nor the consumer may be active.
+	void reset() noexcept
+	{
+		head_.store(0, std::memory_order_relaxed);
+		tail_.store(0, std::memory_order_relaxed);
+		head_cache_ = 0;
+		tail_cache_ = 0;
+	}
+
+	/// The result is a snapshot, and may be stale by the time the caller acts on it
+	bool empty() const noexcept
+	{
+		return size() == 0;
+	}
+
+	/// The result is a snapshot, and may be stale by the time the caller acts on it
+	bool full() const noexcept
+	{
+		return size() == TElemCount;
+	}
+
+	size_t capacity() const noexcept
+	{
+		return TElemCount;
+	}
+
+	/// The result is a snapshot, and may be stale by the time the caller acts on it
+	size_t size() const noexcept
+	{
+		// Read tail first: head can only grow, so head - tail never underflows
+		auto tail = tail_.load(std::memory_order_acquire);
+		auto head = head_.load(std::memory_order_acquire);
+
+		return head - tail;
+	}
+
+  private:
+	/// Moves from item only if it was added to the buffer
+	bool put_(T& item) noexcept
+	{
+		auto head = head_.load(std::memory_order_relaxed);
+
+		if(head - tail_cache_ == TElemCount)
+		{
+			tail_cache_ = tail_.load(std::memory_order_acquire);
+
+			if(head - tail_cache_ == TElemCount)
+			{
+				return false;
+			}
+		}
+
+		buf_[head & kIndexMask] = std::move(item);
+		head_.store(head + 1, std::memory_order_release);
+		not_empty_.notify_all();
+
+		return true;
+	}
+
+	/// Assumed cache line size. std::hardware_destructive_interference_size is not
+	/// available in all of the standard libraries we build with.
+	static constexpr size_t kCacheLineSize = 64;
+	static constexpr size_t kIndexMask = TElemCount - 1;
+
+	/// Producer-owned cache line
+	alignas(kCacheLineSize) std::atomic<size_t> head_{0};
+	size_t tail_cache_ = 0;
+
+	/// Consumer-owned cache line
+	alignas(kCacheLineSize) std::atomic<size_t> tail_{0};
+	size_t head_cache_ = 0;
+
+	/// The waiter counts are read on every put and get, but only written when a thread
+	/// goes to sleep. Keeping them on their own lines lets both threads keep a shared copy.
+	alignas(kCacheLineSize) event_count not_empty_;
+	alignas(kCacheLineSize) event_count not_full_;
+
+	alignas(kCacheLineSize) std::array<T, TElemCount> buf_{};
+};
+
+#endif // SPSC_CIRCULAR_BUFFER_HPP_
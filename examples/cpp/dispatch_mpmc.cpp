@@ -0,0 +1,160 @@
+#include <thread>
+#include <functional>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <condition_variable>
+#include "circular_buffer/mpmc_circular_buffer.hpp"
+
+/** Dispatch queue backed by a lock-free MPMC circular buffer
+ *
+ * This is the dispatch queue from dispatch.cpp, with the mutex-protected std::queue replaced by
+ * mpmc_circular_buffer. Any number of threads can dispatch work, and the worker threads
+ * pull work out of the queue without taking the lock.
+ *
+ * The mutex and condition variable are only used to put idle workers to sleep. A worker checks
+ * the queue under the lock before it waits, and dispatch() notifies under the lock after adding
+ * work, so a notification can't be lost between the check and the wait.
+ *
+ * The queue is bounded. If it is full, dispatch() yields until a worker makes room.
+ */
+class dispatch_queue
+{
+	typedef std::function<void(void)> fp_t;
+
+  public:
+	dispatch_queue(std::string name, size_t thread_cnt = 1);
+	~dispatch_queue();
+
+	// dispatch and copy
+	void dispatch(const fp_t& op);
+	// dispatch and move
+	void dispatch(fp_t&& op);
+
+	// Deleted operations
+	dispatch_queue(const dispatch_queue& rhs) = delete;
+	dispatch_queue& operator=(const dispatch_queue& rhs) = delete;
+	dispatch_queue(dispatch_queue&& rhs) = delete;
+	dispatch_queue& operator=(dispatch_queue&& rhs) = delete;
+
+  private:
+	static constexpr size_t kQueueSize = 256;
+
+	std::string name_;
+	std::mutex lock_;
+	std::vector<std::thread> threads_;
+	mpmc_circular_buffer<fp_t, kQueueSize> q_;
+	std::condition_variable cv_;
+	bool quit_ = false;
+
+	void notify_worker(void);
+	void dispatch_thread_handler(void);
+};
+
+dispatch_queue::dispatch_queue(std::string name, size_t thread_cnt) :
+	name_{std::move(name)}, threads_(thread_cnt)
+{
+	printf("Creating dispatch queue: %s\n", name_.c_str());
+	printf("Dispatch threads: %zu\n", thread_cnt);
+
+	for(size_t i = 0; i < threads_.size(); i++)
+	{
+		threads_[i] = std::thread(&dispatch_queue::dispatch_thread_handler, this);
+	}
+}
+
+dispatch_queue::~dispatch_queue()
+{
+	printf("Destructor: Destroying dispatch threads...\n");
+
+	// Signal to dispatch threads that it's time to wrap up
+	std::unique_lock<std::mutex> lock(lock_);
+	quit_ = true;
+	cv_.notify_all();
+	lock.unlock();
+
+	// Wait for threads to finish before we exit
+	for(size_t i = 0; i < threads_.size(); i++)
+	{
+		if(threads_[i].joinable())
+		{
+			printf("Destructor: Joining thread %zu until completion\n", i);
+			threads_[i].join();
+		}
+	}
+}
+
+void dispatch_queue::dispatch(const fp_t& op)
+{
+	while(!q_.put(op))
+	{
+		std::this_thread::yield();
+	}
+
+	notify_worker();
+}
+
+void dispatch_queue::dispatch(fp_t&& op)
+{
+	// op is left untouched if put() fails, so it is safe to retry
+	while(!q_.put(std::move(op)))
+	{
+		std::this_thread::yield();
+	}
+
+	notify_worker();
+}
+
+void dispatch_queue::notify_worker(void)
+{
+	std::unique_lock<std::mutex> lock(lock_);
+	cv_.notify_one();
+}
+
+void dispatch_queue::dispatch_thread_handler(void)
+{
+	while(true)
+	{
+		auto op = q_.get();
+
+		if(op.has_value())
+		{
+			op.value()();
+			continue;
+		}
+
+		// The queue is empty: wait until we have data or a quit signal
+		std::unique_lock<std::mutex> lock(lock_);
+		cv_.wait(lock, [this] {
+			return (!q_.empty() || quit_);
+		});
+
+		if(quit_)
+		{
+			break;
+		}
+	}
+}
+
+int main(void)
+{
+	int r = 0;
+	dispatch_queue q("Phillip's Demo Dispatch Queue", 4);
+
+	q.dispatch([] {
+		printf("Dispatch 1!\n");
+	});
+	q.dispatch([] {
+		printf("Dispatch 2!\n");
+	});
+	q.dispatch([] {
+		printf("Dispatch 3!\n");
+	});
+	q.dispatch([] {
+		printf("Dispatch 4!\n");
+	});
+
+	return r;
+}
@@ -0,0 +1,134 @@
+#ifndef ARENA_MEMORY_RESOURCE_HPP_
+#define ARENA_MEMORY_RESOURCE_HPP_
+
+#include <cstddef>
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include "malloc/arena_alloc.h"
+
+/** std::pmr::memory_resource backed by the C arena allocator
+ *
+ * This lets STL containers allocate from an arena, so that all of the memory used while
+ * handling a request can be released at once:
+ *
+ * @code
+ * arena_memory_resource arena(buffer, sizeof(buffer));
+ * std::pmr::vector<int> v(&arena);
+ * @endcode
+ *
+ * Deallocation is a no-op: memory is only reclaimed by reset() or by rolling back to a
+ * marker, for example with arena_scope. Containers that use the arena must be destroyed
+ * (or no longer used) before the memory they occupy is reset.
+ *
+ * Allocation throws std::bad_alloc when the arena is out of space, as required by
+ * std::pmr::memory_resource. When exceptions are disabled (-fno-exceptions, the default for
+ * this project), it calls std::abort() instead. The resource is not thread safe.
+ */
+class arena_memory_resource : public std::pmr::memory_resource
+{
+  public:
+	arena_memory_resource() noexcept
+	{
+		arena_init(&arena_);
+	}
+
+	/// Construct an arena that uses a single region of memory
+	arena_memory_resource(void* addr, size_t size) noexcept : arena_memory_resource()
+	{
+		add_block(addr, size);
+	}
+
+	arena_memory_resource(const arena_memory_resource&) = delete;
+	arena_memory_resource& operator=(const arena_memory_resource&) = delete;
+
+	/// Add a region of memory to the arena. Returns false if the region is too small to use.
+	bool add_block(void* addr, size_t size) noexcept
+	{
+		return arena_addblock(&arena_, addr, size) == 0;
+	}
+
+	arena_marker_t mark() const noexcept
+	{
+		return arena_mark(&arena_);
+	}
+
+	void rollback(arena_marker_t marker) noexcept
+	{
+		arena_rollback(&arena_, marker);
+	}
+
+	void reset() noexcept
+	{
+		arena_reset(&arena_);
+	}
+
+	size_t remaining() const noexcept
+	{
+		return arena_remaining(&arena_);
+	}
+
+  private:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		// A zero-byte request must still return a unique pointer
+		void* p = arena_alloc_aligned(&arena_, bytes ? bytes : 1, alignment);
+
+		if(!p)
+		{
+#if defined(__cpp_exceptions)
+			throw std::bad_alloc();
+#else
+			std::abort();
+#endif
+		}
+
+		return p;
+	}
+
+	void do_deallocate(void* /*p*/, size_t /*bytes*/, size_t /*alignment*/) noexcept override {}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+
+	arena_t arena_;
+};
+
+/** Releases everything allocated from an arena during its lifetime
+ *
+ * @code
+ * void handle_request(arena_memory_resource& arena)
+ * {
+ *	arena_scope scope(arena);
+ *	std::pmr::string name(&arena);
+ *	...
+ * } // The arena is rolled back here
+ * @endcode
+ *
+ * Containers that use the arena must be declared after the scope, so that they are
+ * destroyed before the memory is released.
+ */
+class arena_scope
+{
+  public:
+	explicit arena_scope(arena_memory_resource& arena) noexcept
+		: arena_(arena), marker_(arena.mark())
+	{
+	}
+
+	~arena_scope() noexcept
+	{
+		arena_.rollback(marker_);
+	}
+
+	arena_scope(const arena_scope&) = delete;
+	arena_scope& operator=(const arena_scope&) = delete;
+
+  private:
+	arena_memory_resource& arena_;
+	arena_marker_t marker_;
+};
+
+#endif // ARENA_MEMORY_RESOURCE_HPP_
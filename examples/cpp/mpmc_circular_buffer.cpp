@@ -0,0 +1,165 @@
+// Copyright 2021 Embedded Artistry LLC
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "circular_buffer/mpmc_circular_buffer.hpp"
+
+namespace
+{
+constexpr uint32_t kProducerCount = 8;
+constexpr uint32_t kConsumerCount = 8;
+constexpr uint32_t kItemsPerProducer = 20000;
+constexpr uint32_t kTotalItems = kProducerCount * kItemsPerProducer;
+} // namespace
+
+TEST_CASE("Create MPMC circular buffer")
+{
+	mpmc_circular_buffer<uint32_t, 16> cbuf;
+	CHECK(cbuf.size() == 0);
+	CHECK(cbuf.capacity() == 16);
+	CHECK(cbuf.full() == false);
+	CHECK(cbuf.empty() == true);
+}
+
+TEST_CASE("MPMC circular buffer operations")
+{
+	mpmc_circular_buffer<uint32_t, 16> cbuf;
+
+	SECTION("Check Full")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			CHECK(cbuf.full() == false);
+			CHECK(cbuf.put(i) == true);
+		}
+
+		CHECK(cbuf.full() == true);
+		CHECK(cbuf.size() == cbuf.capacity());
+	}
+
+	SECTION("Fill and empty buffer")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			cbuf.put(i);
+		}
+
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			auto value = cbuf.get();
+			CHECK(value.has_value() == true);
+			CHECK(i == value.value());
+		}
+
+		CHECK(cbuf.empty() == true);
+	}
+
+	SECTION("Get empty value")
+	{
+		auto value = cbuf.get();
+		CHECK(value.has_value() == false);
+	}
+
+	SECTION("Check overflow behavior")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			cbuf.put(i);
+		}
+
+		// Data is rejected rather than overwritten
+		CHECK(cbuf.put(cbuf.capacity()) == false);
+
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			auto value = cbuf.get();
+			CHECK(value.has_value() == true);
+			CHECK(i == value.value());
+		}
+	}
+
+	SECTION("Sequence numbers wrap around the buffer")
+	{
+		for(uint32_t i = 0; i < 5 * cbuf.capacity(); i++)
+		{
+			CHECK(cbuf.put(i) == true);
+			CHECK(cbuf.size() == 1);
+
+			auto value = cbuf.get();
+			CHECK(value.has_value() == true);
+			CHECK(i == value.value());
+		}
+	}
+
+	SECTION("Reset")
+	{
+		cbuf.put(1);
+		cbuf.put(2);
+		cbuf.reset();
+
+		CHECK(cbuf.empty() == true);
+		CHECK(cbuf.get().has_value() == false);
+	}
+}
+
+TEST_CASE("MPMC circular buffer stress test with 8 producers and 8 consumers")
+{
+	mpmc_circular_buffer<uint32_t, 64> cbuf;
+	// One counter per item, so we can detect both lost and duplicated items
+	std::vector<std::atomic<uint32_t>> received(kTotalItems);
+	std::atomic<uint32_t> consumed{0};
+	std::vector<std::thread> threads;
+
+	for(uint32_t p = 0; p < kProducerCount; p++)
+	{
+		threads.emplace_back([&cbuf, p] {
+			for(uint32_t i = 0; i < kItemsPerProducer; i++)
+			{
+				while(!cbuf.put((p * kItemsPerProducer) + i))
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	for(uint32_t c = 0; c < kConsumerCount; c++)
+	{
+		threads.emplace_back([&cbuf, &received, &consumed] {
+			while(consumed.load(std::memory_order_relaxed) < kTotalItems)
+			{
+				auto value = cbuf.get();
+				if(value.has_value())
+				{
+					received[value.value()].fetch_add(1, std::memory_order_relaxed);
+					consumed.fetch_add(1, std::memory_order_relaxed);
+				}
+				else
+				{
+					std::this_thread::yield();
+				}
+			}
+		});
+	}
+
+	for(auto& t : threads)
+	{
+		t.join();
+	}
+
+	uint32_t lost = 0;
+	uint32_t duplicated = 0;
+	for(auto& count : received)
+	{
+		lost += (count.load() == 0);
+		duplicated += (count.load() > 1);
+	}
+
+	CHECK(consumed.load() == kTotalItems);
+	CHECK(lost == 0);
+	CHECK(duplicated == 0);
+	CHECK(cbuf.empty() == true);
+}
@@ -0,0 +1,167 @@
+// Copyright 2021 Embedded Artistry LLC
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <catch2/catch_test_macros.hpp>
+#include "sort/pdqsort.hpp"
+
+namespace
+{
+/// Inputs that are easy for some quicksorts and hard for others
+std::vector<int> make_input(const std::string& pattern, size_t n)
+{
+	std::mt19937 random(static_cast<uint32_t>(n));
+	std::vector<int> v(n);
+
+	for(size_t i = 0; i < n; i++)
+	{
+		int x = static_cast<int>(i);
+
+		if(pattern == "random")
+		{
+			v[i] = static_cast<int>(random());
+		}
+		else if(pattern == "sorted")
+		{
+			v[i] = x;
+		}
+		else if(pattern == "reversed")
+		{
+			v[i] = static_cast<int>(n) - x;
+		}
+		else if(pattern == "equal")
+		{
+			v[i] = 42;
+		}
+		else if(pattern == "few unique")
+		{
+			v[i] = static_cast<int>(random() % 4);
+		}
+		else if(pattern == "organ pipe")
+		{
+			v[i] = (i < n / 2) ? x : static_cast<int>(n) - x;
+		}
+		else if(pattern == "sawtooth")
+		{
+			v[i] = x % 32;
+		}
+		else // mostly sorted
+		{
+			v[i] = (i % 100 == 0) ? static_cast<int>(random()) : x;
+		}
+	}
+
+	return v;
+}
+
+struct record
+{
+	int key;
+	size_t index;
+};
+} // namespace
+
+TEST_CASE("pdqsort sorts every pattern and size")
+{
+	const char* patterns[] = {"random",	 "sorted",	   "reversed", "equal",
+							  "few unique", "organ pipe", "sawtooth", "mostly sorted"};
+
+	for(const char* pattern : patterns)
+	{
+		for(size_t n = 0; n < 100000; n = n * 3 + 1)
+		{
+			auto v = make_input(pattern, n);
+			auto expected = v;
+
+			std::sort(expected.begin(), expected.end());
+			pdqsort(v.begin(), v.end());
+
+			INFO(pattern << ", " << n << " elements");
+			CHECK(v == expected);
+		}
+	}
+}
+
+TEST_CASE("pdqsort uses the given comparison")
+{
+	auto v = make_input("few unique", 1000);
+	auto expected = v;
+
+	std::sort(expected.begin(), expected.end(), std::greater<>());
+	pdqsort(v.begin(), v.end(), std::greater<>());
+
+	CHECK(v == expected);
+
+	// Records with equal keys stay together, though not in their original order
+	std::vector<record> records;
+
+	for(size_t i = 0; i < v.size(); i++)
+	{
+		records.push_back({v[i], i});
+	}
+
+	pdqsort(records.begin(), records.end(),
+			[](const record& a, const record& b) { return a.key < b.key; });
+
+	CHECK(std::is_sorted(records.begin(), records.end(),
+						 [](const record& a, const record& b) { return a.key < b.key; }));
+}
+
+TEST_CASE("pdqsort sorts move-only types")
+{
+	std::vector<std::unique_ptr<int>> v;
+
+	for(int i = 0; i < 1000; i++)
+	{
+		v.push_back(std::make_unique<int>((i * 7919) % 1000));
+	}
+
+	pdqsort(v.begin(), v.end(),
+			[](const std::unique_ptr<int>& a, const std::unique_ptr<int>& b) { return *a < *b; });
+
+	for(int i = 0; i < 1000; i++)
+	{
+		CHECK(*v[static_cast<size_t>(i)] == i);
+	}
+}
+
+TEST_CASE("pdqsort takes O(n log n) comparisons, or O(n) for sorted input")
+{
+	constexpr size_t kSize = 1 << 16;
+	constexpr size_t kLog2Size = 16;
+	const char* patterns[] = {"random", "few unique", "organ pipe", "sawtooth"};
+
+	for(const char* pattern : patterns)
+	{
+		auto v = make_input(pattern, kSize);
+		size_t comparisons = 0;
+
+		pdqsort(v.begin(), v.end(), [&comparisons](int a, int b) {
+			comparisons++;
+			return a < b;
+		});
+
+		INFO(pattern);
+		CHECK(std::is_sorted(v.begin(), v.end()));
+		CHECK(comparisons < 2 * kSize * kLog2Size);
+	}
+
+	for(const char* pattern : {"sorted", "reversed", "equal"})
+	{
+		auto v = make_input(pattern, kSize);
+		size_t comparisons = 0;
+
+		pdqsort(v.begin(), v.end(), [&comparisons](int a, int b) {
+			comparisons++;
+			return a < b;
+		});
+
+		INFO(pattern);
+		CHECK(std::is_sorted(v.begin(), v.end()));
+		CHECK(comparisons < 4 * kSize);
+	}
+}
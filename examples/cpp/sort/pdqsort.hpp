@@ -0,0 +1,344 @@
+#ifndef PDQSORT_HPP_
+#define PDQSORT_HPP_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+/** Pattern-defeating quicksort
+ *
+ * The C++ counterpart of QSORT_DEFINE() in examples/libc/stdlib/pdqsort.h, and a drop-in
+ * replacement for std::sort():
+ *
+ * @code
+ * pdqsort(v.begin(), v.end());
+ * pdqsort(v.begin(), v.end(), [](const auto& a, const auto& b) { return a.key < b.key; });
+ * @endcode
+ *
+ * The comparison is a template parameter, so it is inlined into the sort. Sorted, reversed,
+ * and mostly equal input takes linear time, and the worst case is O(n log n): after
+ * log2(n) unbalanced partitions, a range is heap sorted with std::make_heap() and
+ * std::sort_heap(). The C version uses __heapsort_r() there, which copies elements with
+ * memcpy(), so it can't be used for every C++ type.
+ *
+ * Like std::sort(), the sort is not stable.
+ */
+
+namespace pdqsort_detail
+{
+/// Ranges shorter than this are insertion sorted
+constexpr std::ptrdiff_t kInsertionThreshold = 24;
+
+/// Ranges longer than this use the median of three medians as the pivot
+constexpr std::ptrdiff_t kNintherThreshold = 128;
+
+/// The number of element moves after which the insertion sort of an already partitioned
+/// range gives up
+constexpr std::ptrdiff_t kPartialInsertionLimit = 8;
+
+inline int log2(std::ptrdiff_t n)
+{
+	int log = 0;
+
+	while(n >>= 1)
+	{
+		log++;
+	}
+
+	return log;
+}
+
+template<typename Iter, typename Less>
+inline void sort3(Iter a, Iter b, Iter c, Less& less)
+{
+	if(less(*b, *a))
+	{
+		std::iter_swap(a, b);
+	}
+
+	if(less(*c, *b))
+	{
+		std::iter_swap(b, c);
+
+		if(less(*b, *a))
+		{
+			std::iter_swap(a, b);
+		}
+	}
+}
+
+/// When unguarded, begin[-1] is known to be <= every element in the range, so the inner
+/// loop doesn't need to check for the start of the range
+template<typename Iter, typename Less>
+inline void insertion_sort(Iter begin, Iter end, Less& less, bool unguarded)
+{
+	if(begin == end)
+	{
+		return;
+	}
+
+	for(Iter cur = begin + 1; cur != end; ++cur)
+	{
+		if(!less(*cur, *(cur - 1)))
+		{
+			continue;
+		}
+
+		auto tmp = std::move(*cur);
+		Iter sift = cur;
+
+		do
+		{
+			*sift = std::move(*(sift - 1));
+			--sift;
+		} while((unguarded || sift != begin) && less(tmp, *(sift - 1)));
+
+		*sift = std::move(tmp);
+	}
+}
+
+/// Insertion sort, which gives up once it has moved too many elements
+template<typename Iter, typename Less>
+inline bool partial_insertion_sort(Iter begin, Iter end, Less& less)
+{
+	std::ptrdiff_t moves = 0;
+
+	if(begin == end)
+	{
+		return true;
+	}
+
+	for(Iter cur = begin + 1; cur != end; ++cur)
+	{
+		if(!less(*cur, *(cur - 1)))
+		{
+			continue;
+		}
+
+		auto tmp = std::move(*cur);
+		Iter sift = cur;
+
+		do
+		{
+			*sift = std::move(*(sift - 1));
+			--sift;
+		} while(sift != begin && less(tmp, *(sift - 1)));
+
+		*sift = std::move(tmp);
+		moves += cur - sift;
+
+		if(moves > kPartialInsertionLimit)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/// Partition around *begin, with the elements equal to it on the right. The pivot selection
+/// leaves an element >= the pivot at the end, which stops the first scan.
+template<typename Iter, typename Less>
+inline Iter partition_right(Iter begin, Iter end, Less& less, bool& no_swaps)
+{
+	auto pivot = std::move(*begin);
+	Iter first = begin;
+	Iter last = end;
+
+	while(less(*++first, pivot))
+	{
+	}
+
+	if(first - 1 == begin)
+	{
+		while(first < last && !less(*--last, pivot))
+		{
+		}
+	}
+	else
+	{
+		// An element < the pivot was found, which stops this scan
+		while(!less(*--last, pivot))
+		{
+		}
+	}
+
+	no_swaps = first >= last;
+
+	while(first < last)
+	{
+		std::iter_swap(first, last);
+
+		while(less(*++first, pivot))
+		{
+		}
+
+		while(!less(*--last, pivot))
+		{
+		}
+	}
+
+	Iter pivot_pos = first - 1;
+	*begin = std::move(*pivot_pos);
+	*pivot_pos = std::move(pivot);
+
+	return pivot_pos;
+}
+
+/// Partition around *begin, with the elements equal to it on the left
+template<typename Iter, typename Less>
+inline Iter partition_left(Iter begin, Iter end, Less& less)
+{
+	auto pivot = std::move(*begin);
+	Iter first = begin;
+	Iter last = end;
+
+	while(less(pivot, *--last))
+	{
+	}
+
+	if(last + 1 == end)
+	{
+		while(first < last && !less(pivot, *++first))
+		{
+		}
+	}
+	else
+	{
+		while(!less(pivot, *++first))
+		{
+		}
+	}
+
+	while(first < last)
+	{
+		std::iter_swap(first, last);
+
+		while(less(pivot, *--last))
+		{
+		}
+
+		while(!less(pivot, *++first))
+		{
+		}
+	}
+
+	*begin = std::move(*last);
+	*last = std::move(pivot);
+
+	return last;
+}
+
+/// Swap a few elements of an unbalanced partition's sides into new positions
+template<typename Iter>
+inline void break_patterns(Iter begin, Iter pivot, Iter end)
+{
+	std::ptrdiff_t l_size = pivot - begin;
+	std::ptrdiff_t r_size = end - (pivot + 1);
+
+	if(l_size >= kInsertionThreshold)
+	{
+		std::iter_swap(begin, begin + l_size / 4);
+		std::iter_swap(pivot - 1, pivot - l_size / 4);
+
+		if(l_size > kNintherThreshold)
+		{
+			std::iter_swap(begin + 1, begin + (l_size / 4 + 1));
+			std::iter_swap(begin + 2, begin + (l_size / 4 + 2));
+			std::iter_swap(pivot - 2, pivot - (l_size / 4 + 1));
+			std::iter_swap(pivot - 3, pivot - (l_size / 4 + 2));
+		}
+	}
+
+	if(r_size >= kInsertionThreshold)
+	{
+		std::iter_swap(pivot + 1, pivot + (1 + r_size / 4));
+		std::iter_swap(end - 1, end - r_size / 4);
+
+		if(r_size > kNintherThreshold)
+		{
+			std::iter_swap(pivot + 2, pivot + (2 + r_size / 4));
+			std::iter_swap(pivot + 3, pivot + (3 + r_size / 4));
+			std::iter_swap(end - 2, end - (1 + r_size / 4));
+			std::iter_swap(end - 3, end - (2 + r_size / 4));
+		}
+	}
+}
+
+/// Sort [begin, end). Unless leftmost, begin[-1] is <= every element in the range.
+template<typename Iter, typename Less>
+void pdqsort_loop(Iter begin, Iter end, Less& less, int bad_allowed, bool leftmost)
+{
+	for(;;)
+	{
+		std::ptrdiff_t size = end - begin;
+		std::ptrdiff_t half = size / 2;
+		bool no_swaps;
+
+		if(size < kInsertionThreshold)
+		{
+			insertion_sort(begin, end, less, !leftmost);
+			return;
+		}
+
+		// Move the pivot to *begin
+		if(size > kNintherThreshold)
+		{
+			sort3(begin, begin + half, end - 1, less);
+			sort3(begin + 1, begin + (half - 1), end - 2, less);
+			sort3(begin + 2, begin + (half + 1), end - 3, less);
+			sort3(begin + (half - 1), begin + half, begin + (half + 1), less);
+			std::iter_swap(begin, begin + half);
+		}
+		else
+		{
+			sort3(begin + half, begin, end - 1, less);
+		}
+
+		// Everything equal to the pivot is already in place
+		if(!leftmost && !less(*(begin - 1), *begin))
+		{
+			begin = partition_left(begin, end, less) + 1;
+			continue;
+		}
+
+		Iter pivot = partition_right(begin, end, less, no_swaps);
+
+		if(pivot - begin < size / 8 || end - pivot - 1 < size / 8)
+		{
+			if(--bad_allowed <= 0)
+			{
+				std::make_heap(begin, end, less);
+				std::sort_heap(begin, end, less);
+				return;
+			}
+
+			break_patterns(begin, pivot, end);
+		}
+		else if(no_swaps && partial_insertion_sort(begin, pivot, less) &&
+				partial_insertion_sort(pivot + 1, end, less))
+		{
+			return;
+		}
+
+		// Recurse into the left side, and loop on the right side
+		pdqsort_loop(begin, pivot, less, bad_allowed, leftmost);
+		begin = pivot + 1;
+		leftmost = false;
+	}
+}
+} // namespace pdqsort_detail
+
+/// Sort [first, last) with the random access iterators first and last
+template<typename Iter, typename Less = std::less<>>
+void pdqsort(Iter first, Iter last, Less less = Less())
+{
+	if(last - first > 1)
+	{
+		pdqsort_detail::pdqsort_loop(first, last, less, pdqsort_detail::log2(last - first),
+									 true);
+	}
+}
+
+#endif // PDQSORT_HPP_
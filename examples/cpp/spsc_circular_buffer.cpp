@@ -0,0 +1,216 @@
+// Copyright 2021 Embedded Artistry LLC
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include "circular_buffer/circular_buffer.hpp"
+#include "circular_buffer/spsc_circular_buffer.hpp"
+
+namespace
+{
+constexpr uint32_t kTransferCount = 100000;
+
+// Move kTransferCount values from a producer thread to the calling thread.
+// The producer retries while the buffer is full, the consumer while it is empty.
+template<class TBuffer, class TFullCheck>
+uint64_t transfer(TBuffer& cbuf, TFullCheck is_full)
+{
+	std::thread producer([&cbuf, &is_full] {
+		for(uint32_t i = 0; i < kTransferCount; i++)
+		{
+			while(is_full(cbuf))
+			{
+				std::this_thread::yield();
+			}
+
+			cbuf.put(i);
+		}
+	});
+
+	uint64_t sum = 0;
+	for(uint32_t i = 0; i < kTransferCount;)
+	{
+		auto value = cbuf.get();
+		if(value.has_value())
+		{
+			sum += value.value();
+			i++;
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	producer.join();
+
+	return sum;
+}
+} // namespace
+
+TEST_CASE("Create SPSC circular buffer")
+{
+	spsc_circular_buffer<uint32_t, 16> cbuf;
+	CHECK(cbuf.size() == 0);
+	CHECK(cbuf.capacity() == 16);
+	CHECK(cbuf.full() == false);
+	CHECK(cbuf.empty() == true);
+}
+
+TEST_CASE("SPSC circular buffer operations")
+{
+	spsc_circular_buffer<uint32_t, 16> cbuf;
+
+	SECTION("Check Full")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			CHECK(cbuf.full() == false);
+			CHECK(cbuf.put(i) == true);
+		}
+
+		CHECK(cbuf.full() == true);
+		CHECK(cbuf.size() == cbuf.capacity());
+	}
+
+	SECTION("Fill and empty buffer")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			cbuf.put(i);
+		}
+
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			auto value = cbuf.get();
+			CHECK(value.has_value() == true);
+			CHECK(i == value.value());
+		}
+
+		CHECK(cbuf.empty() == true);
+	}
+
+	SECTION("Get empty value")
+	{
+		auto value = cbuf.get();
+		CHECK(value.has_value() == false);
+	}
+
+	SECTION("Check overflow behavior")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			cbuf.put(i);
+		}
+
+		// Data is rejected rather than overwritten
+		CHECK(cbuf.put(cbuf.capacity()) == false);
+
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			auto value = cbuf.get();
+			CHECK(value.has_value() == true);
+			CHECK(i == value.value());
+		}
+	}
+
+	SECTION("Indices wrap around the buffer")
+	{
+		for(uint32_t i = 0; i < 5 * cbuf.capacity(); i++)
+		{
+			CHECK(cbuf.put(i) == true);
+			CHECK(cbuf.size() == 1);
+
+			auto value = cbuf.get();
+			CHECK(value.has_value() == true);
+			CHECK(i == value.value());
+		}
+	}
+}
+
+TEST_CASE("SPSC circular buffer two thread transfer")
+{
+	spsc_circular_buffer<uint32_t, 64> cbuf;
+	const uint64_t expected = (uint64_t(kTransferCount) * (kTransferCount - 1)) / 2;
+
+	CHECK(transfer(cbuf, [](auto& b) {
+			  return b.full();
+		  }) == expected);
+	CHECK(cbuf.empty() == true);
+}
+
+TEST_CASE("SPSC circular buffer blocking operations")
+{
+	using namespace std::chrono_literals;
+	spsc_circular_buffer<uint32_t, 16> cbuf;
+
+	SECTION("get_wait times out on an empty buffer")
+	{
+		auto start = std::chrono::steady_clock::now();
+		auto value = cbuf.get_wait(10ms);
+
+		CHECK(value.has_value() == false);
+		CHECK(std::chrono::steady_clock::now() - start >= 10ms);
+	}
+
+	SECTION("put_wait times out on a full buffer")
+	{
+		for(uint32_t i = 0; i < cbuf.capacity(); i++)
+		{
+			CHECK(cbuf.put_wait(i, 0ms) == true);
+		}
+
+		CHECK(cbuf.put_wait(cbuf.capacity(), 10ms) == false);
+		CHECK(cbuf.size() == cbuf.capacity());
+	}
+
+	SECTION("get_wait wakes up when data arrives")
+	{
+		std::thread producer([&cbuf] {
+			std::this_thread::sleep_for(10ms);
+			cbuf.put(42);
+		});
+
+		CHECK(cbuf.get_wait() == 42);
+		producer.join();
+	}
+
+	SECTION("Blocking transfer between two threads")
+	{
+		std::thread producer([&cbuf] {
+			for(uint32_t i = 0; i < kTransferCount; i++)
+			{
+				cbuf.put_wait(i);
+			}
+		});
+
+		for(uint32_t i = 0; i < kTransferCount; i++)
+		{
+			CHECK(i == cbuf.get_wait());
+		}
+
+		producer.join();
+		CHECK(cbuf.empty() == true);
+	}
+}
+
+TEST_CASE("SPSC vs. mutex circular buffer throughput", "[.][benchmark]")
+{
+	BENCHMARK("circular_buffer (std::recursive_mutex)")
+	{
+		circular_buffer<uint32_t, 64> cbuf;
+		return transfer(cbuf, [](auto& b) {
+			return b.size() == b.capacity();
+		});
+	};
+
+	BENCHMARK("spsc_circular_buffer")
+	{
+		spsc_circular_buffer<uint32_t, 64> cbuf;
+		return transfer(cbuf, [](auto& b) {
+			return b.full();
+		});
+	};
+}
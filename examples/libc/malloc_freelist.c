@@ -1,6 +1,14 @@
+#include <stdatomic.h>
+#include <stdbool.h>
 #include <stdint.h>
 #include "memory.h"
 #include "linked_list.h"
+#include "malloc_freelist.h"
+#include "strings.h"
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	#include <pthread.h>
+#endif
 
 #pragma mark - Definitions -
 
@@ -16,138 +24,1165 @@
  * This is the container for our free-list.
  * Node the usage of the linked list here: the library uses offsetof
  * and container_of to manage the list and get back to the parent struct.
+ *
+ * Every block starts with two boundary tags: the size of the block that comes before it in
+ * memory, and its own size. Because sizes are pointer-aligned, the low bit of size is free to
+ * mark the block as in use. With these tags, free() can find both physical neighbors of a
+ * block and merge with the ones that are free in constant time, without walking a list.
+ *
+ * The list node is only needed while the block is free, so it shares space with the
+ * memory we vend to the user.
+ *
+ * With MALLOC_FREELIST_TAGS, the header also records the call site that allocated the block.
  */
 typedef struct
 {
-	ll_t node;
+	size_t prev_size;
 	size_t size;
-	char* block;
+#ifdef MALLOC_FREELIST_TAGS
+	const char* tag;
+#endif
+	ll_t node;
 } alloc_node_t;
 
 /**
  * We vend a memory address to the user.  This lets us translate back and forth
  * between the vended pointer and the container we use for managing the data.
  */
-#define ALLOC_HEADER_SZ offsetof(alloc_node_t, block)
+#define ALLOC_HEADER_SZ offsetof(alloc_node_t, node)
+
+// The size field tracks whether the block is in use in its low bit
+#define BLOCK_IN_USE ((size_t)1)
 
 // We are enforcing a minimum allocation size of 32B.
 #define MIN_ALLOC_SZ ALLOC_HEADER_SZ + 32
 
-#pragma mark - Prototypes -
+/*
+ * Free blocks up to SMALL_BLOCK_MAX bytes are kept in segregated free lists, one per
+ * power-of-two size class: class n holds blocks with a size in [2^n, 2^(n+1)).
+ * Larger blocks are kept in free_list.
+ *
+ * A request is served from the smallest class whose blocks are all large enough for it, so
+ * requests only need to be pointer-aligned (and at least SMALL_BLOCK_MIN). Thread-cache builds
+ * also round small requests up to a power of two, so that a cached block can be reused by any
+ * request in its class.
+ *
+ * A bitmap tracks which classes are non-empty, so finding a block that is large enough
+ * is a single bit search rather than a list walk. If every such class is empty, the request's
+ * own class, which may hold some blocks that are large enough, is searched before free_list.
+ */
+#define SMALL_BLOCK_MIN 32
+#define SMALL_BLOCK_MAX 4096
+#define SIZE_CLASS_COUNT 13 // fls(SMALL_BLOCK_MAX)
+
+/*
+ * Multi-threaded builds
+ *
+ * By default, the allocator does no locking and may only be used from one thread.
+ *
+ * With MALLOC_FREELIST_THREADSAFE, every call into the heap is serialized with
+ * malloc_lock() and malloc_unlock(), which the platform must provide.
+ *
+ * MALLOC_FREELIST_THREAD_CACHE also gives each thread a cache of small blocks, with one bin
+ * per size class. Small allocations and frees are served from the calling thread's bins
+ * without taking the lock. An empty bin is refilled with TCACHE_BATCH_COUNT blocks under a
+ * single lock, and a full bin returns TCACHE_BATCH_COUNT blocks the same way. The cache needs
+ * thread-local storage support from the compiler and runtime, and POSIX threads: a
+ * thread-specific data destructor returns a thread's cache to the heap when it exits.
+ */
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	#ifndef MALLOC_FREELIST_THREADSAFE
+		#define MALLOC_FREELIST_THREADSAFE
+	#endif
+
+	#ifndef TCACHE_BIN_CAPACITY
+		#define TCACHE_BIN_CAPACITY 32
+	#endif
+
+	#ifndef TCACHE_BATCH_COUNT
+		#define TCACHE_BATCH_COUNT (TCACHE_BIN_CAPACITY / 2)
+	#endif
+#endif
+
+#ifdef MALLOC_FREELIST_THREADSAFE
+	#define heap_lock() malloc_lock()
+	#define heap_unlock() malloc_unlock()
+#else
+	#define heap_lock()
+	#define heap_unlock()
+#endif
+
+/*
+ * Event hook
+ *
+ * MALLOC_FREELIST_EVENT(type, ptr, size) is invoked for every malloc, free, and in-place
+ * resize, outside of the heap lock. It compiles to nothing by default. Define it to forward
+ * events to your own tracing, or define MALLOC_FREELIST_EVENT_LOG to record them in a ring
+ * buffer that is read with malloc_event_log_read().
+ */
+#ifdef MALLOC_FREELIST_EVENT_LOG
+	// MALLOC_FREELIST_EVENT_LOG_SIZE is set in malloc_freelist.h
+	#define MALLOC_FREELIST_EVENT(type, ptr, size) event_log_record(type, ptr, size)
+#endif
 
-static void defrag_free_list(void);
+#ifndef MALLOC_FREELIST_EVENT
+	#define MALLOC_FREELIST_EVENT(type, ptr, size)
+#endif
 
 #pragma mark - Declarations -
 
 // This macro simply declares and initializes our linked list
 static LIST_INIT(free_list);
 
+// Every pool added with malloc_addblock, so that the heap can be walked
+static LIST_INIT(pool_list);
+
+// Running counters for malloc_stats(), protected by the heap lock
+static malloc_stats_t heap_stats;
+
+/*
+ * Blocks passed to free_deferred(), linked through node.next. Any context may push onto this
+ * stack with a CAS, and the next malloc() or free() takes the whole list with one exchange.
+ * Because blocks are never popped one at a time, the stack is not subject to ABA problems.
+ */
+static _Atomic(ll_t*) deferred_list = NULL;
+
+// Segregated free lists for small blocks, initialized by malloc_addblock
+static ll_t size_class_list[SIZE_CLASS_COUNT];
+static unsigned long size_class_bitmap = 0;
+static bool size_classes_initialized = false;
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+/*
+ * A thread's cached blocks of one size class. Cached blocks stay marked in use, so the heap
+ * never merges them. They are linked through node.next.
+ */
+typedef struct
+{
+	ll_t* head;
+	unsigned count;
+} tcache_bin_t;
+
+static _Thread_local tcache_bin_t tcache[SIZE_CLASS_COUNT];
+
+// Whether the calling thread has set tcache_key, so that its cache is flushed when it exits
+static _Thread_local bool tcache_registered = false;
+static pthread_key_t tcache_key;
+static pthread_once_t tcache_key_once = PTHREAD_ONCE_INIT;
+#endif
+
+#ifdef MALLOC_FREELIST_EVENT_LOG
+_Static_assert((MALLOC_FREELIST_EVENT_LOG_SIZE & (MALLOC_FREELIST_EVENT_LOG_SIZE - 1)) == 0,
+			   "MALLOC_FREELIST_EVENT_LOG_SIZE must be a power of two");
+
+// Protected by the heap lock. event_log_head - event_log_tail is the number of stored events.
+static malloc_event_t event_log[MALLOC_FREELIST_EVENT_LOG_SIZE];
+static uint32_t event_log_head = 0;
+static uint32_t event_log_tail = 0;
+#endif
+
 #pragma mark - Private Functions -
 
+static inline size_t block_size(const alloc_node_t* blk)
+{
+	return blk->size & ~BLOCK_IN_USE;
+}
+
+static inline bool block_in_use(const alloc_node_t* blk)
+{
+	return (blk->size & BLOCK_IN_USE) != 0;
+}
+
+/**
+ * The block that follows this one in memory. Every pool ends with an in-use
+ * block of size 0, so the last real block also has a successor.
+ */
+static inline alloc_node_t* next_block(const alloc_node_t* blk)
+{
+	return (alloc_node_t*)((uintptr_t)&blk->node + block_size(blk));
+}
+
+/**
+ * The block that precedes this one in memory. Every pool starts with an in-use
+ * block of size 0, so the first real block also has a predecessor.
+ */
+static inline alloc_node_t* prev_block(const alloc_node_t* blk)
+{
+	return (alloc_node_t*)((uintptr_t)blk - blk->prev_size - ALLOC_HEADER_SZ);
+}
+
+/**
+ * Set the size of a block and update the boundary tag in the block that follows it
+ */
+static inline void set_block_size(alloc_node_t* blk, size_t size, bool in_use)
+{
+	blk->size = size | (in_use ? BLOCK_IN_USE : 0);
+	next_block(blk)->prev_size = size;
+}
+
+/**
+ * The size class that a free block of this size belongs to: floor(log2(size))
+ */
+static inline int block_size_class(size_t size)
+{
+	return flsl((long)size) - 1;
+}
+
 /**
- * When we free, we can take our node and check to see if any memory blocks
- * can be combined into larger blocks.  This will help us fight against
- * memory fragmentation in a simple way.
+ * The smallest size class whose blocks are all large enough for this request:
+ * ceil(log2(size))
  */
-void defrag_free_list(void)
+static inline int request_size_class(size_t size)
 {
-	alloc_node_t *b, *lb = NULL, *t;
+	return flsl((long)(size - 1));
+}
+
+/**
+ * Add a free block to the size class or free_list that matches its size
+ */
+static void free_block_insert(alloc_node_t* blk)
+{
+	size_t size = block_size(blk);
+
+	if(size <= SMALL_BLOCK_MAX)
+	{
+		int c = block_size_class(size);
+
+		list_add(&blk->node, &size_class_list[c]);
+		size_class_bitmap |= 1UL << c;
+	}
+	else
+	{
+		list_add(&blk->node, &free_list);
+	}
+}
+
+/**
+ * Remove a free block from the size class or free_list that it is stored in
+ */
+static void free_block_remove(alloc_node_t* blk)
+{
+	size_t size = block_size(blk);
 
-	list_for_each_entry_safe(b, t, &free_list, node)
+	list_del(&blk->node);
+
+	if(size <= SMALL_BLOCK_MAX)
 	{
-		if(lb)
+		int c = block_size_class(size);
+
+		if(size_class_list[c].next == &size_class_list[c])
 		{
-			if((((uintptr_t)&lb->block) + lb->size) == (uintptr_t)b)
-			{
-				lb->size += ALLOC_HEADER_SZ + b->size;
-				list_del(&b->node);
-				continue;
-			}
+			size_class_bitmap &= ~(1UL << c);
 		}
-		lb = b;
 	}
 }
 
-#pragma mark - APIs -
+/**
+ * Find a small block that fits the request in O(1), or NULL if there is none.
+ * The block is removed from its size class list.
+ */
+static alloc_node_t* size_class_find(size_t size)
+{
+	int c = request_size_class(size);
+	unsigned long candidates;
+	alloc_node_t* blk;
 
-void* malloc(size_t size)
+	if(c >= SIZE_CLASS_COUNT)
+	{
+		return NULL;
+	}
+
+	// Keep the non-empty classes that are large enough, then take the smallest of those
+	candidates = size_class_bitmap & ~((1UL << c) - 1);
+	if(candidates == 0)
+	{
+		return NULL;
+	}
+
+	c = flsl((long)(candidates & -candidates)) - 1;
+	blk = list_first_entry(&size_class_list[c], alloc_node_t, node);
+	free_block_remove(blk);
+
+	return blk;
+}
+
+/**
+ * First-fit search of the size class that the request itself falls in. Only some of its
+ * blocks are large enough, so size_class_find() skips it, but it may still hold the only
+ * block that fits. The block is removed from its size class list.
+ */
+static alloc_node_t* size_class_scan(size_t size)
+{
+	int c = block_size_class(size);
+	alloc_node_t* blk;
+
+	if(size > SMALL_BLOCK_MAX || !(size_class_bitmap & (1UL << c)))
+	{
+		return NULL;
+	}
+
+	list_for_each_entry(blk, &size_class_list[c], node)
+	{
+		if(block_size(blk) >= size)
+		{
+			free_block_remove(blk);
+			return blk;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * First-fit search of free_list. The block is removed from free_list.
+ */
+static alloc_node_t* free_list_find(size_t size)
+{
+	alloc_node_t* blk;
+
+	// try to find a big enough block to alloc
+	list_for_each_entry(blk, &free_list, node)
+	{
+		if(block_size(blk) >= size)
+		{
+			free_block_remove(blk);
+			return blk;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Mark the block as in use. If the end of the block is big enough to be useful,
+ * split it off and return it to the free lists.
+ */
+static void split_block(alloc_node_t* blk, size_t size)
+{
+	size_t old_size = block_size(blk);
+
+	if((old_size - size) >= MIN_ALLOC_SZ)
+	{
+		alloc_node_t* new_blk;
+
+		set_block_size(blk, size, true);
+		new_blk = next_block(blk);
+		set_block_size(new_blk, old_size - size - ALLOC_HEADER_SZ, false);
+		free_block_insert(new_blk);
+	}
+	else
+	{
+		set_block_size(blk, old_size, true);
+	}
+}
+
+/**
+ * Round a request up to the size of the block that will serve it
+ */
+static inline size_t request_block_size(size_t size)
+{
+	if(size <= SMALL_BLOCK_MIN)
+	{
+		return SMALL_BLOCK_MIN;
+	}
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	if(size <= SMALL_BLOCK_MAX)
+	{
+		return 1UL << request_size_class(size);
+	}
+#endif
+
+	// Align the pointer
+	return align_up(size, sizeof(void*));
+}
+
+/**
+ * Count bytes that were added to in-use blocks. The caller must hold the heap lock.
+ */
+static inline void stats_add_used(size_t bytes)
+{
+	heap_stats.used_bytes += bytes;
+
+	if(heap_stats.used_bytes > heap_stats.peak_used_bytes)
+	{
+		heap_stats.peak_used_bytes = heap_stats.used_bytes;
+	}
+}
+
+/**
+ * Allocate a block from the heap. The caller must hold the heap lock.
+ */
+static alloc_node_t* heap_alloc(size_t size)
 {
-	void* ptr = NULL;
 	alloc_node_t* blk = NULL;
 
-	if(size > 0)
+	if(size_classes_initialized)
 	{
-		// Align the pointer
-		size = align_up(size, sizeof(void*));
+		// Small requests are served from the size classes when possible
+		blk = size_class_find(size);
 
-		// try to find a big enough block to alloc
-		list_for_each_entry(blk, &free_list, node)
+		if(!blk)
 		{
-			if(blk->size >= size)
-			{
-				ptr = &blk->block;
-				break;
-			}
+			blk = size_class_scan(size);
 		}
 
-		// we found something
-		if(ptr)
+		if(!blk)
 		{
-			// Can we split the block?
-			if((blk->size - size) >= MIN_ALLOC_SZ)
-			{
-				alloc_node_t* new_blk;
-				new_blk = (alloc_node_t*)((uintptr_t)(&blk->block) + size);
-				new_blk->size = blk->size - size - ALLOC_HEADER_SZ;
-				blk->size = size;
-				list_add_(&new_blk->node, &blk->node, blk->node.next);
-			}
+			blk = free_list_find(size);
+		}
 
-			list_del(&blk->node);
+		// we found something
+		if(blk)
+		{
+			split_block(blk, size);
+			stats_add_used(block_size(blk));
 		}
+	}
 
-	} // else NULL
+	return blk;
+}
 
-	return ptr;
+/**
+ * Return a block to the heap, merging it with its free neighbors.
+ * The caller must hold the heap lock.
+ */
+static void heap_free(alloc_node_t* blk)
+{
+	alloc_node_t* neighbor;
+	size_t size = block_size(blk);
+
+	heap_stats.used_bytes -= size;
+
+	// Merge with the next block if it is free
+	neighbor = next_block(blk);
+	if(!block_in_use(neighbor))
+	{
+		free_block_remove(neighbor);
+		size += ALLOC_HEADER_SZ + block_size(neighbor);
+	}
+
+	// Merge with the previous block if it is free
+	neighbor = prev_block(blk);
+	if(!block_in_use(neighbor))
+	{
+		free_block_remove(neighbor);
+		size += ALLOC_HEADER_SZ + block_size(neighbor);
+		blk = neighbor;
+	}
+
+	set_block_size(blk, size, false);
+	free_block_insert(blk);
 }
 
-void free(void* ptr)
+/**
+ * The aligned address in a free block where an allocation of size bytes can start, or 0 if
+ * the block is too small. If the address isn't at the start of the block, the space in front
+ * of it must be big enough to become a free block of its own.
+ */
+static uintptr_t aligned_fit(alloc_node_t* blk, size_t size, size_t align)
 {
-	alloc_node_t *blk, *free_blk;
+	uintptr_t start = (uintptr_t)&blk->node;
+	uintptr_t end = start + block_size(blk);
+	uintptr_t ptr = align_up(start, align);
 
-	// Don't free a NULL pointer..
-	if(ptr)
+	if(ptr != start && (ptr - start) < MIN_ALLOC_SZ)
 	{
-		// we take the pointer and use container_of to get the corresponding alloc block
-		blk = container_of(ptr, alloc_node_t, block);
+		ptr = align_up(start + MIN_ALLOC_SZ, align);
+	}
+
+	return (ptr < end && (end - ptr) >= size) ? ptr : 0;
+}
+
+/**
+ * Allocate a block whose user pointer has the requested alignment. The free block that
+ * holds the aligned address is split there: the leading fragment goes back to the free
+ * lists, so no padding is wasted. The caller must hold the heap lock.
+ */
+static alloc_node_t* heap_alloc_aligned(size_t size, size_t align)
+{
+	alloc_node_t *blk, *aligned;
+	uintptr_t ptr = 0;
+
+	if(!size_classes_initialized)
+	{
+		return NULL;
+	}
+
+	// First fit, checking the size classes that may hold a large enough block first. That
+	// includes the request's own class, where only some of the blocks are large enough.
+	for(int c = block_size_class(size); c < SIZE_CLASS_COUNT && !ptr; c++)
+	{
+		if(size_class_bitmap & (1UL << c))
+		{
+			list_for_each_entry(blk, &size_class_list[c], node)
+			{
+				if((ptr = aligned_fit(blk, size, align)) != 0)
+				{
+					break;
+				}
+			}
+		}
+	}
 
-		// Let's put it back in the proper spot
-		list_for_each_entry(free_blk, &free_list, node)
+	if(!ptr)
+	{
+		list_for_each_entry(blk, &free_list, node)
 		{
-			if(free_blk > blk)
+			if((ptr = aligned_fit(blk, size, align)) != 0)
 			{
-				list_add_(&blk->node, free_blk->node.prev, &free_blk->node);
-				goto blockadded;
+				break;
 			}
 		}
-		list_add_tail(&blk->node, &free_list);
+	}
+
+	if(!ptr)
+	{
+		return NULL;
+	}
 
-	blockadded:
-		// Let's see if we can combine any memory
-		defrag_free_list();
+	free_block_remove(blk);
+	aligned = container_of((void*)ptr, alloc_node_t, node);
+
+	if(aligned != blk)
+	{
+		uintptr_t end = (uintptr_t)&blk->node + block_size(blk);
+
+		// The leading fragment keeps the start of the block. Its neighbors are both in use
+		// (or about to be), so it goes straight back on the free lists.
+		set_block_size(blk, (uintptr_t)aligned - (uintptr_t)&blk->node, false);
+		set_block_size(aligned, end - ptr, false);
+		free_block_insert(blk);
 	}
+
+	split_block(aligned, size);
+	stats_add_used(block_size(aligned));
+
+	return aligned;
 }
 
-void malloc_addblock(void* addr, size_t size)
+/**
+ * Give the end of an in-use block back to the heap, if it is big enough to be useful.
+ * Unlike split_block(), the next block may be free, so the remainder is merged with it.
+ * The caller must hold the heap lock.
+ */
+static void trim_block(alloc_node_t* blk, size_t size)
 {
-	alloc_node_t* blk;
+	size_t old_size = block_size(blk);
 
-	// let's align the start address of our block to the next pointer aligned number
-	blk = (void*)align_up((uintptr_t)addr, sizeof(void*));
+	if((old_size - size) >= MIN_ALLOC_SZ)
+	{
+		alloc_node_t* remainder;
 
-	// calculate actual size - remove our alignment and our header space from the availability
-	blk->size = (uintptr_t)addr + size - (uintptr_t)blk - ALLOC_HEADER_SZ;
+		set_block_size(blk, size, true);
+		remainder = next_block(blk);
+		set_block_size(remainder, old_size - size - ALLOC_HEADER_SZ, true);
 
-	// and now our giant block of memory is added to the list!
-	list_add(&blk->node, &free_list);
+		// heap_free() uncounts the remainder, but its header was counted as part of blk too
+		heap_stats.used_bytes -= ALLOC_HEADER_SZ;
+		heap_free(remainder);
+	}
+}
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+#pragma mark - Thread Cache -
+
+static inline void tcache_push(tcache_bin_t* bin, alloc_node_t* blk)
+{
+	blk->node.next = bin->head;
+	bin->head = &blk->node;
+	bin->count++;
+}
+
+static inline alloc_node_t* tcache_pop(tcache_bin_t* bin)
+{
+	ll_t* node = bin->head;
+
+	bin->head = node->next;
+	bin->count--;
+
+	return container_of(node, alloc_node_t, node);
+}
+
+static void tcache_exit(void* arg)
+{
+	(void)arg;
+
+	// A later destructor may use the cache again, which registers it again
+	tcache_registered = false;
+	malloc_thread_cache_flush();
+}
+
+static void tcache_key_create(void)
+{
+	pthread_key_create(&tcache_key, tcache_exit);
+}
+
+/**
+ * Make sure the calling thread's cache is flushed when the thread exits. Destructors only
+ * run for threads that have set a non-NULL value for the key.
+ */
+static inline void tcache_register(void)
+{
+	if(!tcache_registered)
+	{
+		// Set first, in case pthread_setspecific() allocates
+		tcache_registered = true;
+		pthread_once(&tcache_key_once, tcache_key_create);
+		pthread_setspecific(tcache_key, &tcache_registered);
+	}
+}
+
+/**
+ * Allocate a small block from the calling thread's cache, refilling the bin from the heap
+ * when it is empty. size must already be rounded by request_block_size().
+ */
+static alloc_node_t* tcache_alloc(size_t size)
+{
+	tcache_bin_t* bin = &tcache[block_size_class(size)];
+
+	if(bin->count == 0)
+	{
+		tcache_register();
+		heap_lock();
+
+		for(unsigned i = 0; i < TCACHE_BATCH_COUNT; i++)
+		{
+			alloc_node_t* blk = heap_alloc(size);
+
+			if(!blk)
+			{
+				break;
+			}
+
+			tcache_push(bin, blk);
+		}
+
+		heap_unlock();
+
+		if(bin->count == 0)
+		{
+			return NULL;
+		}
+	}
+
+	return tcache_pop(bin);
+}
+
+/**
+ * Cache a small block in the calling thread's bin for its size class. A block can
+ * serve any request of its class, because blocks are only ever a little larger than the
+ * power of two they were rounded up to.
+ */
+static void tcache_free(alloc_node_t* blk)
+{
+	tcache_bin_t* bin = &tcache[block_size_class(block_size(blk))];
+
+	tcache_register();
+
+	if(bin->count == TCACHE_BIN_CAPACITY)
+	{
+		heap_lock();
+
+		for(unsigned i = 0; i < TCACHE_BATCH_COUNT; i++)
+		{
+			heap_free(tcache_pop(bin));
+		}
+
+		heap_unlock();
+	}
+
+	tcache_push(bin, blk);
+}
+
+/**
+ * Return every block in the calling thread's cache to the heap. The caller must hold the heap
+ * lock. Returns false if the cache was empty.
+ */
+static bool tcache_flush(void)
+{
+	bool flushed = false;
+
+	for(int c = 0; c < SIZE_CLASS_COUNT; c++)
+	{
+		while(tcache[c].count)
+		{
+			heap_free(tcache_pop(&tcache[c]));
+			flushed = true;
+		}
+	}
+
+	return flushed;
+}
+#endif
+
+#ifdef MALLOC_FREELIST_EVENT_LOG
+#pragma mark - Event Log -
+
+static void event_log_record(malloc_event_type_t type, void* ptr, size_t size)
+{
+	static uint32_t seq = 0;
+	malloc_event_t* e;
+
+	heap_lock();
+
+	// Overwrite the oldest event when the log is full
+	if((event_log_head - event_log_tail) == MALLOC_FREELIST_EVENT_LOG_SIZE)
+	{
+		event_log_tail++;
+	}
+
+	e = &event_log[event_log_head & (MALLOC_FREELIST_EVENT_LOG_SIZE - 1)];
+	e->seq = seq++;
+	e->type = type;
+	e->ptr = ptr;
+	e->size = size;
+	event_log_head++;
+
+	heap_unlock();
+}
+#endif
+
+#pragma mark - Heap Walk -
+
+/**
+ * Visit every block in every pool, in address order. The caller must hold the heap lock.
+ */
+static void heap_walk(malloc_walk_cb_t cb, void* arg)
+{
+	ll_t* pool;
+
+	list_for_each(pool, &pool_list)
+	{
+		// The first block of the pool follows the start sentinel, and the walk stops at the
+		// end sentinel. Both sentinels have a size of 0, which real blocks never do.
+		alloc_node_t* blk = next_block((alloc_node_t*)(pool + 1));
+
+		while(block_size(blk) != 0)
+		{
+			const char* tag = NULL;
+
+#ifdef MALLOC_FREELIST_TAGS
+			tag = block_in_use(blk) ? blk->tag : NULL;
+#endif
+
+			cb(&blk->node, block_size(blk), block_in_use(blk), tag, arg);
+			blk = next_block(blk);
+		}
+	}
+}
+
+static void info_walk_cb(void* ptr, size_t size, bool in_use, const char* tag, void* arg)
+{
+	malloc_stats_t* stats = arg;
+
+	(void)ptr;
+	(void)tag;
+
+	if(in_use)
+	{
+		stats->used_block_count++;
+	}
+	else
+	{
+		stats->free_bytes += size;
+		stats->free_block_count++;
+		stats->free_block_histogram[flsl((long)size) - 1]++;
+
+		if(size > stats->largest_free_block)
+		{
+			stats->largest_free_block = size;
+		}
+	}
+}
+
+#pragma mark - Deferred Free -
+
+/**
+ * Return an in-use block to the thread cache or the heap
+ */
+static void release_block(alloc_node_t* blk)
+{
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	// Only the owner of an in-use block writes its size, so this is safe without the lock
+	if(block_size(blk) <= SMALL_BLOCK_MAX)
+	{
+		tcache_free(blk);
+	}
+	else
+#endif
+	{
+		heap_lock();
+		heap_free(blk);
+		heap_unlock();
+	}
+}
+
+/**
+ * Free every block that was passed to free_deferred() since the last drain
+ */
+static void drain_deferred(void)
+{
+	ll_t* node;
+
+	// Only read the shared list head in the common case where there is nothing to do
+	if(atomic_load_explicit(&deferred_list, memory_order_relaxed) == NULL)
+	{
+		return;
+	}
+
+	// Acquire pairs with the release in free_deferred(), so the links are visible
+	node = atomic_exchange_explicit(&deferred_list, NULL, memory_order_acquire);
+
+	while(node)
+	{
+		ll_t* next = node->next;
+
+		MALLOC_FREELIST_EVENT(MALLOC_EVENT_FREE, node, 0);
+		release_block(container_of(node, alloc_node_t, node));
+		node = next;
+	}
+}
+
+/**
+ * Shared implementation of malloc() and malloc_tagged()
+ */
+static void* allocate(size_t size, const char* tag)
+{
+	void* ptr = NULL;
+	alloc_node_t* blk = NULL;
+	size_t block_size = request_block_size(size);
+
+	(void)tag;
+
+	drain_deferred();
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	if(block_size <= SMALL_BLOCK_MAX)
+	{
+		blk = tcache_alloc(block_size);
+	}
+	else
+#endif
+	{
+		heap_lock();
+		blk = heap_alloc(block_size);
+		heap_unlock();
+	}
+
+	if(!blk)
+	{
+		heap_lock();
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+		// Blocks in the calling thread's cache may be enough once they are merged back
+		if(tcache_flush())
+		{
+			blk = heap_alloc(block_size);
+		}
+#endif
+
+		if(!blk)
+		{
+			heap_stats.failed_allocations++;
+		}
+
+		heap_unlock();
+	}
+
+	if(blk)
+	{
+#ifdef MALLOC_FREELIST_TAGS
+		blk->tag = tag;
+#endif
+		ptr = &blk->node;
+		MALLOC_FREELIST_EVENT(MALLOC_EVENT_MALLOC, ptr, size);
+	}
+
+	return ptr;
+}
+
+#pragma mark - APIs -
+
+void* aligned_alloc(size_t align, size_t size)
+{
+	alloc_node_t* blk = NULL;
+	void* ptr = NULL;
+	size_t block_size;
+
+	// Every block is already aligned to a pointer
+	if(align <= sizeof(void*))
+	{
+		return malloc(size);
+	}
+
+	if((align & (align - 1)) || size == 0)
+	{
+		return NULL;
+	}
+
+	block_size = request_block_size(size);
+
+	drain_deferred();
+
+	heap_lock();
+	blk = heap_alloc_aligned(block_size, align);
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	if(!blk && tcache_flush())
+	{
+		blk = heap_alloc_aligned(block_size, align);
+	}
+#endif
+
+	if(!blk)
+	{
+		heap_stats.failed_allocations++;
+	}
+
+	heap_unlock();
+
+	if(blk)
+	{
+#ifdef MALLOC_FREELIST_TAGS
+		blk->tag = NULL;
+#endif
+		ptr = &blk->node;
+		MALLOC_FREELIST_EVENT(MALLOC_EVENT_MALLOC, ptr, size);
+	}
+
+	return ptr;
+}
+
+void* malloc(size_t size)
+{
+	void* ptr = NULL;
+
+	if(size > 0)
+	{
+		ptr = allocate(size, NULL);
+	} // else NULL
+
+	return ptr;
+}
+
+#ifdef MALLOC_FREELIST_TAGS
+void* malloc_tagged(size_t size, const char* tag)
+{
+	void* ptr = NULL;
+
+	if(size > 0)
+	{
+		ptr = allocate(size, tag);
+	}
+
+	return ptr;
+}
+#endif
+
+void free(void* ptr)
+{
+	drain_deferred();
+
+	// Don't free a NULL pointer..
+	if(ptr)
+	{
+		MALLOC_FREELIST_EVENT(MALLOC_EVENT_FREE, ptr, 0);
+
+		// we take the pointer and use container_of to get the corresponding alloc block
+		release_block(container_of(ptr, alloc_node_t, node));
+	}
+}
+
+void free_deferred(void* ptr)
+{
+	ll_t* node;
+	ll_t* head;
+
+	if(ptr)
+	{
+		// The list node of a block overlaps the user's data, which they are done with
+		node = &container_of(ptr, alloc_node_t, node)->node;
+		head = atomic_load_explicit(&deferred_list, memory_order_relaxed);
+
+		do
+		{
+			node->next = head;
+		} while(!atomic_compare_exchange_weak_explicit(&deferred_list, &head, node,
+													   memory_order_release,
+													   memory_order_relaxed));
+	}
+}
+
+void free_deferred_drain(void)
+{
+	drain_deferred();
+}
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+void malloc_thread_cache_flush(void)
+{
+	heap_lock();
+	tcache_flush();
+	heap_unlock();
+}
+#endif
+
+size_t malloc_usable_size(void* ptr)
+{
+	// Only the owner of an in-use block writes its size, so this is safe without the lock
+	return ptr ? block_size(container_of(ptr, alloc_node_t, node)) : 0;
+}
+
+int malloc_resize_in_place(void* ptr, size_t request)
+{
+	alloc_node_t *blk, *next;
+	size_t size;
+	int r = -1;
+
+	if(!ptr || request == 0)
+	{
+		return -1;
+	}
+
+	blk = container_of(ptr, alloc_node_t, node);
+
+	// Round the same way malloc() does, so that thread-cached blocks stay reusable
+	size = request_block_size(request);
+
+	heap_lock();
+
+	if(size <= block_size(blk))
+	{
+		trim_block(blk, size);
+		r = 0;
+	}
+	else
+	{
+		// Grow into the next block if it is free and big enough
+		next = next_block(blk);
+
+		if(!block_in_use(next) && (block_size(blk) + ALLOC_HEADER_SZ + block_size(next)) >= size)
+		{
+			free_block_remove(next);
+			stats_add_used(ALLOC_HEADER_SZ + block_size(next));
+			set_block_size(blk, block_size(blk) + ALLOC_HEADER_SZ + block_size(next), true);
+			trim_block(blk, size);
+			r = 0;
+		}
+	}
+
+	heap_unlock();
+
+	if(r == 0)
+	{
+		MALLOC_FREELIST_EVENT(MALLOC_EVENT_RESIZE, ptr, request);
+	}
+
+	return r;
+}
+
+void malloc_stats(malloc_stats_t* stats)
+{
+	malloc_stats_t s = {0};
+
+	heap_lock();
+	s.pool_bytes = heap_stats.pool_bytes;
+	s.used_bytes = heap_stats.used_bytes;
+	s.peak_used_bytes = heap_stats.peak_used_bytes;
+	s.failed_allocations = heap_stats.failed_allocations;
+	heap_unlock();
+
+	*stats = s;
+}
+
+void malloc_info(malloc_stats_t* stats)
+{
+	malloc_stats_t s = {0};
+
+	heap_lock();
+	s.pool_bytes = heap_stats.pool_bytes;
+	s.used_bytes = heap_stats.used_bytes;
+	s.peak_used_bytes = heap_stats.peak_used_bytes;
+	s.failed_allocations = heap_stats.failed_allocations;
+	heap_walk(info_walk_cb, &s);
+	heap_unlock();
+
+	*stats = s;
+}
+
+void malloc_walk(malloc_walk_cb_t cb, void* arg)
+{
+	heap_lock();
+	heap_walk(cb, arg);
+	heap_unlock();
+}
+
+#ifdef MALLOC_FREELIST_EVENT_LOG
+size_t malloc_event_log_read(malloc_event_t* events, size_t count)
+{
+	size_t n = 0;
+
+	heap_lock();
+
+	while(n < count && event_log_tail != event_log_head)
+	{
+		events[n++] = event_log[event_log_tail & (MALLOC_FREELIST_EVENT_LOG_SIZE - 1)];
+		event_log_tail++;
+	}
+
+	heap_unlock();
+
+	return n;
+}
+#endif
+
+void malloc_addblock(void* addr, size_t size)
+{
+	alloc_node_t *start, *blk, *end;
+	ll_t* pool;
+
+	heap_lock();
+
+	if(!size_classes_initialized)
+	{
+		for(int c = 0; c < SIZE_CLASS_COUNT; c++)
+		{
+			size_class_list[c].next = &size_class_list[c];
+			size_class_list[c].prev = &size_class_list[c];
+		}
+
+		size_classes_initialized = true;
+	}
+
+	// let's align the start address of our block to the next pointer aligned number
+	pool = (void*)align_up((uintptr_t)addr, sizeof(void*));
+
+	// Each pool starts with a list node, so that malloc_walk() can find it
+	list_add_tail(pool, &pool_list);
+	start = (alloc_node_t*)(pool + 1);
+
+	// The pool is bracketed by two empty blocks that are always in use,
+	// so that free() never tries to merge past either end of the pool.
+	start->prev_size = 0;
+	start->size = 0 | BLOCK_IN_USE;
+
+	blk = next_block(start);
+	blk->prev_size = 0;
+
+	// calculate actual size - remove our alignment and the headers of the bracketing blocks
+	// and our block from the availability, and keep the end of the pool pointer-aligned
+	size = ((uintptr_t)addr + size - (uintptr_t)&blk->node - ALLOC_HEADER_SZ) &
+		   ~(sizeof(void*) - 1);
+
+	blk->size = size;
+	end = next_block(blk);
+	end->prev_size = size;
+	end->size = 0 | BLOCK_IN_USE;
+
+	// and now our giant block of memory is added to the list!
+	free_block_insert(blk);
+	heap_stats.pool_bytes += size;
+
+	heap_unlock();
 }
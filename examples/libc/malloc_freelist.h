@@ -1,6 +1,8 @@
 #ifndef __MALLOC_FREELIST_H_
 #define __MALLOC_FREELIST_H_
 
+#include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 #ifdef __cplusplus
@@ -13,6 +15,153 @@ extern "C"
 	 */
 	void malloc_addblock(void* addr, size_t size);
 
+	/**
+	 * Free memory from a context that must not call free(), such as an interrupt handler,
+	 * a signal handler, or a thread that doesn't own the heap.
+	 *
+	 * The block is pushed onto a lock-free stack, and is actually freed in a batch by the
+	 * next call to malloc(), free(), aligned_alloc(), or free_deferred_drain(). This never
+	 * takes the heap lock, so it is safe to call while another context holds it.
+	 */
+	void free_deferred(void* ptr);
+
+	/// Free every block that was passed to free_deferred(), e.g. from an idle loop
+	void free_deferred_drain(void);
+
+	/// See stdlib.h
+	size_t malloc_usable_size(void* ptr);
+
+	/// See stdlib.h
+	int malloc_resize_in_place(void* ptr, size_t size);
+
+	/**
+	 * Return the calling thread's cached blocks to the shared heap.
+	 *
+	 * Only available when built with MALLOC_FREELIST_THREAD_CACHE. This happens automatically
+	 * when a thread exits. Call it to release the memory earlier, for example before a thread
+	 * goes idle.
+	 */
+	void malloc_thread_cache_flush(void);
+
+	/**
+	 * Lock hooks for multi-threaded builds (MALLOC_FREELIST_THREADSAFE or
+	 * MALLOC_FREELIST_THREAD_CACHE). These must be provided by the platform,
+	 * for example with a mutex or by disabling interrupts.
+	 */
+	void malloc_lock(void);
+	void malloc_unlock(void);
+
+	/// The number of buckets in malloc_stats_t::free_block_histogram
+#define MALLOC_HISTOGRAM_BUCKETS (sizeof(size_t) * 8)
+
+	/**
+	 * Heap statistics
+	 *
+	 * Blocks that are held in a thread's cache (see MALLOC_FREELIST_THREAD_CACHE) are
+	 * counted as in use.
+	 */
+	typedef struct
+	{
+		/// Bytes available for allocation in all pools, after alignment and bookkeeping
+		size_t pool_bytes;
+		/// Bytes in allocated blocks, including the rounding up of requests
+		size_t used_bytes;
+		/// The highest value of used_bytes so far
+		size_t peak_used_bytes;
+		/// The number of calls to malloc() that returned NULL for a non-zero size
+		size_t failed_allocations;
+
+		/// The fields below are only filled in by malloc_info()
+
+		/// Bytes in free blocks
+		size_t free_bytes;
+		/// The largest allocation that can currently succeed
+		size_t largest_free_block;
+		/// The number of blocks in the free lists
+		size_t free_block_count;
+		/// The number of allocated blocks
+		size_t used_block_count;
+		/// free_block_histogram[n] counts the free blocks with a size in [2^n, 2^(n+1))
+		size_t free_block_histogram[MALLOC_HISTOGRAM_BUCKETS];
+	} malloc_stats_t;
+
+	/**
+	 * Read the running heap counters in O(1): pool_bytes, used_bytes, peak_used_bytes,
+	 * and failed_allocations. The other fields are set to 0.
+	 */
+	void malloc_stats(malloc_stats_t* stats);
+
+	/**
+	 * Read all of the heap statistics. This walks every block in the heap with the
+	 * heap locked, so it is meant for diagnostics rather than frequent use.
+	 */
+	void malloc_info(malloc_stats_t* stats);
+
+	/**
+	 * Visit every block in the heap, in address order
+	 *
+	 * ptr is the address that was (or would be) returned to the user, and size is the size
+	 * of the block. tag is the call site passed to malloc_tagged(), or NULL. The callback
+	 * runs with the heap locked, so it must not allocate or free memory.
+	 */
+	typedef void (*malloc_walk_cb_t)(void* ptr, size_t size, bool in_use, const char* tag,
+									 void* arg);
+
+	void malloc_walk(malloc_walk_cb_t cb, void* arg);
+
+#ifdef MALLOC_FREELIST_TAGS
+	/**
+	 * Allocate memory and record the call site in the block, so that heap usage can be
+	 * attributed with malloc_walk(). Use the MALLOC_TAGGED() macro to tag with the
+	 * file and line. Tagging adds a pointer to the header of every block.
+	 */
+	void* malloc_tagged(size_t size, const char* tag);
+
+	#define MALLOC_TAG_STRINGIFY_(x) #x
+	#define MALLOC_TAG_STRINGIFY(x) MALLOC_TAG_STRINGIFY_(x)
+	#define MALLOC_TAGGED(size) malloc_tagged(size, __FILE__ ":" MALLOC_TAG_STRINGIFY(__LINE__))
+#else
+	#define MALLOC_TAGGED(size) malloc(size)
+#endif
+
+	typedef enum
+	{
+		MALLOC_EVENT_MALLOC,
+		MALLOC_EVENT_FREE,
+		/// A block was resized in place. A block that moves is recorded as a malloc and a free.
+		MALLOC_EVENT_RESIZE,
+	} malloc_event_type_t;
+
+	/// An allocator event, see MALLOC_FREELIST_EVENT_LOG
+	typedef struct
+	{
+		/// Incremented for every event, so a gap shows that events were overwritten
+		uint32_t seq;
+		malloc_event_type_t type;
+		void* ptr;
+		/// The requested size for malloc and resize events, 0 for free
+		size_t size;
+	} malloc_event_t;
+
+	/**
+	 * Copy up to count of the oldest recorded events into events, and remove them
+	 * from the log.
+	 *
+	 * Only available when built with MALLOC_FREELIST_EVENT_LOG, which records every
+	 * allocator event into a ring buffer of MALLOC_FREELIST_EVENT_LOG_SIZE entries. When the
+	 * ring is full, the oldest event is overwritten. Draining the log periodically gives a
+	 * trace that can be replayed offline. To replay it with malloc_freelist_benchmark, map
+	 * each live pointer to a slot number.
+	 *
+	 * @returns the number of events copied
+	 */
+	size_t malloc_event_log_read(malloc_event_t* events, size_t count);
+
+#ifndef MALLOC_FREELIST_EVENT_LOG_SIZE
+	/// The number of events that the log holds. Must be a power of two.
+	#define MALLOC_FREELIST_EVENT_LOG_SIZE 256
+#endif
+
 #ifdef __cplusplus
 }
 #endif //__cplusplus
@@ -0,0 +1,1083 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "../malloc_freelist.h"
+
+/// These tests run against the host, so malloc_freelist is built with its symbols renamed
+/// (see libc_malloc_freelist_host_args). This file is compiled with the same renames, so the
+/// calls below reach malloc_freelist rather than the host's allocator.
+///
+/// The allocator can't be reset, so every test must free everything it allocates.
+///
+/// The tests are also built with MALLOC_FREELIST_THREAD_CACHE, as malloc_freelist_thread_cache,
+/// and with MALLOC_FREELIST_TAGS and MALLOC_FREELIST_EVENT_LOG, as malloc_freelist_instrumented.
+
+#define align_up(num, align) (((num) + ((align)-1)) & ~((align)-1))
+
+#define POOL_SIZE (8 * 1024 * 1024)
+#define MAX_ALIGN (2 * 1024 * 1024)
+#define DEFERRED_THREAD_COUNT 4
+#define DEFERRED_BLOCKS_PER_THREAD 64
+#define CACHE_THREAD_COUNT 4
+#define TCACHE_TEST_BLOCKS 64
+#define REALLOC_SLOTS 64
+#define REALLOC_ITERATIONS 20000
+#define REALLOC_MAX_SIZE 20000
+
+#define WALK_MAX_BLOCKS 16
+#define FRAGMENT_COUNT 8
+#define FRAGMENT_SIZE 8192
+#define COALESCE_COUNT 7
+#define COALESCE_SIZE 5000
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+#define TEST_GROUP_NAME "malloc_freelist_thread_cache"
+#elif defined(MALLOC_FREELIST_TAGS)
+#define TEST_GROUP_NAME "malloc_freelist_instrumented"
+#else
+#define TEST_GROUP_NAME "malloc_freelist"
+#endif
+
+static _Alignas(64) uint8_t pool_[POOL_SIZE];
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+#pragma mark - Lock Hooks -
+
+static pthread_mutex_t malloc_mutex_ = PTHREAD_MUTEX_INITIALIZER;
+
+void malloc_lock(void)
+{
+	pthread_mutex_lock(&malloc_mutex_);
+}
+
+void malloc_unlock(void)
+{
+	pthread_mutex_unlock(&malloc_mutex_);
+}
+#endif
+
+#pragma mark - Helpers -
+
+/// Return the calling thread's cached blocks to the heap, which counts them as in use
+static void flush_thread_cache(void)
+{
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	malloc_thread_cache_flush();
+#endif
+}
+
+/// Check that the heap is back to a single free block that spans the whole pool
+static void assert_heap_empty(void)
+{
+	malloc_stats_t stats;
+
+	flush_thread_cache();
+	malloc_info(&stats);
+	assert_int_equal(0, stats.used_bytes);
+	assert_int_equal(0, stats.used_block_count);
+	assert_int_equal(1, stats.free_block_count);
+	assert_int_equal(stats.pool_bytes, stats.free_bytes);
+	assert_int_equal(stats.pool_bytes, stats.largest_free_block);
+}
+
+static void fill(void* ptr, size_t size, uint8_t value)
+{
+	memset(ptr, value, size);
+}
+
+static void assert_filled(const void* ptr, size_t size, uint8_t value)
+{
+	const uint8_t* p = ptr;
+
+	for(size_t i = 0; i < size; i++)
+	{
+		assert_int_equal(value, p[i]);
+	}
+}
+
+/// The malloc_stats_t::free_block_histogram bucket for a free block: floor(log2(size))
+static size_t histogram_bucket(size_t size)
+{
+	size_t bucket = 0;
+
+	while(size >>= 1)
+	{
+		bucket++;
+	}
+
+	return bucket;
+}
+
+typedef struct
+{
+	void* ptr;
+	size_t size;
+	bool in_use;
+	const char* tag;
+} walk_entry_t;
+
+typedef struct
+{
+	walk_entry_t entries[WALK_MAX_BLOCKS];
+	size_t count;
+} walk_t;
+
+static void walk_cb(void* ptr, size_t size, bool in_use, const char* tag, void* arg)
+{
+	walk_t* walk = arg;
+
+	if(walk->count < WALK_MAX_BLOCKS)
+	{
+		walk->entries[walk->count] = (walk_entry_t){ptr, size, in_use, tag};
+	}
+
+	walk->count++;
+}
+
+/// The size of the free block at ptr, which must be in the heap walk
+static size_t free_block_size(const void* ptr)
+{
+	walk_t walk = {0};
+
+	malloc_walk(walk_cb, &walk);
+
+	for(size_t i = 0; i < walk.count && i < WALK_MAX_BLOCKS; i++)
+	{
+		if(walk.entries[i].ptr == ptr)
+		{
+			assert_false(walk.entries[i].in_use);
+			return walk.entries[i].size;
+		}
+	}
+
+	fail_msg("%p is not in the heap walk", ptr);
+
+	return 0;
+}
+
+/// The number of free blocks in the heap
+static size_t free_block_count(void)
+{
+	malloc_stats_t stats;
+
+	malloc_info(&stats);
+
+	return stats.free_block_count;
+}
+
+static int malloc_freelist_group_setup(void** state)
+{
+	(void)state;
+
+	malloc_addblock(pool_, POOL_SIZE);
+
+	return 0;
+}
+
+#pragma mark - Tests -
+
+static void malloc_free_test(void** state)
+{
+	void* p[64];
+	(void)state;
+
+	assert_heap_empty();
+	assert_null(malloc(0));
+
+	for(int i = 0; i < 64; i++)
+	{
+		p[i] = malloc((size_t)(i + 1) * 40);
+		assert_non_null(p[i]);
+		assert_int_equal(0, (uintptr_t)p[i] & (sizeof(void*) - 1));
+		fill(p[i], (size_t)(i + 1) * 40, (uint8_t)i);
+	}
+
+	for(int i = 0; i < 64; i++)
+	{
+		assert_filled(p[i], (size_t)(i + 1) * 40, (uint8_t)i);
+	}
+
+	// Free every other block first, so that the rest have free neighbors on both sides
+	for(int i = 0; i < 64; i += 2)
+	{
+		free(p[i]);
+	}
+
+	for(int i = 1; i < 64; i += 2)
+	{
+		free(p[i]);
+	}
+
+	assert_heap_empty();
+}
+
+static void request_size_test(void** state)
+{
+	void* p;
+	(void)state;
+
+	// Small requests are only aligned, unless the thread cache needs them rounded up to their
+	// size class
+	p = malloc(2049);
+	assert_non_null(p);
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+	assert_int_equal(4096, malloc_usable_size(p));
+#else
+	assert_int_equal(align_up(2049, sizeof(void*)), malloc_usable_size(p));
+#endif
+	free(p);
+
+	p = malloc(1);
+	assert_non_null(p);
+	assert_int_equal(32, malloc_usable_size(p));
+	free(p);
+
+	assert_heap_empty();
+}
+
+#ifndef MALLOC_FREELIST_THREAD_CACHE
+/// The thread cache serves small requests from its own bins, so this only runs without it
+static void size_class_test(void** state)
+{
+	void* guards[5];
+	uint8_t *h1, *h2, *h3, *h4;
+	uint8_t *p, *q, *r, *s, *t;
+	(void)state;
+
+	// Holes in different size classes, separated by allocated blocks so they can't merge
+	guards[0] = malloc(64);
+	h1 = malloc(1024);
+	guards[1] = malloc(64);
+	h2 = malloc(256);
+	guards[2] = malloc(64);
+	h3 = malloc(2048);
+	guards[3] = malloc(64);
+	h4 = malloc(3600);
+	guards[4] = malloc(64);
+	assert_non_null(h1);
+	assert_non_null(h2);
+	assert_non_null(h3);
+	assert_non_null(h4);
+
+	for(size_t i = 0; i < 5; i++)
+	{
+		assert_non_null(guards[i]);
+	}
+
+	free(h1);
+	free(h2);
+	free(h3);
+
+	// A request is served from the smallest non-empty class that is large enough: 256 bytes
+	// fits h2 exactly, and 300 bytes skips h2 and takes h1 rather than the larger h3
+	p = malloc(256);
+	assert_ptr_equal(h2, p);
+
+	q = malloc(300);
+	assert_ptr_equal(h1, q);
+
+	r = malloc(2048);
+	assert_ptr_equal(h3, r);
+
+	// The rest of h1 is too small for this, and h3's class is empty again, so it comes from
+	// the large blocks at the end of the pool
+	s = malloc(1500);
+	assert_non_null(s);
+	assert_true(s > (uint8_t*)guards[4]);
+
+	// A freed block goes back to its class, which is searched before the large blocks
+	free(r);
+	r = malloc(1500);
+	assert_ptr_equal(h3, r);
+
+	// 3000 bytes needs class 12, which is empty. h4 is in class 11 with smaller blocks, but it
+	// is large enough, so it is found before the large blocks. In a pool with nothing else
+	// free, the request would otherwise fail.
+	free(h4);
+	t = malloc(3000);
+	assert_ptr_equal(h4, t);
+
+	free(p);
+	free(q);
+	free(r);
+	free(s);
+	free(t);
+
+	for(size_t i = 0; i < 5; i++)
+	{
+		free(guards[i]);
+	}
+
+	assert_heap_empty();
+}
+#endif
+
+static void malloc_whole_pool_test(void** state)
+{
+	malloc_stats_t before;
+	malloc_stats_t after;
+	void* p;
+	(void)state;
+
+	// With the thread cache, this leaves blocks cached in the middle of the pool. They have to
+	// be returned to the heap before the whole pool can be allocated.
+	p = malloc(100);
+	assert_non_null(p);
+	free(p);
+
+	malloc_stats(&before);
+	p = malloc(before.pool_bytes);
+	assert_non_null(p);
+	malloc_stats(&after);
+	assert_int_equal(before.failed_allocations, after.failed_allocations);
+	free(p);
+
+	// The same applies to aligned allocations, which leave room in front of the block to
+	// reach the alignment
+	p = malloc(100);
+	assert_non_null(p);
+	free(p);
+
+	p = aligned_alloc(64, before.pool_bytes - 256);
+	assert_non_null(p);
+	free(p);
+
+	assert_heap_empty();
+}
+
+/// Blocks larger than the size classes, so that frees go straight to the heap
+static void coalesce_test(void** state)
+{
+	uint8_t* b[COALESCE_COUNT];
+	(void)state;
+
+	for(size_t i = 0; i < COALESCE_COUNT; i++)
+	{
+		b[i] = malloc(COALESCE_SIZE);
+		assert_non_null(b[i]);
+		assert_int_equal(COALESCE_SIZE, malloc_usable_size(b[i]));
+	}
+
+	// The blocks are carved from the start of the pool, followed by the rest of it
+	for(size_t i = 1; i < COALESCE_COUNT; i++)
+	{
+		assert_true(b[i] > b[i - 1]);
+	}
+
+	flush_thread_cache();
+	assert_int_equal(1, free_block_count());
+
+	// Both neighbors are in use
+	free(b[1]);
+	assert_int_equal(2, free_block_count());
+	assert_int_equal(COALESCE_SIZE, free_block_size(b[1]));
+
+	// Merges with the previous block
+	free(b[2]);
+	assert_int_equal(2, free_block_count());
+	assert_int_equal(b[2] + COALESCE_SIZE - b[1], free_block_size(b[1]));
+
+	free(b[5]);
+	assert_int_equal(3, free_block_count());
+
+	// Merges with the next block
+	free(b[4]);
+	assert_int_equal(3, free_block_count());
+	assert_int_equal(b[5] + COALESCE_SIZE - b[4], free_block_size(b[4]));
+
+	// Merges with both neighbors
+	free(b[3]);
+	assert_int_equal(2, free_block_count());
+	assert_int_equal(b[5] + COALESCE_SIZE - b[1], free_block_size(b[1]));
+
+	// Merges with both neighbors, the second of which is the rest of the pool
+	free(b[6]);
+	assert_int_equal(1, free_block_count());
+
+	// Merges with the next block. The first block of the pool has no previous block to merge.
+	free(b[0]);
+
+	assert_heap_empty();
+}
+
+static void aligned_alloc_test(void** state)
+{
+	(void)state;
+
+	void* q = malloc(100);
+	size_t usable_size = malloc_usable_size(q);
+
+	free(q);
+
+	for(size_t align = 1; align <= MAX_ALIGN; align <<= 1)
+	{
+		malloc_stats_t stats;
+		uint8_t* p = aligned_alloc(align, 100);
+
+		assert_non_null(p);
+		assert_int_equal(0, (uintptr_t)p & (align - 1));
+		assert_true(p >= pool_ && p + 100 <= pool_ + POOL_SIZE);
+		fill(p, 100, 0xA5);
+
+		// The block is only as big as an ordinary 100 byte allocation: there is no padding
+		flush_thread_cache();
+		malloc_stats(&stats);
+		assert_int_equal(malloc_usable_size(p), stats.used_bytes);
+		assert_int_equal(usable_size, malloc_usable_size(p));
+
+		free(p);
+		assert_heap_empty();
+	}
+}
+
+static void aligned_alloc_large_test(void** state)
+{
+	uint8_t* p;
+	uint8_t* q;
+	(void)state;
+
+	// Large blocks at the largest alignment, next to an unaligned allocation
+	q = malloc(1000);
+	p = aligned_alloc(MAX_ALIGN, MAX_ALIGN + 1);
+
+	assert_non_null(q);
+	assert_non_null(p);
+	assert_int_equal(0, (uintptr_t)p & (MAX_ALIGN - 1));
+	fill(q, 1000, 1);
+	fill(p, MAX_ALIGN + 1, 2);
+	assert_filled(q, 1000, 1);
+
+	free(q);
+	free(p);
+	assert_heap_empty();
+}
+
+static void aligned_alloc_mixed_test(void** state)
+{
+	static const size_t alignments[] = {16, 64, 4096, 65536};
+	void* p[32];
+	(void)state;
+
+	for(int i = 0; i < 32; i++)
+	{
+		size_t align = alignments[i % 4];
+
+		p[i] = (i % 3) ? aligned_alloc(align, 24 + (size_t)i * 100) : malloc(24 + (size_t)i * 100);
+		assert_non_null(p[i]);
+
+		if(i % 3)
+		{
+			assert_int_equal(0, (uintptr_t)p[i] & (align - 1));
+		}
+
+		fill(p[i], 24 + (size_t)i * 100, (uint8_t)i);
+	}
+
+	for(int i = 0; i < 32; i++)
+	{
+		assert_filled(p[i], 24 + (size_t)i * 100, (uint8_t)i);
+	}
+
+	for(int i = 31; i >= 0; i -= 2)
+	{
+		free(p[i]);
+	}
+
+	for(int i = 30; i >= 0; i -= 2)
+	{
+		free(p[i]);
+	}
+
+	assert_heap_empty();
+}
+
+static void aligned_alloc_invalid_test(void** state)
+{
+	malloc_stats_t before;
+	malloc_stats_t after;
+	(void)state;
+
+	assert_null(aligned_alloc(24, 100));
+	assert_null(aligned_alloc(64, 0));
+
+	// Larger than the pool can ever satisfy
+	malloc_stats(&before);
+	assert_null(aligned_alloc(64, POOL_SIZE));
+	malloc_stats(&after);
+	assert_int_equal(before.failed_allocations + 1, after.failed_allocations);
+
+	assert_heap_empty();
+}
+
+static void realloc_null_and_zero_test(void** state)
+{
+	uint8_t* p;
+	(void)state;
+
+	// realloc(NULL, n) is malloc(n)
+	p = realloc(NULL, 100);
+	assert_non_null(p);
+	assert_true(malloc_usable_size(p) >= 100);
+	fill(p, 100, 0x5A);
+
+	// A size of 0 returns NULL and leaves the block alone, while reallocf() frees it
+	assert_null(realloc(p, 0));
+	assert_filled(p, 100, 0x5A);
+	assert_null(reallocf(p, 0));
+
+	assert_null(realloc(NULL, 0));
+
+	assert_heap_empty();
+}
+
+/// Blocks larger than the size classes, so that the thread cache doesn't hold their neighbors
+static void realloc_in_place_test(void** state)
+{
+	malloc_stats_t stats;
+	uint8_t *p, *q, *r;
+	(void)state;
+
+	// Grow into the free block that follows
+	p = malloc(5000);
+	assert_non_null(p);
+	fill(p, 5000, 1);
+
+	q = realloc(p, 20000);
+	assert_ptr_equal(p, q);
+	assert_true(malloc_usable_size(q) >= 20000);
+	assert_filled(q, 5000, 1);
+
+	// Shrink, merging the tail with the free block that follows
+	p = realloc(q, 8000);
+	assert_ptr_equal(q, p);
+	assert_int_equal(align_up(8000, sizeof(void*)), malloc_usable_size(p));
+	assert_filled(p, 5000, 1);
+
+	flush_thread_cache();
+	malloc_info(&stats);
+	assert_int_equal(1, stats.free_block_count);
+
+	// Shrink in front of an allocated block: the tail becomes a free block of its own
+	q = malloc(10000);
+	assert_non_null(q);
+	assert_true(q > p);
+
+	r = realloc(p, 2000);
+	assert_ptr_equal(p, r);
+	assert_filled(p, 2000, 1);
+
+	flush_thread_cache();
+	malloc_info(&stats);
+	assert_int_equal(2, stats.free_block_count);
+
+	// The tail can be allocated again
+	r = malloc(5000);
+	assert_non_null(r);
+	assert_true(r > p && r < q);
+
+	// Shrinking by less than a minimum block keeps the block as it is
+	assert_ptr_equal(q, realloc(q, 9990));
+	assert_int_equal(10000, malloc_usable_size(q));
+
+	free(r);
+	free(q);
+	free(p);
+
+	assert_heap_empty();
+}
+
+static void realloc_move_test(void** state)
+{
+	uint8_t *p, *q, *r, *t;
+	(void)state;
+
+	// q sits right after p, so p can't grow in place
+	p = malloc(5000);
+	q = malloc(5000);
+	assert_non_null(p);
+	assert_non_null(q);
+	fill(p, 5000, 1);
+	fill(q, 5000, 2);
+
+	// Mark the space after q, where the moved block will be allocated. Freeing t merges it back
+	// into the rest of the pool, which leaves its contents alone past the list node.
+	t = malloc(30000);
+	assert_non_null(t);
+	fill(t, 30000, 3);
+	free(t);
+
+	// ASan can't see past the end of a block inside the pool, so check that only the old
+	// block's bytes were copied: copying any more would overwrite the marks with q's header
+	// and data
+	r = realloc(p, 30000);
+	assert_ptr_equal(t, r);
+	assert_filled(r, 5000, 1);
+	assert_filled(r + 5000, 30000 - 5000, 3);
+	assert_filled(q, 5000, 2);
+
+	// The old block was freed, so it can be allocated again
+	p = malloc(5000);
+	assert_non_null(p);
+
+	free(p);
+	free(q);
+	free(r);
+
+	assert_heap_empty();
+}
+
+static void realloc_random_test(void** state)
+{
+	uint8_t* slots[REALLOC_SLOTS] = {NULL};
+	size_t sizes[REALLOC_SLOTS] = {0};
+	uint32_t random = 12345;
+	(void)state;
+
+	for(size_t i = 0; i < REALLOC_ITERATIONS; i++)
+	{
+		size_t slot, size, kept;
+
+		random = random * 1103515245 + 12345;
+		slot = (random >> 8) % REALLOC_SLOTS;
+		random = random * 1103515245 + 12345;
+		size = (random >> 8) % REALLOC_MAX_SIZE;
+
+		if(size == 0)
+		{
+			free(slots[slot]);
+			slots[slot] = NULL;
+			sizes[slot] = 0;
+			continue;
+		}
+
+		slots[slot] = realloc(slots[slot], size);
+		assert_non_null(slots[slot]);
+
+		// Each slot is filled with its own value, which must survive the move or resize
+		kept = (sizes[slot] < size) ? sizes[slot] : size;
+		assert_filled(slots[slot], kept, (uint8_t)slot);
+		fill(slots[slot], size, (uint8_t)slot);
+		sizes[slot] = size;
+	}
+
+	for(size_t slot = 0; slot < REALLOC_SLOTS; slot++)
+	{
+		free(slots[slot]);
+	}
+
+	assert_heap_empty();
+}
+
+/// Blocks larger than the size classes, so that the thread cache doesn't appear in the walk
+static void malloc_walk_test(void** state)
+{
+	walk_t walk = {0};
+	uint8_t *a, *b, *c;
+#ifdef MALLOC_FREELIST_TAGS
+	uint8_t* d;
+#endif
+	(void)state;
+
+	a = MALLOC_TAGGED(5000);
+	b = malloc(6000);
+	c = MALLOC_TAGGED(7000);
+	assert_non_null(a);
+	assert_non_null(b);
+	assert_non_null(c);
+	free(b);
+
+	flush_thread_cache();
+	malloc_walk(walk_cb, &walk);
+
+	// Address order: a, the free block left by b, c, and the rest of the pool
+	assert_int_equal(4, walk.count);
+	assert_ptr_equal(a, walk.entries[0].ptr);
+	assert_ptr_equal(b, walk.entries[1].ptr);
+	assert_ptr_equal(c, walk.entries[2].ptr);
+	assert_true((uint8_t*)walk.entries[3].ptr > c);
+
+	assert_true(walk.entries[0].in_use);
+	assert_false(walk.entries[1].in_use);
+	assert_true(walk.entries[2].in_use);
+	assert_false(walk.entries[3].in_use);
+
+	assert_int_equal(malloc_usable_size(a), walk.entries[0].size);
+	assert_int_equal(6000, walk.entries[1].size);
+	assert_int_equal(malloc_usable_size(c), walk.entries[2].size);
+
+	// Free blocks never have a tag
+	assert_null(walk.entries[1].tag);
+	assert_null(walk.entries[3].tag);
+
+#ifdef MALLOC_FREELIST_TAGS
+	// MALLOC_TAGGED() records the file and line of the call
+	assert_non_null(walk.entries[0].tag);
+	assert_non_null(walk.entries[2].tag);
+	assert_non_null(strstr(walk.entries[0].tag, "malloc_freelist_tests.c:"));
+	assert_non_null(strstr(walk.entries[2].tag, "malloc_freelist_tests.c:"));
+	assert_string_not_equal(walk.entries[0].tag, walk.entries[2].tag);
+
+	// Untagged blocks, and explicit tags
+	b = malloc(6000);
+	d = malloc_tagged(20000, "explicit");
+	assert_non_null(b);
+	assert_non_null(d);
+
+	walk.count = 0;
+	malloc_walk(walk_cb, &walk);
+	assert_int_equal(5, walk.count);
+	assert_ptr_equal(b, walk.entries[1].ptr);
+	assert_null(walk.entries[1].tag);
+	assert_ptr_equal(d, walk.entries[3].ptr);
+	assert_string_equal("explicit", walk.entries[3].tag);
+
+	free(b);
+	free(d);
+#else
+	// Without tags, MALLOC_TAGGED() is malloc()
+	assert_null(walk.entries[0].tag);
+	assert_null(walk.entries[2].tag);
+#endif
+
+	free(a);
+	free(c);
+
+	assert_heap_empty();
+}
+
+static void malloc_info_fragmentation_test(void** state)
+{
+	malloc_stats_t stats;
+	uint8_t* blocks[FRAGMENT_COUNT];
+	size_t tail;
+	(void)state;
+
+	for(size_t i = 0; i < FRAGMENT_COUNT; i++)
+	{
+		blocks[i] = malloc(FRAGMENT_SIZE);
+		assert_non_null(blocks[i]);
+	}
+
+	flush_thread_cache();
+	malloc_info(&stats);
+	assert_int_equal(FRAGMENT_COUNT, stats.used_block_count);
+	assert_int_equal(1, stats.free_block_count);
+	tail = stats.largest_free_block;
+
+	// Three holes of FRAGMENT_SIZE bytes, which can't merge because their neighbors are in use
+	free(blocks[1]);
+	free(blocks[3]);
+	free(blocks[5]);
+
+	malloc_info(&stats);
+	assert_int_equal(FRAGMENT_COUNT - 3, stats.used_block_count);
+	assert_int_equal(4, stats.free_block_count);
+	assert_int_equal(tail + 3 * FRAGMENT_SIZE, stats.free_bytes);
+	assert_int_equal(tail, stats.largest_free_block);
+	assert_int_equal(3, stats.free_block_histogram[13]); // 8 KiB
+	assert_int_equal(1, stats.free_block_histogram[histogram_bucket(tail)]);
+
+	// Freeing the block between two holes merges all three into one hole of over 24 KiB
+	free(blocks[2]);
+
+	malloc_info(&stats);
+	assert_int_equal(3, stats.free_block_count);
+	assert_int_equal(1, stats.free_block_histogram[13]);
+	assert_int_equal(1, stats.free_block_histogram[14]);
+	assert_true(stats.free_bytes > tail + 4 * FRAGMENT_SIZE);
+
+	// The last block merges with the rest of the pool
+	free(blocks[FRAGMENT_COUNT - 1]);
+
+	malloc_info(&stats);
+	assert_int_equal(3, stats.free_block_count);
+	assert_true(stats.largest_free_block > tail + FRAGMENT_SIZE);
+
+	free(blocks[0]);
+	free(blocks[4]);
+	free(blocks[6]);
+
+	assert_heap_empty();
+}
+
+#ifdef MALLOC_FREELIST_EVENT_LOG
+/// Remove every event from the log, and return the sequence number of the last one
+static uint32_t event_log_drain(void)
+{
+	malloc_event_t event;
+	uint32_t seq = 0;
+
+	while(malloc_event_log_read(&event, 1) == 1)
+	{
+		seq = event.seq;
+	}
+
+	return seq;
+}
+
+static void event_log_test(void** state)
+{
+	static malloc_event_t events[MALLOC_FREELIST_EVENT_LOG_SIZE + 1];
+	uint32_t seq;
+	void* p;
+	(void)state;
+
+	// Learn the current sequence number
+	free(NULL);
+	p = malloc(100);
+	free(p);
+	seq = event_log_drain();
+
+	// Fill the log exactly, with malloc and free events
+	for(size_t i = 0; i < MALLOC_FREELIST_EVENT_LOG_SIZE / 2; i++)
+	{
+		p = malloc(100 + i);
+		assert_non_null(p);
+		free(p);
+	}
+
+	assert_int_equal(MALLOC_FREELIST_EVENT_LOG_SIZE,
+					 malloc_event_log_read(events, MALLOC_FREELIST_EVENT_LOG_SIZE + 1));
+
+	for(size_t i = 0; i < MALLOC_FREELIST_EVENT_LOG_SIZE; i++)
+	{
+		assert_int_equal(seq + 1 + i, events[i].seq);
+
+		if(i % 2 == 0)
+		{
+			assert_int_equal(MALLOC_EVENT_MALLOC, events[i].type);
+			assert_int_equal(100 + i / 2, events[i].size);
+		}
+		else
+		{
+			assert_int_equal(MALLOC_EVENT_FREE, events[i].type);
+			assert_ptr_equal(events[i - 1].ptr, events[i].ptr);
+			assert_int_equal(0, events[i].size);
+		}
+	}
+
+	seq = events[MALLOC_FREELIST_EVENT_LOG_SIZE - 1].seq;
+
+	// Four events, of which one is read
+	p = malloc(200);
+	free(p);
+	p = malloc(300);
+	free(p);
+	assert_int_equal(1, malloc_event_log_read(events, 1));
+	assert_int_equal(seq + 1, events[0].seq);
+
+	// A full log's worth of events overwrites the other three, which leaves a gap
+	for(size_t i = 0; i < MALLOC_FREELIST_EVENT_LOG_SIZE / 2; i++)
+	{
+		p = malloc(100);
+		free(p);
+	}
+
+	assert_int_equal(MALLOC_FREELIST_EVENT_LOG_SIZE,
+					 malloc_event_log_read(events, MALLOC_FREELIST_EVENT_LOG_SIZE + 1));
+	assert_int_equal(seq + 5, events[0].seq);
+	assert_int_equal(seq + 4 + MALLOC_FREELIST_EVENT_LOG_SIZE,
+					 events[MALLOC_FREELIST_EVENT_LOG_SIZE - 1].seq);
+
+	// In-place resizes are logged with their requested size
+	p = malloc(5000);
+	assert_ptr_equal(p, realloc(p, 10000));
+	free(p);
+
+	assert_int_equal(3, malloc_event_log_read(events, 3));
+	assert_int_equal(MALLOC_EVENT_MALLOC, events[0].type);
+	assert_int_equal(MALLOC_EVENT_RESIZE, events[1].type);
+	assert_ptr_equal(p, events[1].ptr);
+	assert_int_equal(10000, events[1].size);
+	assert_int_equal(MALLOC_EVENT_FREE, events[2].type);
+
+	assert_heap_empty();
+}
+#endif
+
+static void free_deferred_test(void** state)
+{
+	malloc_stats_t stats;
+	void* ptr[8];
+	(void)state;
+
+	for(size_t i = 0; i < 8; i++)
+	{
+		ptr[i] = malloc(32 + i * 100);
+		assert_non_null(ptr[i]);
+	}
+
+	// Nothing is released until the allocator is entered again
+	for(size_t i = 0; i < 8; i++)
+	{
+		free_deferred(ptr[i]);
+	}
+
+	free_deferred(NULL);
+
+	flush_thread_cache();
+	malloc_info(&stats);
+	assert_int_equal(8, stats.used_block_count);
+
+	// The next malloc() frees the whole batch before it allocates
+	ptr[0] = malloc(16);
+	assert_non_null(ptr[0]);
+	flush_thread_cache();
+	malloc_info(&stats);
+	assert_int_equal(1, stats.used_block_count);
+
+	// So does free(), even with a NULL pointer
+	free_deferred(ptr[0]);
+	free(NULL);
+
+	assert_heap_empty();
+}
+
+static void* free_deferred_thread(void* arg)
+{
+	void** blocks = arg;
+
+	for(size_t i = 0; i < DEFERRED_BLOCKS_PER_THREAD; i++)
+	{
+		free_deferred(blocks[i]);
+	}
+
+	return NULL;
+}
+
+static void free_deferred_threads_test(void** state)
+{
+	static void* blocks[DEFERRED_THREAD_COUNT][DEFERRED_BLOCKS_PER_THREAD];
+	pthread_t threads[DEFERRED_THREAD_COUNT];
+	(void)state;
+
+	// The main thread owns the heap, and the other threads only hand memory back to it
+	for(size_t t = 0; t < DEFERRED_THREAD_COUNT; t++)
+	{
+		for(size_t i = 0; i < DEFERRED_BLOCKS_PER_THREAD; i++)
+		{
+			blocks[t][i] = malloc(16 + ((t * DEFERRED_BLOCKS_PER_THREAD + i) % 37) * 24);
+			assert_non_null(blocks[t][i]);
+			fill(blocks[t][i], 16, (uint8_t)t);
+		}
+	}
+
+	for(size_t t = 0; t < DEFERRED_THREAD_COUNT; t++)
+	{
+		assert_int_equal(0, pthread_create(&threads[t], NULL, free_deferred_thread, blocks[t]));
+	}
+
+	for(size_t t = 0; t < DEFERRED_THREAD_COUNT; t++)
+	{
+		pthread_join(threads[t], NULL);
+	}
+
+	free_deferred_drain();
+
+	assert_heap_empty();
+}
+
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+/// Only the thread cache build is thread-safe, so the other builds skip this test
+static void* thread_cache_thread(void* arg)
+{
+	void* blocks[TCACHE_TEST_BLOCKS];
+	uint32_t random = (uint32_t)(uintptr_t)arg;
+
+	for(size_t round = 0; round < 100; round++)
+	{
+		for(size_t i = 0; i < TCACHE_TEST_BLOCKS; i++)
+		{
+			random = random * 1103515245 + 12345;
+			blocks[i] = malloc(1 + (random >> 16) % 2048);
+
+			// cmocka assertions only work on the test's thread, so report the failure instead
+			if(!blocks[i])
+			{
+				return arg;
+			}
+		}
+
+		for(size_t i = 0; i < TCACHE_TEST_BLOCKS; i++)
+		{
+			free(blocks[i]);
+		}
+	}
+
+	// The thread exits without calling malloc_thread_cache_flush()
+	return NULL;
+}
+
+static void thread_cache_exit_test(void** state)
+{
+	pthread_t threads[CACHE_THREAD_COUNT];
+	(void)state;
+
+	for(size_t t = 0; t < CACHE_THREAD_COUNT; t++)
+	{
+		assert_int_equal(0, pthread_create(&threads[t], NULL, thread_cache_thread,
+										   (void*)(uintptr_t)(t + 1)));
+	}
+
+	for(size_t t = 0; t < CACHE_THREAD_COUNT; t++)
+	{
+		void* result;
+
+		pthread_join(threads[t], &result);
+		assert_null(result);
+	}
+
+	// Every thread's cache was returned to the heap when it exited
+	assert_heap_empty();
+}
+#endif
+
+#pragma mark - Public Functions -
+
+int malloc_freelist_test_suite(void)
+{
+	const struct CMUnitTest malloc_freelist_tests[] = {
+		cmocka_unit_test(malloc_free_test),
+		cmocka_unit_test(request_size_test),
+#ifndef MALLOC_FREELIST_THREAD_CACHE
+		cmocka_unit_test(size_class_test),
+#endif
+		cmocka_unit_test(malloc_whole_pool_test),
+		cmocka_unit_test(coalesce_test),
+		cmocka_unit_test(aligned_alloc_test),
+		cmocka_unit_test(aligned_alloc_large_test),
+		cmocka_unit_test(aligned_alloc_mixed_test),
+		cmocka_unit_test(aligned_alloc_invalid_test),
+		cmocka_unit_test(realloc_null_and_zero_test),
+		cmocka_unit_test(realloc_in_place_test),
+		cmocka_unit_test(realloc_move_test),
+		cmocka_unit_test(realloc_random_test),
+		cmocka_unit_test(free_deferred_test),
+		cmocka_unit_test(free_deferred_threads_test),
+#ifdef MALLOC_FREELIST_THREAD_CACHE
+		cmocka_unit_test(thread_cache_exit_test),
+#endif
+		cmocka_unit_test(malloc_walk_test),
+		cmocka_unit_test(malloc_info_fragmentation_test),
+#ifdef MALLOC_FREELIST_EVENT_LOG
+		cmocka_unit_test(event_log_test),
+#endif
+	};
+
+	return cmocka_run_group_tests_name(TEST_GROUP_NAME, malloc_freelist_tests,
+									   malloc_freelist_group_setup, NULL);
+}
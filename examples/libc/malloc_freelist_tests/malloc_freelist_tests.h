@@ -0,0 +1,11 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef MALLOC_FREELIST_TESTS_H_
+#define MALLOC_FREELIST_TESTS_H_
+
+int malloc_freelist_test_suite(void);
+
+#endif // MALLOC_FREELIST_TESTS_H_
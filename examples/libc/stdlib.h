@@ -82,6 +82,15 @@ extern "C"
 				 int (*cmp)(void*, const void*, const void*));
 	void qsort(void* a, size_t n, size_t es, int (*compar)(const void*, const void*));
 
+	/**
+	 * qsort_r() on up to nthreads threads, including the calling thread.
+	 *
+	 * Requires POSIX threads. See stdlib/qsort_parallel.c for the algorithm.
+	 */
+	void qsort_parallel(void* base, size_t n, size_t es,
+						int (*cmp)(void*, const void*, const void*), void* thunk,
+						unsigned nthreads);
+
 #pragma mark - memory -
 
 	/**
@@ -96,6 +105,12 @@ extern "C"
 
 	void* calloc(size_t num, size_t size);
 
+	/**
+	 * Allocate memory whose address is a multiple of align, which must be a power of two.
+	 * The memory is released with free().
+	 */
+	void* aligned_alloc(size_t align, size_t size);
+
 	/**
 	 * realloc(ptr, 0) is a special case that can be handled in two ways. See:
 	 *	 http://pubs.opengroup.org/onlinepubs/9699919799/functions/realloc.html
@@ -111,6 +126,20 @@ extern "C"
 	 */
 	void* reallocf(void* ptr, size_t size);
 
+	/**
+	 * The number of bytes that can be used in the block at ptr, which may be more
+	 * than was requested. Provided by the allocator.
+	 */
+	size_t malloc_usable_size(void* ptr);
+
+	/**
+	 * Try to resize the block at ptr to size bytes without moving it.
+	 * Provided by the allocator, and used by realloc.
+	 *
+	 * @returns 0 on success, or -1 if the block can't be resized in place.
+	 */
+	int malloc_resize_in_place(void* ptr, size_t size);
+
 #ifdef __cplusplus
 }
 #endif //__cplusplus
@@ -0,0 +1,396 @@
+#ifndef __PDQSORT_H_
+#define __PDQSORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * Type-specialized sorting, for when qsort() is too slow.
+ *
+ * qsort() works on elements of any size, so it picks a way to swap them at runtime, and it
+ * calls the comparison through a function pointer. QSORT_DEFINE(name, type, less) instead
+ * defines
+ *
+ *	static inline void name(type* base, size_t n);
+ *
+ * which sorts n elements of the given type. less(a, b) is given two values of the type, is
+ * true when a sorts before b, and is inlined into the sort. For example:
+ *
+ * @code
+ * #define int_less(a, b) ((a) < (b))
+ * QSORT_DEFINE(sort_int, int, int_less)
+ *
+ * sort_int(values, count);
+ * @endcode
+ *
+ * The algorithm is pattern-defeating quicksort (Orson Peters, 2021):
+ *	- Ranges shorter than QSORT_INSERTION_THRESHOLD are insertion sorted.
+ *	- The pivot is the median of three elements, or the median of three such medians for
+ *	  ranges longer than QSORT_NINTHER_THRESHOLD.
+ *	- When the pivot of a range equals the element before it (the pivot of its parent),
+ *	  the elements equal to the pivot are put on the left and not sorted again. Input with
+ *	  many equal elements takes linear time.
+ *	- A partition that didn't swap anything may already be sorted. Each side gets an
+ *	  insertion sort that gives up after a few moves, so sorted input takes linear time.
+ *	- An unbalanced partition swaps a few elements around to break up the pattern that
+ *	  caused it. After QSORT_BAD_PARTITION_LIMIT of them, the range is sorted with
+ *	  __heapsort_r() instead, as qsort() does once it reaches its depth limit, so the worst
+ *	  case is O(n log n).
+ *
+ * Like qsort(), the sort is not stable.
+ */
+
+#ifndef QSORT_INSERTION_THRESHOLD
+#define QSORT_INSERTION_THRESHOLD 24
+#endif
+
+#ifndef QSORT_NINTHER_THRESHOLD
+#define QSORT_NINTHER_THRESHOLD 128
+#endif
+
+/// The number of element moves after which the insertion sort of an already partitioned
+/// range gives up
+#ifndef QSORT_PARTIAL_INSERTION_LIMIT
+#define QSORT_PARTIAL_INSERTION_LIMIT 8
+#endif
+
+/// The number of unbalanced partitions that are allowed for n elements
+#ifndef QSORT_BAD_PARTITION_LIMIT
+#define QSORT_BAD_PARTITION_LIMIT(n) __qsort_log2(n)
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif //__cplusplus
+
+	int __heapsort_r(void* vbase, size_t nmemb, size_t size, void* thunk,
+					 int (*compar)(void*, const void*, const void*));
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+static inline int __qsort_log2(size_t n)
+{
+	int log = 0;
+
+	while(n >>= 1)
+	{
+		log++;
+	}
+
+	return log;
+}
+
+// clang-format off
+#define QSORT_DEFINE(name, type, less)                                                          \
+	static inline void name##_swap(type* a, type* b)                                           \
+	{                                                                                          \
+		type t = *a;                                                                           \
+		*a = *b;                                                                               \
+		*b = t;                                                                                \
+	}                                                                                          \
+                                                                                               \
+	/* The comparison for __heapsort_r() */                                                    \
+	static inline int name##_compare(void* thunk, const void* a, const void* b)                \
+	{                                                                                          \
+		const type* x = (const type*)a;                                                        \
+		const type* y = (const type*)b;                                                        \
+		(void)thunk;                                                                           \
+                                                                                               \
+		return less(*x, *y) ? -1 : (less(*y, *x) ? 1 : 0);                                     \
+	}                                                                                          \
+                                                                                               \
+	/* Order *a <= *b <= *c */                                                                 \
+	static inline void name##_sort3(type* a, type* b, type* c)                                 \
+	{                                                                                          \
+		if(less(*b, *a))                                                                       \
+		{                                                                                      \
+			name##_swap(a, b);                                                                 \
+		}                                                                                      \
+                                                                                               \
+		if(less(*c, *b))                                                                       \
+		{                                                                                      \
+			name##_swap(b, c);                                                                 \
+                                                                                               \
+			if(less(*b, *a))                                                                   \
+			{                                                                                  \
+				name##_swap(a, b);                                                             \
+			}                                                                                  \
+		}                                                                                      \
+	}                                                                                          \
+                                                                                               \
+	/* When unguarded, begin[-1] is known to be <= every element in the range, so the inner */ \
+	/* loop doesn't need to check for the start of the range */                                \
+	static inline void name##_insertion(type* begin, type* end, bool unguarded)                \
+	{                                                                                          \
+		if(begin == end)                                                                       \
+		{                                                                                      \
+			return;                                                                            \
+		}                                                                                      \
+                                                                                               \
+		for(type* cur = begin + 1; cur < end; cur++)                                           \
+		{                                                                                      \
+			type* sift = cur;                                                                  \
+			type tmp;                                                                          \
+                                                                                               \
+			if(!less(*cur, cur[-1]))                                                           \
+			{                                                                                  \
+				continue;                                                                      \
+			}                                                                                  \
+                                                                                               \
+			tmp = *cur;                                                                        \
+                                                                                               \
+			do                                                                                 \
+			{                                                                                  \
+				*sift = sift[-1];                                                              \
+				sift--;                                                                        \
+			} while((unguarded || sift != begin) && less(tmp, sift[-1]));                      \
+                                                                                               \
+			*sift = tmp;                                                                       \
+		}                                                                                      \
+	}                                                                                          \
+                                                                                               \
+	/* Insertion sort, which gives up once it has moved too many elements */                  \
+	static inline bool name##_partial_insertion(type* begin, type* end)                        \
+	{                                                                                          \
+		size_t moves = 0;                                                                      \
+                                                                                               \
+		if(begin == end)                                                                       \
+		{                                                                                      \
+			return true;                                                                       \
+		}                                                                                      \
+                                                                                               \
+		for(type* cur = begin + 1; cur < end; cur++)                                           \
+		{                                                                                      \
+			type* sift = cur;                                                                  \
+			type tmp;                                                                          \
+                                                                                               \
+			if(!less(*cur, cur[-1]))                                                           \
+			{                                                                                  \
+				continue;                                                                      \
+			}                                                                                  \
+                                                                                               \
+			tmp = *cur;                                                                        \
+                                                                                               \
+			do                                                                                 \
+			{                                                                                  \
+				*sift = sift[-1];                                                              \
+				sift--;                                                                        \
+			} while(sift != begin && less(tmp, sift[-1]));                                     \
+                                                                                               \
+			*sift = tmp;                                                                       \
+			moves += (size_t)(cur - sift);                                                     \
+                                                                                               \
+			if(moves > QSORT_PARTIAL_INSERTION_LIMIT)                                          \
+			{                                                                                  \
+				return false;                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+                                                                                               \
+		return true;                                                                           \
+	}                                                                                          \
+                                                                                               \
+	/* Partition around *begin, with the elements equal to it on the right. The pivot */       \
+	/* selection leaves an element >= the pivot at the end, which stops the first scan. */     \
+	static inline type* name##_partition_right(type* begin, type* end, bool* no_swaps)         \
+	{                                                                                          \
+		type pivot = *begin;                                                                   \
+		type* first = begin;                                                                   \
+		type* last = end;                                                                      \
+                                                                                               \
+		while(less(*++first, pivot))                                                           \
+		{                                                                                      \
+		}                                                                                      \
+                                                                                               \
+		if(first - 1 == begin)                                                                 \
+		{                                                                                      \
+			while(first < last && !less(*--last, pivot))                                       \
+			{                                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+		else                                                                                   \
+		{                                                                                      \
+			/* An element < the pivot was found, which stops this scan */                      \
+			while(!less(*--last, pivot))                                                       \
+			{                                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+                                                                                               \
+		*no_swaps = first >= last;                                                             \
+                                                                                               \
+		while(first < last)                                                                    \
+		{                                                                                      \
+			name##_swap(first, last);                                                          \
+                                                                                               \
+			while(less(*++first, pivot))                                                       \
+			{                                                                                  \
+			}                                                                                  \
+                                                                                               \
+			while(!less(*--last, pivot))                                                       \
+			{                                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+                                                                                               \
+		*begin = first[-1];                                                                    \
+		first[-1] = pivot;                                                                     \
+                                                                                               \
+		return first - 1;                                                                      \
+	}                                                                                          \
+                                                                                               \
+	/* Partition around *begin, with the elements equal to it on the left */                  \
+	static inline type* name##_partition_left(type* begin, type* end)                          \
+	{                                                                                          \
+		type pivot = *begin;                                                                   \
+		type* first = begin;                                                                   \
+		type* last = end;                                                                      \
+                                                                                               \
+		while(less(pivot, *--last))                                                            \
+		{                                                                                      \
+		}                                                                                      \
+                                                                                               \
+		if(last + 1 == end)                                                                    \
+		{                                                                                      \
+			while(first < last && !less(pivot, *++first))                                      \
+			{                                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+		else                                                                                   \
+		{                                                                                      \
+			while(!less(pivot, *++first))                                                      \
+			{                                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+                                                                                               \
+		while(first < last)                                                                    \
+		{                                                                                      \
+			name##_swap(first, last);                                                          \
+                                                                                               \
+			while(less(pivot, *--last))                                                        \
+			{                                                                                  \
+			}                                                                                  \
+                                                                                               \
+			while(!less(pivot, *++first))                                                      \
+			{                                                                                  \
+			}                                                                                  \
+		}                                                                                      \
+                                                                                               \
+		*begin = *last;                                                                        \
+		*last = pivot;                                                                         \
+                                                                                               \
+		return last;                                                                           \
+	}                                                                                          \
+                                                                                               \
+	/* Swap a few elements of an unbalanced partition's sides into new positions */            \
+	static inline void name##_break_patterns(type* begin, type* pivot, type* end)              \
+	{                                                                                          \
+		size_t l_size = (size_t)(pivot - begin);                                               \
+		size_t r_size = (size_t)(end - (pivot + 1));                                           \
+                                                                                               \
+		if(l_size >= QSORT_INSERTION_THRESHOLD)                                                \
+		{                                                                                      \
+			name##_swap(begin, begin + l_size / 4);                                            \
+			name##_swap(pivot - 1, pivot - l_size / 4);                                        \
+                                                                                               \
+			if(l_size > QSORT_NINTHER_THRESHOLD)                                               \
+			{                                                                                  \
+				name##_swap(begin + 1, begin + (l_size / 4 + 1));                              \
+				name##_swap(begin + 2, begin + (l_size / 4 + 2));                              \
+				name##_swap(pivot - 2, pivot - (l_size / 4 + 1));                              \
+				name##_swap(pivot - 3, pivot - (l_size / 4 + 2));                              \
+			}                                                                                  \
+		}                                                                                      \
+                                                                                               \
+		if(r_size >= QSORT_INSERTION_THRESHOLD)                                                \
+		{                                                                                      \
+			name##_swap(pivot + 1, pivot + (1 + r_size / 4));                                  \
+			name##_swap(end - 1, end - r_size / 4);                                            \
+                                                                                               \
+			if(r_size > QSORT_NINTHER_THRESHOLD)                                               \
+			{                                                                                  \
+				name##_swap(pivot + 2, pivot + (2 + r_size / 4));                              \
+				name##_swap(pivot + 3, pivot + (3 + r_size / 4));                              \
+				name##_swap(end - 2, end - (1 + r_size / 4));                                  \
+				name##_swap(end - 3, end - (2 + r_size / 4));                                  \
+			}                                                                                  \
+		}                                                                                      \
+	}                                                                                          \
+                                                                                               \
+	/* Sort [begin, end). Unless leftmost, begin[-1] is <= every element in the range. */      \
+	static inline void name##_loop(type* begin, type* end, int bad_allowed, bool leftmost)     \
+	{                                                                                          \
+		for(;;)                                                                                \
+		{                                                                                      \
+			size_t size = (size_t)(end - begin);                                               \
+			size_t half = size / 2;                                                            \
+			type* pivot;                                                                       \
+			bool no_swaps;                                                                     \
+                                                                                               \
+			if(size < QSORT_INSERTION_THRESHOLD)                                               \
+			{                                                                                  \
+				name##_insertion(begin, end, !leftmost);                                       \
+				return;                                                                        \
+			}                                                                                  \
+                                                                                               \
+			/* Move the pivot to *begin */                                                     \
+			if(size > QSORT_NINTHER_THRESHOLD)                                                 \
+			{                                                                                  \
+				name##_sort3(begin, begin + half, end - 1);                                    \
+				name##_sort3(begin + 1, begin + (half - 1), end - 2);                          \
+				name##_sort3(begin + 2, begin + (half + 1), end - 3);                          \
+				name##_sort3(begin + (half - 1), begin + half, begin + (half + 1));            \
+				name##_swap(begin, begin + half);                                              \
+			}                                                                                  \
+			else                                                                               \
+			{                                                                                  \
+				name##_sort3(begin + half, begin, end - 1);                                    \
+			}                                                                                  \
+                                                                                               \
+			/* Everything equal to the pivot is already in place */                           \
+			if(!leftmost && !less(begin[-1], *begin))                                          \
+			{                                                                                  \
+				begin = name##_partition_left(begin, end) + 1;                                 \
+				continue;                                                                      \
+			}                                                                                  \
+                                                                                               \
+			pivot = name##_partition_right(begin, end, &no_swaps);                             \
+                                                                                               \
+			if((size_t)(pivot - begin) < size / 8 || (size_t)(end - pivot - 1) < size / 8)     \
+			{                                                                                  \
+				if(--bad_allowed <= 0)                                                         \
+				{                                                                              \
+					/* Only fails if the temporary element can't be allocated */               \
+					if(__heapsort_r(begin, size, sizeof(type), NULL, name##_compare) != 0)     \
+					{                                                                          \
+						name##_insertion(begin, end, !leftmost);                               \
+					}                                                                          \
+                                                                                               \
+					return;                                                                    \
+				}                                                                              \
+                                                                                               \
+				name##_break_patterns(begin, pivot, end);                                      \
+			}                                                                                  \
+			else if(no_swaps && name##_partial_insertion(begin, pivot) &&                      \
+					name##_partial_insertion(pivot + 1, end))                                  \
+			{                                                                                  \
+				return;                                                                        \
+			}                                                                                  \
+                                                                                               \
+			/* Recurse into the left side, and loop on the right side */                      \
+			name##_loop(begin, pivot, bad_allowed, leftmost);                                  \
+			begin = pivot + 1;                                                                 \
+			leftmost = false;                                                                  \
+		}                                                                                      \
+	}                                                                                          \
+                                                                                               \
+	static inline void name(type* base, size_t n)                                              \
+	{                                                                                          \
+		if(n > 1)                                                                              \
+		{                                                                                      \
+			name##_loop(base, base + n, QSORT_BAD_PARTITION_LIMIT(n), true);                   \
+		}                                                                                      \
+	}
+// clang-format on
+
+#endif // __PDQSORT_H_
@@ -0,0 +1,354 @@
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * qsort_r() on several threads.
+ *
+ * The array is split into one run per thread, and each run is sorted with qsort_r(), which
+ * partitions around med3 pivots. The runs are then merged in pairs, in log2(runs) rounds,
+ * between the array and a temporary buffer of the same size. Each merge is cut into pieces
+ * with the same amount of output, one per thread that isn't needed for another merge, so the
+ * last rounds keep every thread busy too. The cut points are found with a binary search for
+ * how many elements of each run come before a given output position.
+ *
+ * The work is done by nthreads - 1 threads created for the call, plus the calling thread.
+ * Each step (sorting the runs, a round of merges, copying the result back) is a list of tasks
+ * that the threads take in turn, and the next step starts once the whole list is done.
+ *
+ * Runs are at least QSORT_PARALLEL_MIN_RUN elements, so small arrays use fewer threads. If the
+ * buffer or the threads can't be allocated, the array is sorted with qsort_r() instead. Like
+ * qsort_r(), the sort is not stable.
+ *
+ * This needs POSIX threads, so it isn't part of the freestanding libc. It is only built against
+ * a host C library (see libc_stdlib_host).
+ */
+
+/// Arrays with fewer elements per thread than this use fewer threads
+#ifndef QSORT_PARALLEL_MIN_RUN
+#define QSORT_PARALLEL_MIN_RUN 4096
+#endif
+
+#ifndef QSORT_PARALLEL_MAX_THREADS
+#define QSORT_PARALLEL_MAX_THREADS 64
+#endif
+
+typedef int cmp_t(void*, const void*, const void*);
+
+typedef enum
+{
+	STEP_SORT,
+	STEP_MERGE,
+	STEP_COPY,
+	STEP_EXIT
+} step_t;
+
+typedef struct
+{
+	char* base;
+	char* tmp;
+	size_t n;
+	size_t es;
+	cmp_t* cmp;
+	void* thunk;
+	size_t threads;
+
+	/// Run i is [bounds[i], bounds[i + 1]) in src
+	size_t bounds[QSORT_PARALLEL_MAX_THREADS + 1];
+	size_t runs;
+	char* src;
+	char* dst;
+
+	/// The number of tasks that each merge of the current round is cut into
+	size_t pieces;
+
+	/// The current step. These are protected by lock.
+	step_t step;
+	size_t task_count;
+	size_t next_task;
+	size_t done_tasks;
+	unsigned generation;
+	pthread_mutex_t lock;
+	pthread_cond_t start;
+	pthread_cond_t done;
+} pool_t;
+
+#pragma mark - Merging -
+
+/// The number of elements of a that come before output position k, when a and b are merged
+static size_t merge_split(const pool_t* pool, const char* a, size_t a_len, const char* b,
+						  size_t b_len, size_t k)
+{
+	size_t es = pool->es;
+	size_t lo = (k > b_len) ? k - b_len : 0;
+	size_t hi = (k < a_len) ? k : a_len;
+
+	// Equal elements are taken from a first, so a[i] comes first unless b[k - i - 1] < a[i]
+	while(lo < hi)
+	{
+		size_t i = lo + (hi - lo) / 2;
+
+		if(pool->cmp(pool->thunk, b + (k - i - 1) * es, a + i * es) < 0)
+		{
+			hi = i;
+		}
+		else
+		{
+			lo = i + 1;
+		}
+	}
+
+	return lo;
+}
+
+static void merge(const pool_t* pool, const char* a, size_t a_len, const char* b, size_t b_len,
+				  char* out)
+{
+	size_t es = pool->es;
+	const char* a_end = a + a_len * es;
+	const char* b_end = b + b_len * es;
+
+	while(a < a_end && b < b_end)
+	{
+		if(pool->cmp(pool->thunk, b, a) < 0)
+		{
+			memcpy(out, b, es);
+			b += es;
+		}
+		else
+		{
+			memcpy(out, a, es);
+			a += es;
+		}
+
+		out += es;
+	}
+
+	memcpy(out, a, (size_t)(a_end - a));
+	out += a_end - a;
+	memcpy(out, b, (size_t)(b_end - b));
+}
+
+/// Write piece p of merge m of the current round
+static void merge_piece(const pool_t* pool, size_t m, size_t p)
+{
+	size_t es = pool->es;
+	size_t lo = pool->bounds[2 * m];
+	size_t mid = pool->bounds[(2 * m + 1 < pool->runs) ? 2 * m + 1 : pool->runs];
+	size_t hi = pool->bounds[(2 * m + 2 < pool->runs) ? 2 * m + 2 : pool->runs];
+	const char* a = pool->src + lo * es;
+	const char* b = pool->src + mid * es;
+	size_t k0 = (size_t)((uint64_t)(hi - lo) * p / pool->pieces);
+	size_t k1 = (size_t)((uint64_t)(hi - lo) * (p + 1) / pool->pieces);
+	size_t i0 = merge_split(pool, a, mid - lo, b, hi - mid, k0);
+	size_t i1 = merge_split(pool, a, mid - lo, b, hi - mid, k1);
+
+	merge(pool, a + i0 * es, i1 - i0, b + (k0 - i0) * es, (k1 - i1) - (k0 - i0),
+		  pool->dst + (lo + k0) * es);
+}
+
+#pragma mark - Thread Pool -
+
+static void run_task(const pool_t* pool, size_t task)
+{
+	size_t es = pool->es;
+
+	switch(pool->step)
+	{
+		case STEP_SORT:
+			qsort_r(pool->base + pool->bounds[task] * es,
+					pool->bounds[task + 1] - pool->bounds[task], es, pool->thunk, pool->cmp);
+			break;
+		case STEP_MERGE:
+			merge_piece(pool, task / pool->pieces, task % pool->pieces);
+			break;
+		case STEP_COPY:
+		{
+			size_t lo = (size_t)((uint64_t)pool->n * task / pool->threads);
+			size_t hi = (size_t)((uint64_t)pool->n * (task + 1) / pool->threads);
+
+			memcpy(pool->base + lo * es, pool->tmp + lo * es, (hi - lo) * es);
+			break;
+		}
+		case STEP_EXIT:
+		default:
+			break;
+	}
+}
+
+/// Run tasks of the current step until there are none left. Called with the lock held.
+static void run_tasks(pool_t* pool)
+{
+	while(pool->next_task < pool->task_count)
+	{
+		size_t task = pool->next_task++;
+
+		pthread_mutex_unlock(&pool->lock);
+		run_task(pool, task);
+		pthread_mutex_lock(&pool->lock);
+
+		if(++pool->done_tasks == pool->task_count)
+		{
+			pthread_cond_signal(&pool->done);
+		}
+	}
+}
+
+static void* worker(void* arg)
+{
+	pool_t* pool = arg;
+	unsigned seen = 0;
+
+	pthread_mutex_lock(&pool->lock);
+
+	for(;;)
+	{
+		while(pool->generation == seen)
+		{
+			pthread_cond_wait(&pool->start, &pool->lock);
+		}
+
+		seen = pool->generation;
+
+		if(pool->step == STEP_EXIT)
+		{
+			break;
+		}
+
+		run_tasks(pool);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+
+/// Start a step on the workers, help with it, and wait for it to finish
+static void run_step(pool_t* pool, step_t step, size_t task_count)
+{
+	pthread_mutex_lock(&pool->lock);
+
+	pool->step = step;
+	pool->task_count = task_count;
+	pool->next_task = 0;
+	pool->done_tasks = 0;
+	pool->generation++;
+	pthread_cond_broadcast(&pool->start);
+
+	run_tasks(pool);
+
+	while(pool->done_tasks < pool->task_count)
+	{
+		pthread_cond_wait(&pool->done, &pool->lock);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+#pragma mark - Sorting -
+
+static void sort(pool_t* pool)
+{
+	pool->runs = pool->threads;
+
+	for(size_t i = 0; i <= pool->runs; i++)
+	{
+		pool->bounds[i] = (size_t)((uint64_t)pool->n * i / pool->runs);
+	}
+
+	run_step(pool, STEP_SORT, pool->runs);
+
+	pool->src = pool->base;
+	pool->dst = pool->tmp;
+
+	while(pool->runs > 1)
+	{
+		size_t merges = (pool->runs + 1) / 2;
+		char* src = pool->src;
+
+		pool->pieces = (pool->threads > merges) ? pool->threads / merges : 1;
+		run_step(pool, STEP_MERGE, merges * pool->pieces);
+
+		for(size_t m = 0; m < merges; m++)
+		{
+			pool->bounds[m] = pool->bounds[2 * m];
+		}
+
+		pool->bounds[merges] = pool->n;
+		pool->runs = merges;
+		pool->src = pool->dst;
+		pool->dst = src;
+	}
+
+	if(pool->src != pool->base)
+	{
+		run_step(pool, STEP_COPY, pool->threads);
+	}
+}
+
+void qsort_parallel(void* base, size_t n, size_t es, cmp_t* cmp, void* thunk, unsigned nthreads)
+{
+	pthread_t workers[QSORT_PARALLEL_MAX_THREADS - 1];
+	size_t created = 0;
+	size_t threads = nthreads;
+	pool_t pool;
+
+	if(threads > n / QSORT_PARALLEL_MIN_RUN)
+	{
+		threads = n / QSORT_PARALLEL_MIN_RUN;
+	}
+
+	if(threads > QSORT_PARALLEL_MAX_THREADS)
+	{
+		threads = QSORT_PARALLEL_MAX_THREADS;
+	}
+
+	// The scratch buffer is as large as the array, which must not overflow
+	if(threads <= 1 || (es != 0 && n > SIZE_MAX / es) || (pool.tmp = malloc(n * es)) == NULL)
+	{
+		qsort_r(base, n, es, thunk, cmp);
+		return;
+	}
+
+	pool.base = base;
+	pool.n = n;
+	pool.es = es;
+	pool.cmp = cmp;
+	pool.thunk = thunk;
+	pool.threads = threads;
+	pool.generation = 0;
+	pthread_mutex_init(&pool.lock, NULL);
+	pthread_cond_init(&pool.start, NULL);
+	pthread_cond_init(&pool.done, NULL);
+
+	for(; created < threads - 1; created++)
+	{
+		if(pthread_create(&workers[created], NULL, worker, &pool) != 0)
+		{
+			break;
+		}
+	}
+
+	// With fewer threads than runs, the remaining threads take on the extra tasks
+	if(created > 0)
+	{
+		sort(&pool);
+	}
+	else
+	{
+		qsort_r(base, n, es, thunk, cmp);
+	}
+
+	run_step(&pool, STEP_EXIT, 0);
+
+	for(size_t i = 0; i < created; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&pool.done);
+	pthread_cond_destroy(&pool.start);
+	pthread_mutex_destroy(&pool.lock);
+	free(pool.tmp);
+}
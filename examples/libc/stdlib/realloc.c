@@ -12,11 +12,19 @@ void* realloc(void* ptr, size_t size)
 			return malloc(size);
 		}
 
+		// The allocator can often grow into the next block, or give back the end of this one
+		if(malloc_resize_in_place(ptr, size) == 0)
+		{
+			return ptr;
+		}
+
 		new_data = malloc(size);
 		if(new_data)
 		{
-			memcpy(new_data, ptr, size); // TODO: unsafe copy...
-			free(ptr); // we always move the data. free.
+			size_t old_size = malloc_usable_size(ptr);
+
+			memcpy(new_data, ptr, (old_size < size) ? old_size : size);
+			free(ptr); // the data has moved. free.
 		}
 	}
 
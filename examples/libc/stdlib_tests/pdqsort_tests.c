@@ -0,0 +1,247 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pdqsort.h"
+#include "stdlib_tests.h"
+
+/// This file is compiled with the libc sorting functions renamed (see libc_stdlib_host_args),
+/// so qsort() below is the libc version. It is used as the reference for QSORT_DEFINE().
+
+#define MAX_COUNT 100000
+
+typedef struct
+{
+	uint32_t key;
+	uint32_t index;
+	char payload[24];
+} record_t;
+
+#define int_less(a, b) ((a) < (b))
+#define record_less(a, b) ((a).key < (b).key)
+
+QSORT_DEFINE(sort_int, int, int_less)
+QSORT_DEFINE(sort_record, record_t, record_less)
+
+// The first unbalanced partition switches to __heapsort_r()
+#undef QSORT_BAD_PARTITION_LIMIT
+#define QSORT_BAD_PARTITION_LIMIT(n) 1
+
+QSORT_DEFINE(sort_int_heapsort, int, int_less)
+
+static int values_[MAX_COUNT];
+static int expected_[MAX_COUNT];
+static record_t records_[MAX_COUNT];
+
+typedef enum
+{
+	PATTERN_RANDOM,
+	PATTERN_SORTED,
+	PATTERN_REVERSED,
+	PATTERN_EQUAL,
+	PATTERN_FEW_UNIQUE,
+	PATTERN_ORGAN_PIPE,
+	PATTERN_SAWTOOTH,
+	PATTERN_MOSTLY_SORTED,
+	PATTERN_COUNT
+} pattern_t;
+
+#pragma mark - Helpers -
+
+static uint32_t random_state_ = 2463534242;
+
+static uint32_t next_random(void)
+{
+	// xorshift32
+	random_state_ ^= random_state_ << 13;
+	random_state_ ^= random_state_ >> 17;
+	random_state_ ^= random_state_ << 5;
+
+	return random_state_;
+}
+
+static int compare_int(const void* a, const void* b)
+{
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+
+	return (x > y) - (x < y);
+}
+
+static void fill(int* values, size_t count, pattern_t pattern)
+{
+	for(size_t i = 0; i < count; i++)
+	{
+		int x = (int)i;
+
+		switch(pattern)
+		{
+			case PATTERN_RANDOM:
+				values[i] = (int)next_random();
+				break;
+			case PATTERN_SORTED:
+				values[i] = x;
+				break;
+			case PATTERN_REVERSED:
+				values[i] = (int)count - x;
+				break;
+			case PATTERN_EQUAL:
+				values[i] = 42;
+				break;
+			case PATTERN_FEW_UNIQUE:
+				values[i] = (int)(next_random() % 4);
+				break;
+			case PATTERN_ORGAN_PIPE:
+				values[i] = (i < count / 2) ? x : (int)count - x;
+				break;
+			case PATTERN_SAWTOOTH:
+				values[i] = x % 32;
+				break;
+			case PATTERN_MOSTLY_SORTED:
+			default:
+				values[i] = (i % 100 == 0) ? (int)next_random() : x;
+				break;
+		}
+	}
+}
+
+/// Sort values_ with sort, and compare the result with qsort()
+static void check_sort(size_t count, void (*sort)(int*, size_t))
+{
+	memcpy(expected_, values_, count * sizeof(int));
+	qsort(expected_, count, sizeof(int), compare_int);
+	sort(values_, count);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		if(values_[i] != expected_[i])
+		{
+			fail_msg("%zu elements: element %zu is %d, expected %d", count, i, values_[i],
+					 expected_[i]);
+		}
+	}
+}
+
+#pragma mark - Tests -
+
+static void pdqsort_patterns_test(void** state)
+{
+	(void)state;
+
+	for(int pattern = 0; pattern < PATTERN_COUNT; pattern++)
+	{
+		for(size_t count = 0; count <= MAX_COUNT; count = count * 3 + 1)
+		{
+			fill(values_, count, (pattern_t)pattern);
+			check_sort(count, sort_int);
+		}
+	}
+}
+
+static void pdqsort_small_test(void** state)
+{
+	(void)state;
+
+	// Every size around the insertion sort and ninther thresholds
+	for(size_t count = 0; count <= 2 * QSORT_NINTHER_THRESHOLD + 1; count++)
+	{
+		for(int pattern = 0; pattern < PATTERN_COUNT; pattern++)
+		{
+			fill(values_, count, (pattern_t)pattern);
+			check_sort(count, sort_int);
+		}
+	}
+}
+
+static void pdqsort_records_test(void** state)
+{
+	(void)state;
+
+	for(uint32_t i = 0; i < MAX_COUNT; i++)
+	{
+		records_[i].key = next_random() % 1000;
+		records_[i].index = i;
+		memset(records_[i].payload, (int)(i & 0xFF), sizeof(records_[i].payload));
+	}
+
+	sort_record(records_, MAX_COUNT);
+
+	for(size_t i = 0; i < MAX_COUNT; i++)
+	{
+		// Each record was moved as a whole
+		assert_int_equal(records_[i].index & 0xFF, (uint8_t)records_[i].payload[0]);
+		assert_int_equal(records_[i].index & 0xFF,
+						 (uint8_t)records_[i].payload[sizeof(records_[i].payload) - 1]);
+
+		if(i > 0 && records_[i - 1].key > records_[i].key)
+		{
+			fail_msg("record %zu has key %u, after %u", i, records_[i].key,
+					 records_[i - 1].key);
+		}
+	}
+}
+
+static void pdqsort_heapsort_fallback_test(void** state)
+{
+	(void)state;
+
+	for(size_t count = QSORT_INSERTION_THRESHOLD; count <= 5000; count += 97)
+	{
+		size_t half = count / 2;
+
+		// The pivot candidates hold the smallest values, which makes the first partition
+		// unbalanced, and so switches to __heapsort_r()
+		for(size_t i = 0; i < count; i++)
+		{
+			values_[i] = 1000 + (int)(next_random() % 1000);
+		}
+
+		values_[0] = 0;
+		values_[half] = 1;
+		values_[count - 1] = 2;
+
+		if(count > QSORT_NINTHER_THRESHOLD)
+		{
+			values_[1] = 3;
+			values_[half - 1] = 4;
+			values_[count - 2] = 5;
+			values_[2] = 6;
+			values_[half + 1] = 7;
+			values_[count - 3] = 8;
+		}
+
+		check_sort(count, sort_int_heapsort);
+
+		for(int pattern = 0; pattern < PATTERN_COUNT; pattern++)
+		{
+			fill(values_, count, (pattern_t)pattern);
+			check_sort(count, sort_int_heapsort);
+		}
+	}
+}
+
+#pragma mark - Public Functions -
+
+int pdqsort_test_suite(void)
+{
+	const struct CMUnitTest pdqsort_tests[] = {
+		cmocka_unit_test(pdqsort_patterns_test),
+		cmocka_unit_test(pdqsort_small_test),
+		cmocka_unit_test(pdqsort_records_test),
+		cmocka_unit_test(pdqsort_heapsort_fallback_test),
+	};
+
+	return cmocka_run_group_tests_name("pdqsort", pdqsort_tests, NULL, NULL);
+}
@@ -0,0 +1,269 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "stdlib_tests.h"
+
+/// This file is compiled with the libc sorting functions renamed (see libc_stdlib_host_args),
+/// so qsort() below is the libc version. It is used as the reference for qsort_parallel().
+
+#define MAX_COUNT 300000
+#define MAX_THREADS 33
+
+/// Element sizes to test. Elements of 8 bytes or more hold their original index after the key.
+static const size_t sizes_[] = {1, 4, 8, 12, 24};
+
+#define SIZE_COUNT (sizeof(sizes_) / sizeof(sizes_[0]))
+
+static int values_[MAX_COUNT];
+static int expected_[MAX_COUNT];
+static uint8_t elements_[MAX_COUNT * 24];
+static uint8_t seen_[MAX_COUNT];
+
+#pragma mark - Helpers -
+
+static uint32_t random_state_ = 2463534242;
+
+static uint32_t next_random(void)
+{
+	// xorshift32
+	random_state_ ^= random_state_ << 13;
+	random_state_ ^= random_state_ >> 17;
+	random_state_ ^= random_state_ << 5;
+
+	return random_state_;
+}
+
+static int compare_int(const void* a, const void* b)
+{
+	int x = *(const int*)a;
+	int y = *(const int*)b;
+
+	return (x > y) - (x < y);
+}
+
+/// The thunk points to 1 for ascending order, or -1 for descending order
+static int compare_int_r(void* thunk, const void* a, const void* b)
+{
+	return *(const int*)thunk * compare_int(a, b);
+}
+
+/// The key of an element of es bytes: its first byte if es is 1, otherwise its first 4 bytes
+static uint32_t element_key(const uint8_t* element, size_t es)
+{
+	uint32_t key;
+
+	if(es == 1)
+	{
+		return element[0];
+	}
+
+	memcpy(&key, element, sizeof(key));
+
+	return key;
+}
+
+static int compare_element(void* thunk, const void* a, const void* b)
+{
+	size_t es = *(const size_t*)thunk;
+	uint32_t x = element_key(a, es);
+	uint32_t y = element_key(b, es);
+
+	return (x > y) - (x < y);
+}
+
+/// Sort values_ with qsort_parallel(), and compare the result with qsort()
+static void check_sort(size_t count, unsigned threads)
+{
+	int ascending = 1;
+
+	memcpy(expected_, values_, count * sizeof(int));
+	qsort(expected_, count, sizeof(int), compare_int);
+	qsort_parallel(values_, count, sizeof(int), compare_int_r, &ascending, threads);
+
+	for(size_t i = 0; i < count; i++)
+	{
+		if(values_[i] != expected_[i])
+		{
+			fail_msg("%zu elements, %u threads: element %zu is %d, expected %d", count, threads, i,
+					 values_[i], expected_[i]);
+		}
+	}
+}
+
+#pragma mark - Tests -
+
+static void qsort_parallel_threads_test(void** state)
+{
+	(void)state;
+
+	for(size_t count = 0; count <= MAX_COUNT; count = count * 5 + 1)
+	{
+		for(unsigned threads = 0; threads <= MAX_THREADS; threads++)
+		{
+			for(size_t i = 0; i < count; i++)
+			{
+				values_[i] = (int)next_random();
+			}
+
+			check_sort(count, threads);
+		}
+	}
+
+	// More threads than the sort uses
+	for(size_t i = 0; i < MAX_COUNT; i++)
+	{
+		values_[i] = (int)next_random();
+	}
+
+	check_sort(MAX_COUNT, 1000);
+}
+
+static void qsort_parallel_duplicates_test(void** state)
+{
+	(void)state;
+
+	for(unsigned threads = 2; threads <= MAX_THREADS; threads++)
+	{
+		// Few unique values, so that equal elements are split across runs and merge pieces
+		for(size_t i = 0; i < MAX_COUNT; i++)
+		{
+			values_[i] = (int)(next_random() % 4);
+		}
+
+		check_sort(MAX_COUNT, threads);
+
+		for(size_t i = 0; i < MAX_COUNT; i++)
+		{
+			values_[i] = 42;
+		}
+
+		check_sort(MAX_COUNT, threads);
+
+		// Already sorted, and reversed
+		for(size_t i = 0; i < MAX_COUNT; i++)
+		{
+			values_[i] = (int)i;
+		}
+
+		check_sort(MAX_COUNT, threads);
+
+		for(size_t i = 0; i < MAX_COUNT; i++)
+		{
+			values_[i] = MAX_COUNT - (int)i;
+		}
+
+		check_sort(MAX_COUNT, threads);
+	}
+}
+
+static void qsort_parallel_thunk_test(void** state)
+{
+	(void)state;
+
+	int descending = -1;
+
+	for(size_t i = 0; i < MAX_COUNT; i++)
+	{
+		values_[i] = (int)next_random();
+	}
+
+	qsort_parallel(values_, MAX_COUNT, sizeof(int), compare_int_r, &descending, 8);
+
+	for(size_t i = 1; i < MAX_COUNT; i++)
+	{
+		if(values_[i - 1] < values_[i])
+		{
+			fail_msg("element %zu is %d, after %d", i, values_[i], values_[i - 1]);
+		}
+	}
+}
+
+static void qsort_parallel_sizes_test(void** state)
+{
+	(void)state;
+
+	for(size_t s = 0; s < SIZE_COUNT; s++)
+	{
+		size_t es = sizes_[s];
+
+		for(unsigned threads = 1; threads <= MAX_THREADS; threads += 4)
+		{
+			for(uint32_t i = 0; i < MAX_COUNT; i++)
+			{
+				uint8_t* element = &elements_[i * es];
+				uint32_t key = next_random() % 1000;
+
+				if(es == 1)
+				{
+					element[0] = (uint8_t)key;
+					continue;
+				}
+
+				memcpy(element, &key, (es < sizeof(key)) ? es : sizeof(key));
+
+				if(es >= 8)
+				{
+					memcpy(element + 4, &i, sizeof(i));
+					memset(element + 8, (int)(i & 0xFF), es - 8);
+				}
+			}
+
+			qsort_parallel(elements_, MAX_COUNT, es, compare_element, &es, threads);
+			memset(seen_, 0, sizeof(seen_));
+
+			for(size_t i = 0; i < MAX_COUNT; i++)
+			{
+				const uint8_t* element = &elements_[i * es];
+
+				if(i > 0 && element_key(element - es, es) > element_key(element, es))
+				{
+					fail_msg("%zu-byte elements, %u threads: element %zu is out of order", es,
+							 threads, i);
+				}
+
+				if(es >= 8)
+				{
+					uint32_t index;
+
+					// Each element was moved as a whole, and appears once
+					memcpy(&index, element + 4, sizeof(index));
+					assert_true(index < MAX_COUNT);
+					assert_int_equal(seen_[index], 0);
+					seen_[index] = 1;
+
+					for(size_t j = 8; j < es; j++)
+					{
+						assert_int_equal(element[j], index & 0xFF);
+					}
+				}
+			}
+		}
+	}
+}
+
+#pragma mark - Public Functions -
+
+int qsort_parallel_test_suite(void)
+{
+	const struct CMUnitTest qsort_parallel_tests[] = {
+		cmocka_unit_test(qsort_parallel_threads_test),
+		cmocka_unit_test(qsort_parallel_duplicates_test),
+		cmocka_unit_test(qsort_parallel_thunk_test),
+		cmocka_unit_test(qsort_parallel_sizes_test),
+	};
+
+	return cmocka_run_group_tests_name("qsort_parallel", qsort_parallel_tests, NULL, NULL);
+}
@@ -0,0 +1,12 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef LIBC_STDLIB_TESTS_H_
+#define LIBC_STDLIB_TESTS_H_
+
+int pdqsort_test_suite(void);
+int qsort_parallel_test_suite(void);
+
+#endif // LIBC_STDLIB_TESTS_H_
@@ -13,6 +13,8 @@ extern "C"
 
 	int memcmp(const void* s1, const void* s2, size_t n);
 	void* memset(void* dest, int c, size_t n);
+	void* memset_explicit(void* dest, int c, size_t n);
+	void explicit_bzero(void* dest, size_t n);
 	void* memcpy(void* __restrict dest, const void* __restrict src, size_t n);
 	void* memmove(void* dest, const void* src, size_t n);
 	void* memchr(const void* s, int c, size_t n);
@@ -32,9 +34,13 @@ extern "C"
 	char* strndup(const char* str, size_t n);
 	char* strchr(const char* s, int c);
 	char* strrchr(const char* s, int c);
+	char* strpbrk(const char* s, const char* accept);
+	size_t strspn(const char* s, const char* accept);
+	size_t strcspn(const char* s, const char* reject);
 	char* strcat(char* __restrict dst, const char* __restrict src);
 	char* strncat(char* __restrict dst, const char* __restrict src, size_t maxlen);
 	char* strtok(char* s, const char* delim);
+	char* strtok_r(char* s, const char* delim, char** last);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,88 @@
+#ifndef __BYTESET_H_
+#define __BYTESET_H_
+
+#include <limits.h>
+#include <stddef.h>
+
+/**
+ * A set of byte values, stored as a 256-bit bitmap.
+ *
+ * strspn(), strcspn(), strpbrk(), and strtok_r() build one from their set argument, which
+ * takes O(|set|) time. Each byte of the string is then checked with a single bit test, rather
+ * than a scan of the whole set, so a call takes O(n + |set|) time.
+ */
+
+#define BYTESET_WORD_BITS (sizeof(size_t) * CHAR_BIT)
+
+typedef struct
+{
+	size_t words[256 / BYTESET_WORD_BITS];
+} byteset_t;
+
+static inline void byteset_add(byteset_t* set, unsigned char c)
+{
+	set->words[c / BYTESET_WORD_BITS] |= (size_t)1 << (c % BYTESET_WORD_BITS);
+}
+
+static inline int byteset_contains(const byteset_t* set, unsigned char c)
+{
+	return (set->words[c / BYTESET_WORD_BITS] >> (c % BYTESET_WORD_BITS)) & 1;
+}
+
+/// Initialize the set with the bytes of the string chars, not including its terminator.
+/// Delimiters are usually punctuation and whitespace, which all fall in the first word. That
+/// word is built in a local, so that each byte doesn't wait on the store of the one before.
+static inline void byteset_init(byteset_t* set, const char* chars)
+{
+	size_t first = 0;
+
+	for(size_t i = 0; i < sizeof(set->words) / sizeof(set->words[0]); i++)
+	{
+		set->words[i] = 0;
+	}
+
+	for(; *chars != '\0'; chars++)
+	{
+		unsigned char c = (unsigned char)*chars;
+
+		if(c < BYTESET_WORD_BITS)
+		{
+			first |= (size_t)1 << c;
+		}
+		else
+		{
+			byteset_add(set, c);
+		}
+	}
+
+	set->words[0] |= first;
+}
+
+/// The number of bytes at the start of s that are in the set. NUL is never in the set.
+static inline size_t byteset_span(const char* s, const byteset_t* set)
+{
+	const char* p = s;
+
+	while(byteset_contains(set, (unsigned char)*p))
+	{
+		p++;
+	}
+
+	return (size_t)(p - s);
+}
+
+/// The number of bytes at the start of s that are not in the set. The set must contain NUL,
+/// so that the loop only needs one test per byte.
+static inline size_t byteset_complement_span(const char* s, const byteset_t* set)
+{
+	const char* p = s;
+
+	while(!byteset_contains(set, (unsigned char)*p))
+	{
+		p++;
+	}
+
+	return (size_t)(p - s);
+}
+
+#endif // __BYTESET_H_
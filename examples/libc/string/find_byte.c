@@ -0,0 +1,486 @@
+#include <limits.h>
+#include <stdint.h>
+#include "find_byte.h"
+
+#if defined(__SSE2__) && !defined(FIND_BYTE_SWAR)
+#include <emmintrin.h>
+#define FIND_BYTE_SSE2
+#endif
+
+/**
+ * Byte search kernel shared by strlen(), strnlen(), strchr(), strchrnul(), strrchr(),
+ * memchr(), and memrchr(), and the candidate filter of the substring search.
+ *
+ * The input is processed in aligned blocks: 16 bytes with SSE2, or one size_t word
+ * otherwise ("SIMD within a register", SWAR). Each block produces a mask with one flag per
+ * matching byte, so the position of the first or last match comes from a single bit scan.
+ *
+ * Because blocks are aligned, the first and last block may extend past the buffer. An
+ * aligned block never crosses a page boundary, so these reads can't fault, and the bytes
+ * outside of the buffer are masked off before the result is computed. A forward search
+ * stops at the block that contains the match (or NUL), so it never reads further.
+ *
+ * Long searches check a group of four blocks per iteration, in either direction, and only
+ * look at the individual blocks once the group reports a match.
+ *
+ * __find_byte_pair() is the exception: it compares two bytes that are a needle's length
+ * apart, so its loads can't both be aligned. It uses unaligned loads within the buffer.
+ *
+ * Define FIND_BYTE_SWAR to use the word-at-a-time version on SSE2 targets.
+ */
+
+#pragma mark - Definitions -
+
+// The masked reads outside of the buffer are intended, but AddressSanitizer can't tell. Every
+// function needs the attribute, because instrumented functions aren't inlined into these.
+#if defined(__GNUC__)
+#define NO_SANITIZE __attribute__((no_sanitize_address))
+#else
+#define NO_SANITIZE
+#endif
+
+#define KERNEL static inline NO_SANITIZE
+
+#ifdef FIND_BYTE_SSE2
+
+typedef __m128i pattern_t;
+typedef unsigned int mask_t; // bit i is set if byte i matches
+
+#define BLOCK_SIZE 16
+
+#else
+
+typedef size_t pattern_t;
+typedef size_t mask_t; // the high bit of byte i is set if byte i matches
+
+#define BLOCK_SIZE sizeof(size_t)
+#define ONES ((size_t)-1 / UCHAR_MAX)
+#define HIGHS (ONES * (UCHAR_MAX / 2 + 1))
+#define LOWS (~HIGHS)
+#define WORD_BITS (sizeof(size_t) * CHAR_BIT)
+
+#endif
+
+#define GROUP_SIZE (4 * BLOCK_SIZE)
+
+#pragma mark - SSE2 Blocks -
+
+#ifdef FIND_BYTE_SSE2
+
+KERNEL pattern_t make_pattern(unsigned char c)
+{
+	return _mm_set1_epi8((char)c);
+}
+
+KERNEL __m128i load_block(const unsigned char* block)
+{
+	return _mm_load_si128((const __m128i*)block);
+}
+
+KERNEL mask_t match(const unsigned char* block, pattern_t p)
+{
+	return (mask_t)_mm_movemask_epi8(_mm_cmpeq_epi8(load_block(block), p));
+}
+
+KERNEL mask_t match_or_nul(const unsigned char* block, pattern_t p)
+{
+	__m128i x = load_block(block);
+
+	return (mask_t)_mm_movemask_epi8(
+		_mm_or_si128(_mm_cmpeq_epi8(x, p), _mm_cmpeq_epi8(x, _mm_setzero_si128())));
+}
+
+/// Bit i is set if a[i] matches pa and b[i] matches pb. Neither pointer has to be aligned.
+KERNEL mask_t match_pair(const unsigned char* a, const unsigned char* b, pattern_t pa,
+						 pattern_t pb)
+{
+	__m128i ma = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)a), pa);
+	__m128i mb = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)b), pb);
+
+	return (mask_t)_mm_movemask_epi8(_mm_and_si128(ma, mb));
+}
+
+KERNEL int match_group(const unsigned char* group, pattern_t p)
+{
+	__m128i m0 = _mm_cmpeq_epi8(load_block(group), p);
+	__m128i m1 = _mm_cmpeq_epi8(load_block(group + 16), p);
+	__m128i m2 = _mm_cmpeq_epi8(load_block(group + 32), p);
+	__m128i m3 = _mm_cmpeq_epi8(load_block(group + 48), p);
+
+	return _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(m0, m1), _mm_or_si128(m2, m3))) != 0;
+}
+
+KERNEL int match_or_nul_group(const unsigned char* group, pattern_t p)
+{
+	__m128i x0 = load_block(group);
+	__m128i x1 = load_block(group + 16);
+	__m128i x2 = load_block(group + 32);
+	__m128i x3 = load_block(group + 48);
+
+	// A byte is zero after XOR with the pattern if it matches, and min() keeps any zero.
+	// min() with the original bytes then also catches the NUL terminator.
+	__m128i m = _mm_min_epu8(_mm_min_epu8(_mm_xor_si128(x0, p), x0),
+							 _mm_min_epu8(_mm_xor_si128(x1, p), x1));
+	m = _mm_min_epu8(m, _mm_min_epu8(_mm_min_epu8(_mm_xor_si128(x2, p), x2),
+									 _mm_min_epu8(_mm_xor_si128(x3, p), x3)));
+
+	return _mm_movemask_epi8(_mm_cmpeq_epi8(m, _mm_setzero_si128())) != 0;
+}
+
+KERNEL size_t first_index(mask_t m)
+{
+	return (size_t)__builtin_ctz(m);
+}
+
+KERNEL size_t last_index(mask_t m)
+{
+	return (size_t)(31 - __builtin_clz(m));
+}
+
+/// Mask of the bytes at index i and above
+KERNEL mask_t mask_from(size_t i)
+{
+	return ~0U << i;
+}
+
+/// Mask of the bytes at index i and below
+KERNEL mask_t mask_through(size_t i)
+{
+	return (2U << i) - 1;
+}
+
+#pragma mark - SWAR Blocks -
+
+#else
+
+KERNEL pattern_t make_pattern(unsigned char c)
+{
+	return ONES * c;
+}
+
+KERNEL size_t load_block(const unsigned char* block)
+{
+	size_t w;
+
+	// Compiles to a single load, which match_pair() also uses for unaligned pointers
+	__builtin_memcpy(&w, block, sizeof(w));
+
+	return w;
+}
+
+/**
+ * Set the high bit of every zero byte of x. Unlike the cheaper (x - ONES) & ~x & HIGHS,
+ * this never flags a byte above a zero byte, so it is exact for reverse searches too.
+ */
+KERNEL mask_t zero_bytes(size_t x)
+{
+	return ~(((x & LOWS) + LOWS) | x | LOWS);
+}
+
+KERNEL mask_t match(const unsigned char* block, pattern_t p)
+{
+	return zero_bytes(load_block(block) ^ p);
+}
+
+KERNEL mask_t match_or_nul(const unsigned char* block, pattern_t p)
+{
+	size_t x = load_block(block);
+
+	return zero_bytes(x ^ p) | zero_bytes(x);
+}
+
+KERNEL mask_t match_pair(const unsigned char* a, const unsigned char* b, pattern_t pa,
+						 pattern_t pb)
+{
+	return zero_bytes((load_block(a) ^ pa) | (load_block(b) ^ pb));
+}
+
+KERNEL int match_group(const unsigned char* group, pattern_t p)
+{
+	return (match(group, p) | match(group + BLOCK_SIZE, p) | match(group + 2 * BLOCK_SIZE, p) |
+			match(group + 3 * BLOCK_SIZE, p)) != 0;
+}
+
+KERNEL int match_or_nul_group(const unsigned char* group, pattern_t p)
+{
+	return (match_or_nul(group, p) | match_or_nul(group + BLOCK_SIZE, p) |
+			match_or_nul(group + 2 * BLOCK_SIZE, p) |
+			match_or_nul(group + 3 * BLOCK_SIZE, p)) != 0;
+}
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+
+KERNEL size_t first_index(mask_t m)
+{
+	return (size_t)__builtin_clzll(m) / CHAR_BIT - (64 - WORD_BITS) / CHAR_BIT;
+}
+
+KERNEL size_t last_index(mask_t m)
+{
+	return BLOCK_SIZE - 1 - (size_t)__builtin_ctzll(m) / CHAR_BIT;
+}
+
+KERNEL mask_t mask_from(size_t i)
+{
+	return ~(size_t)0 >> (i * CHAR_BIT);
+}
+
+KERNEL mask_t mask_through(size_t i)
+{
+	return (i == BLOCK_SIZE - 1) ? ~(size_t)0 : ~(~(size_t)0 >> ((i + 1) * CHAR_BIT));
+}
+
+#else
+
+KERNEL size_t first_index(mask_t m)
+{
+	return (size_t)__builtin_ctzll(m) / CHAR_BIT;
+}
+
+KERNEL size_t last_index(mask_t m)
+{
+	return (size_t)(63 - __builtin_clzll(m)) / CHAR_BIT;
+}
+
+KERNEL mask_t mask_from(size_t i)
+{
+	return ~(size_t)0 << (i * CHAR_BIT);
+}
+
+KERNEL mask_t mask_through(size_t i)
+{
+	return (i == BLOCK_SIZE - 1) ? ~(size_t)0 : ((size_t)1 << ((i + 1) * CHAR_BIT)) - 1;
+}
+
+#endif // __BYTE_ORDER__
+
+#endif // FIND_BYTE_SSE2
+
+#pragma mark - Kernel -
+
+static inline __attribute__((always_inline)) NO_SANITIZE const unsigned char*
+find_byte_or_nul(const unsigned char* s, unsigned char c)
+{
+	pattern_t p = make_pattern(c);
+	size_t offset = (uintptr_t)s % BLOCK_SIZE;
+	const unsigned char* block = s - offset;
+	mask_t m = match_or_nul(block, p) & mask_from(offset);
+
+	if(m)
+	{
+		return block + first_index(m);
+	}
+
+	// Single blocks until the next group boundary
+	for(block += BLOCK_SIZE; (uintptr_t)block % GROUP_SIZE; block += BLOCK_SIZE)
+	{
+		m = match_or_nul(block, p);
+		if(m)
+		{
+			return block + first_index(m);
+		}
+	}
+
+	while(!match_or_nul_group(block, p))
+	{
+		block += GROUP_SIZE;
+	}
+
+	// The group has a match, so this loop ends within it
+	for(;; block += BLOCK_SIZE)
+	{
+		m = match_or_nul(block, p);
+		if(m)
+		{
+			return block + first_index(m);
+		}
+	}
+}
+
+NO_SANITIZE const unsigned char* __find_byte_or_nul(const unsigned char* s, unsigned char c)
+{
+	// strlen() gets its own copy of the loop, which only has to check for one value
+	return (c == 0) ? find_byte_or_nul(s, 0) : find_byte_or_nul(s, c);
+}
+
+NO_SANITIZE const unsigned char* __find_byte(const unsigned char* s, unsigned char c, size_t n)
+{
+	pattern_t p = make_pattern(c);
+	size_t offset = (uintptr_t)s % BLOCK_SIZE;
+	const unsigned char* block = s - offset;
+	size_t remaining;
+	size_t i;
+	mask_t m;
+
+	if(n == 0)
+	{
+		return NULL;
+	}
+
+	m = match(block, p) & mask_from(offset);
+	if(m)
+	{
+		i = first_index(m) - offset;
+		return (i < n) ? s + i : NULL;
+	}
+
+	if(n <= BLOCK_SIZE - offset)
+	{
+		return NULL;
+	}
+
+	// The number of bytes left, starting at block. Every loop below keeps this above zero, so
+	// a block is only read if it contains at least one byte of the buffer. Counting down
+	// avoids computing s + n, which can overflow for memchr(s, c, SIZE_MAX).
+	remaining = n - (BLOCK_SIZE - offset);
+	block += BLOCK_SIZE;
+
+	for(; (uintptr_t)block % GROUP_SIZE; block += BLOCK_SIZE, remaining -= BLOCK_SIZE)
+	{
+		m = match(block, p);
+		if(m)
+		{
+			i = first_index(m);
+			return (i < remaining) ? block + i : NULL;
+		}
+
+		if(remaining <= BLOCK_SIZE)
+		{
+			return NULL;
+		}
+	}
+
+	for(; remaining > GROUP_SIZE && !match_group(block, p); block += GROUP_SIZE)
+	{
+		remaining -= GROUP_SIZE;
+	}
+
+	for(;; block += BLOCK_SIZE, remaining -= BLOCK_SIZE)
+	{
+		m = match(block, p);
+		if(m)
+		{
+			i = first_index(m);
+			return (i < remaining) ? block + i : NULL;
+		}
+
+		if(remaining <= BLOCK_SIZE)
+		{
+			return NULL;
+		}
+	}
+}
+
+NO_SANITIZE const unsigned char* __find_last_byte(const unsigned char* s, unsigned char c,
+												  size_t n)
+{
+	pattern_t p = make_pattern(c);
+	const unsigned char* last;
+	const unsigned char* block;
+	size_t offset;
+	mask_t m;
+
+	if(n == 0)
+	{
+		return NULL;
+	}
+
+	last = s + n - 1;
+	offset = (uintptr_t)last % BLOCK_SIZE;
+	block = last - offset;
+	m = match(block, p) & mask_through(offset);
+
+	// Single blocks back to a group boundary. The block that contains s ends the search.
+	for(;;)
+	{
+		if((uintptr_t)block <= (uintptr_t)s)
+		{
+			m &= mask_from((uintptr_t)s - (uintptr_t)block);
+			return m ? block + last_index(m) : NULL;
+		}
+
+		if(m)
+		{
+			return block + last_index(m);
+		}
+
+		if((uintptr_t)block % GROUP_SIZE == 0)
+		{
+			break;
+		}
+
+		block -= BLOCK_SIZE;
+		m = match(block, p);
+	}
+
+	// Whole groups that lie within the buffer
+	while((uintptr_t)block - (uintptr_t)s >= GROUP_SIZE && !match_group(block - GROUP_SIZE, p))
+	{
+		block -= GROUP_SIZE;
+	}
+
+	if(block == s)
+	{
+		return NULL;
+	}
+
+	// Block > s here, so the block below it holds at least one byte of the buffer
+	for(;;)
+	{
+		block -= BLOCK_SIZE;
+		m = match(block, p);
+
+		if((uintptr_t)block <= (uintptr_t)s)
+		{
+			m &= mask_from((uintptr_t)s - (uintptr_t)block);
+			return m ? block + last_index(m) : NULL;
+		}
+
+		if(m)
+		{
+			return block + last_index(m);
+		}
+	}
+}
+
+NO_SANITIZE const unsigned char* __find_byte_pair(const unsigned char* s, size_t n,
+												  unsigned char first, unsigned char last,
+												  size_t distance)
+{
+	pattern_t pf = make_pattern(first);
+	pattern_t pl = make_pattern(last);
+	size_t i = 0;
+	mask_t m;
+
+	if(n < BLOCK_SIZE)
+	{
+		for(; i < n; i++)
+		{
+			if(s[i] == first && s[i + distance] == last)
+			{
+				return s + i;
+			}
+		}
+
+		return NULL;
+	}
+
+	for(; n - i >= BLOCK_SIZE; i += BLOCK_SIZE)
+	{
+		m = match_pair(s + i, s + i + distance, pf, pl);
+		if(m)
+		{
+			return s + i + first_index(m);
+		}
+	}
+
+	if(i == n)
+	{
+		return NULL;
+	}
+
+	// The last block overlaps positions that were already checked, and didn't match
+	m = match_pair(s + n - BLOCK_SIZE, s + n - BLOCK_SIZE + distance, pf, pl);
+
+	return m ? s + n - BLOCK_SIZE + first_index(m) : NULL;
+}
@@ -0,0 +1,30 @@
+#ifndef __FIND_BYTE_H_
+#define __FIND_BYTE_H_
+
+#include <stddef.h>
+
+/**
+ * Shared byte search kernel for the string functions (see find_byte.c).
+ *
+ * These are internal to the libc, and use the same double-underscore naming as the other
+ * helpers that are shared between functions, such as __strchrnul().
+ */
+
+/// Find the first c in the n bytes at s, or NULL (memchr)
+const unsigned char* __find_byte(const unsigned char* s, unsigned char c, size_t n);
+
+/// Find the first c or NUL in the string s (strchrnul). Use c = 0 to find the terminator.
+const unsigned char* __find_byte_or_nul(const unsigned char* s, unsigned char c);
+
+/// Find the last c in the n bytes at s, or NULL (memrchr)
+const unsigned char* __find_last_byte(const unsigned char* s, unsigned char c, size_t n);
+
+/**
+ * Find the first position i < n where s[i] == first and s[i + distance] == last, or NULL.
+ * This is the candidate filter of the substring search. All n + distance bytes at s must be
+ * readable.
+ */
+const unsigned char* __find_byte_pair(const unsigned char* s, size_t n, unsigned char first,
+									  unsigned char last, size_t distance);
+
+#endif // __FIND_BYTE_H_
@@ -0,0 +1,7 @@
+#include <string.h>
+#include "find_byte.h"
+
+void* memchr(const void* s, int c, size_t n)
+{
+	return (void*)__find_byte(s, (unsigned char)c, n);
+}
@@ -1,8 +1,49 @@
+#include <stdint.h>
 #include <string.h>
 
+/**
+ * Compare a machine word at a time. When two words differ, the first differing byte decides
+ * the result. Byte-swapping both words on a little-endian machine puts that byte in the most
+ * significant position, so a single integer comparison gives the memcmp() ordering.
+ */
+
+#if SIZE_MAX == UINT64_MAX
+typedef uint64_t word_t;
+#define word_to_be(x) __builtin_bswap64(x)
+#else
+typedef uint32_t word_t;
+#define word_to_be(x) __builtin_bswap32(x)
+#endif
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#undef word_to_be
+#define word_to_be(x) (x)
+#endif
+
+#define wsize sizeof(word_t)
+
+static inline word_t load_word(const uint8_t* p)
+{
+	word_t w;
+
+	// Compiles to a single (unaligned) load
+	__builtin_memcpy(&w, p, sizeof(w));
+
+	return w;
+}
+
+/// Order two words that are known to be different
+static inline int compare_words(word_t a, word_t b)
+{
+	return (word_to_be(a) > word_to_be(b)) ? 1 : -1;
+}
+
 int __attribute__((weak)) memcmp(const void* p1, const void* p2, size_t n)
 {
-	size_t i;
+	const uint8_t* s1 = p1;
+	const uint8_t* s2 = p2;
+	word_t a;
+	word_t b;
 
 	if(!p1)
 	{
@@ -22,13 +63,33 @@ int __attribute__((weak)) memcmp(const void* p1, const void* p2, size_t n)
 		return 0;
 	}
 
-	// This for loop does the comparing and pointer moving...
-	for(i = 0; (i < n) && (*(uint8_t*)p1 == *(uint8_t*)p2);
-		i++, p1 = 1 + (uint8_t*)p1, p2 = 1 + (uint8_t*)p2)
+	if(n < wsize)
 	{
-		// empty body
+		for(; n > 0; n--, s1++, s2++)
+		{
+			if(*s1 != *s2)
+			{
+				return *s1 - *s2;
+			}
+		}
+
+		return 0;
 	}
 
-	// if i == length, then we have passed the test
-	return (i == n) ? 0 : (*(uint8_t*)p1 - *(uint8_t*)p2);
+	for(; n > wsize; n -= wsize, s1 += wsize, s2 += wsize)
+	{
+		a = load_word(s1);
+		b = load_word(s2);
+
+		if(a != b)
+		{
+			return compare_words(a, b);
+		}
+	}
+
+	// The last word overlaps bytes that were already found to be equal
+	a = load_word(s1 + n - wsize);
+	b = load_word(s2 + n - wsize);
+
+	return (a == b) ? 0 : compare_words(a, b);
 }
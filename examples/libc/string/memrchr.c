@@ -1,19 +1,7 @@
-// Imported from musl Libc
-
 #include <string.h>
+#include "find_byte.h"
 
 void* __memrchr(const void* m, int c, size_t n)
 {
-	const unsigned char* s = m;
-	c = (unsigned char)c;
-
-	while(n--)
-	{
-		if(s[n] == c)
-		{
-			return (void*)(s + n);
-		}
-	}
-
-	return 0;
+	return (void*)__find_last_byte(m, (unsigned char)c, n);
 }
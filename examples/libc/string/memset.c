@@ -35,6 +35,59 @@ void* __attribute__((weak)) memset(void* dest, int c, size_t n)
 	s += k;
 	n -= k;
 	n &= -4;
+
+#ifdef __GNUC__
+	typedef uint32_t __attribute__((__may_alias__)) u32;
+	typedef uint64_t __attribute__((__may_alias__)) u64;
+
+	uint32_t c32 = ((uint32_t)-1) / 255 * (unsigned char)c;
+
+	/* In preparation to fill 32 bytes at a time, aligned on
+	 * an 8-byte boundary, fill head/tail up to 28 bytes each.
+	 * As in the initial byte-based head/tail fill, each
+	 * conditional below ensures that the subsequent offsets
+	 * are valid (e.g. !(n<=24) implies n>=28). */
+
+	*(u32*)(s + 0) = c32;
+	*(u32*)(s + n - 4) = c32;
+	if(n <= 8)
+		return dest;
+	*(u32*)(s + 4) = c32;
+	*(u32*)(s + 8) = c32;
+	*(u32*)(s + n - 12) = c32;
+	*(u32*)(s + n - 8) = c32;
+	if(n <= 24)
+		return dest;
+	*(u32*)(s + 12) = c32;
+	*(u32*)(s + 16) = c32;
+	*(u32*)(s + 20) = c32;
+	*(u32*)(s + 24) = c32;
+	*(u32*)(s + n - 28) = c32;
+	*(u32*)(s + n - 24) = c32;
+	*(u32*)(s + n - 20) = c32;
+	*(u32*)(s + n - 16) = c32;
+
+	/* Align to a multiple of 8 so we can fill 64 bits at a time,
+	 * and avoid writing the same bytes twice as much as is
+	 * practical without introducing additional branching. */
+
+	k = 24 + ((uintptr_t)s & 4);
+	s += k;
+	n -= k;
+
+	/* If this loop is reached, 28 tail bytes have already been
+	 * filled, so any remainder when n drops below 32 can be
+	 * safely ignored. */
+
+	uint64_t c64 = c32 | ((uint64_t)c32 << 32);
+	for(; n >= 32; n -= 32, s += 32)
+	{
+		*(u64*)(s + 0) = c64;
+		*(u64*)(s + 8) = c64;
+		*(u64*)(s + 16) = c64;
+		*(u64*)(s + 24) = c64;
+	}
+#else
 	n /= 4;
 
 	uint32_t* ws = (uint32_t*)s;
@@ -44,6 +97,7 @@ void* __attribute__((weak)) memset(void* dest, int c, size_t n)
 	/* Pure C fallback with no aliasing violations. */
 	for(; n; n--, ws++)
 		*ws = wc;
+#endif
 
 	return dest;
 }
@@ -0,0 +1,24 @@
+#include <string.h>
+
+/**
+ * memset() that is never optimized away, for clearing secrets and other buffers that are not
+ * read again. The compiler may remove a plain memset() of memory that is about to go out of
+ * scope or be freed.
+ *
+ * The empty asm statement takes the buffer address and clobbers memory, so as far as the
+ * compiler knows, it reads the filled bytes. This holds even with link-time optimization,
+ * where memset() itself could otherwise be inlined and analyzed.
+ */
+void* memset_explicit(void* dest, int c, size_t n)
+{
+	memset(dest, c, n);
+
+	__asm__ volatile("" : : "r"(dest) : "memory");
+
+	return dest;
+}
+
+void explicit_bzero(void* dest, size_t n)
+{
+	memset_explicit(dest, 0, n);
+}
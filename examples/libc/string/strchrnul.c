@@ -1,38 +1,7 @@
-// Imported from musl Libc
-
-#include <limits.h>
-#include <stdint.h>
 #include <string.h>
-
-#define ALIGN (sizeof(size_t))
-#define ONES ((size_t)-1 / UCHAR_MAX)
-#define HIGHS (ONES * (UCHAR_MAX / 2 + 1))
-#define HASZERO(x) (((x) - (ONES)) & (~(x)&HIGHS))
+#include "find_byte.h"
 
 char* __strchrnul(const char* s, int c)
 {
-	size_t *w, k;
-	c = (unsigned char)c;
-
-	if(!c)
-	{
-		return (char*)s + strlen(s);
-	}
-
-	for(; (uintptr_t)s % ALIGN; s++)
-	{
-		if(!*s || *(unsigned char*)s == c)
-		{
-			return (char*)s;
-		}
-	}
-
-	k = ONES * c;
-
-	for(w = (void*)s; !HASZERO(*w) && !HASZERO(*w ^ k); w++)
-		;
-	for(s = (void*)w; *s && *(unsigned char*)s != c; s++)
-		;
-
-	return (char*)s;
+	return (char*)__find_byte_or_nul((const unsigned char*)s, (unsigned char)c);
 }
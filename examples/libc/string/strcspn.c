@@ -0,0 +1,20 @@
+#include <string.h>
+#include "byteset.h"
+
+char* __strchrnul(const char*, int);
+
+size_t strcspn(const char* s, const char* reject)
+{
+	byteset_t set;
+
+	// Up to one byte is a plain byte search, which the find_byte kernel does a block at a time
+	if(reject[0] == '\0' || reject[1] == '\0')
+	{
+		return (size_t)(__strchrnul(s, reject[0]) - s);
+	}
+
+	byteset_init(&set, reject);
+	byteset_add(&set, '\0');
+
+	return byteset_complement_span(s, &set);
+}
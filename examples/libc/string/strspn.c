@@ -0,0 +1,27 @@
+#include <string.h>
+#include "byteset.h"
+
+size_t strspn(const char* s, const char* accept)
+{
+	const char* p = s;
+	byteset_t set;
+
+	if(accept[0] == '\0')
+	{
+		return 0;
+	}
+
+	// A single byte doesn't need the set
+	if(accept[1] == '\0')
+	{
+		for(; *p == accept[0]; p++)
+		{
+		}
+
+		return (size_t)(p - s);
+	}
+
+	byteset_init(&set, accept);
+
+	return byteset_span(s, &set);
+}
@@ -37,64 +37,54 @@
 	#include <stdio.h>
 #endif
 #include <string.h>
+#include "byteset.h"
 
-char* __strtok_r(char*, const char*, char**);
-
-char* __strtok_r(char* s, const char* delim, char** last)
+char* strtok_r(char* s, const char* delim, char** last)
 {
-	char *spanp, *tok;
-	int c, sc;
+	char* tok;
+	byteset_t set;
 
 	if(s == NULL && (s = *last) == NULL)
-		return (NULL);
-
-/*
- * Skip (span) leading delimiters (s += strspn(s, delim), sort of).
- */
-cont:
-	c = *s++;
-	for(spanp = (char*)delim; (sc = *spanp++) != 0;)
 	{
-		if(c == sc)
-			goto cont;
+		return NULL;
 	}
 
-	if(c == 0)
+	// The delimiter set is built once per call, so both scans below take one bit test per byte
+	byteset_init(&set, delim);
+
+	// Skip leading delimiters (s += strspn(s, delim))
+	s += byteset_span(s, &set);
+
+	if(*s == '\0')
 	{ /* no non-delimiter characters */
 		*last = NULL;
-		return (NULL);
+		return NULL;
 	}
-	tok = s - 1;
 
-	/*
-	 * Scan token (scan for delimiters: s += strcspn(s, delim), sort of).
-	 * Note that delim must have one NUL; we stop if we see that, too.
-	 */
-	for(;;)
+	tok = s;
+
+	// Scan the token (s += strcspn(s, delim)), which also stops at the terminator
+	byteset_add(&set, '\0');
+	s += byteset_complement_span(s, &set);
+
+	if(*s == '\0')
+	{
+		*last = NULL;
+	}
+	else
 	{
-		c = *s++;
-		spanp = (char*)delim;
-		do
-		{
-			if((sc = *spanp++) == c)
-			{
-				if(c == 0)
-					s = NULL;
-				else
-					s[-1] = '\0';
-				*last = s;
-				return (tok);
-			}
-		} while(sc != 0);
+		*s = '\0';
+		*last = s + 1;
 	}
-	/* NOTREACHED */
+
+	return tok;
 }
 
 char* strtok(char* s, const char* delim)
 {
 	static char* last;
 
-	return (__strtok_r(s, delim, &last));
+	return strtok_r(s, delim, &last);
 }
 
 #ifdef DEBUG_STRTOK
@@ -0,0 +1,282 @@
+#include <stdint.h>
+#include <string.h>
+#include "find_byte.h"
+#include "substring.h"
+
+/**
+ * Substring search shared by strstr(), strnstr(), and memmem().
+ *
+ * Candidate positions come from __find_byte_pair(), which checks a block of positions at a
+ * time for the needle's first and last bytes, and each candidate is then compared with
+ * memcmp(). For ordinary text, few positions pass the filter. Adversarial input, such as
+ * "aaa...a" searched for "aa...ab", makes every position a candidate, though, which would take
+ * O(n * m) time.
+ *
+ * So the bytes compared for candidates that didn't match are counted. Once they exceed the
+ * distance covered (plus SUBSTRING_FILTER_SLACK), the rest of the haystack is searched with
+ * the Two-Way algorithm (Crochemore and Perrin, 1991). Two-Way factors the needle in O(m)
+ * time and then compares each haystack byte at most twice, using constant memory. The
+ * factorization follows musl's twoway_strstr(), without its shift table.
+ *
+ * A NUL-terminated haystack is searched in windows of at least SUBSTRING_WINDOW_SIZE bytes,
+ * and its end is found as the search goes, so strstr() doesn't scan all of a long string to
+ * find a match near its start.
+ */
+
+#pragma mark - Definitions -
+
+#ifndef SUBSTRING_FILTER_SLACK
+/// Bytes of failed candidate comparisons that are allowed before switching to Two-Way
+#define SUBSTRING_FILTER_SLACK 256
+#endif
+
+#ifndef SUBSTRING_WINDOW_SIZE
+/// The minimum amount of a NUL-terminated haystack that is checked for its end at a time
+#define SUBSTRING_WINDOW_SIZE 4096
+#endif
+
+#define MAX(a, b) (((a) > (b)) ? (a) : (b))
+
+typedef struct
+{
+	const unsigned char* needle;
+	size_t length;
+
+	/// Where the search started, and the bytes compared for failed candidates since then
+	const unsigned char* start;
+	size_t wasted;
+
+	/// Set once the filter has given up. The fields below are only valid then.
+	int two_way;
+
+	/// The left half of the needle is [0, split], so split is (size_t)-1 if it's empty
+	size_t split;
+	size_t period;
+
+	/// How much of the needle is known to match after a shift by the period
+	size_t memory;
+} search_t;
+
+#pragma mark - Two-Way -
+
+/**
+ * Find the maximal suffix of the needle, in byte order or (if reverse is set) in reverse
+ * byte order. Returns the start of the suffix minus one, and its period in *period.
+ */
+static size_t maximal_suffix(const unsigned char* n, size_t l, int reverse, size_t* period)
+{
+	size_t ip = (size_t)-1;
+	size_t jp = 0;
+	size_t k = 1;
+	size_t p = 1;
+
+	while(jp + k < l)
+	{
+		unsigned char a = n[ip + k];
+		unsigned char b = n[jp + k];
+
+		if(a == b)
+		{
+			if(k == p)
+			{
+				jp += p;
+				k = 1;
+			}
+			else
+			{
+				k++;
+			}
+		}
+		else if((a > b) != reverse)
+		{
+			jp += k;
+			k = 1;
+			p = jp - ip;
+		}
+		else
+		{
+			ip = jp++;
+			k = p = 1;
+		}
+	}
+
+	*period = p;
+
+	return ip;
+}
+
+/// Compute the critical factorization of the needle
+static void factor_needle(search_t* st)
+{
+	const unsigned char* n = st->needle;
+	size_t l = st->length;
+	size_t p0;
+	size_t p1;
+	size_t ms0 = maximal_suffix(n, l, 0, &p0);
+	size_t ms1 = maximal_suffix(n, l, 1, &p1);
+
+	// The longer of the two left halves gives a critical factorization
+	if(ms1 + 1 > ms0 + 1)
+	{
+		st->split = ms1;
+		st->period = p1;
+	}
+	else
+	{
+		st->split = ms0;
+		st->period = p0;
+	}
+
+	if(memcmp(n, n + st->period, st->split + 1) == 0)
+	{
+		// The needle is periodic: after a shift by the period, everything but the last
+		// period is known to match
+		st->memory = l - st->period;
+	}
+	else
+	{
+		st->period = MAX(st->split, l - st->split - 1) + 1;
+		st->memory = 0;
+	}
+
+	st->two_way = 1;
+}
+
+/// Find the first match that starts before end - length
+static const unsigned char* two_way(const unsigned char* h, const unsigned char* end,
+									const search_t* st)
+{
+	const unsigned char* n = st->needle;
+	size_t l = st->length;
+	size_t ms = st->split;
+	size_t mem = 0;
+	size_t k;
+
+	while((size_t)(end - h) >= l)
+	{
+		// The right half, left to right
+		for(k = MAX(ms + 1, mem); k < l && n[k] == h[k]; k++)
+		{
+		}
+
+		if(k < l)
+		{
+			h += k - ms;
+			mem = 0;
+			continue;
+		}
+
+		// Then the left half, right to left, down to the part that is known to match
+		for(k = ms + 1; k > mem && n[k - 1] == h[k - 1]; k--)
+		{
+		}
+
+		if(k <= mem)
+		{
+			return h;
+		}
+
+		h += st->period;
+		mem = st->memory;
+	}
+
+	return NULL;
+}
+
+#pragma mark - Search -
+
+/// Find the first match in [h, end), which is known to be part of the haystack
+static const unsigned char* search_window(const unsigned char* h, const unsigned char* end,
+										  search_t* st)
+{
+	const unsigned char* n = st->needle;
+	size_t l = st->length;
+	const unsigned char* candidate;
+
+	if((size_t)(end - h) < l)
+	{
+		return NULL;
+	}
+
+	if(l == 1)
+	{
+		return __find_byte(h, n[0], (size_t)(end - h));
+	}
+
+	while(!st->two_way)
+	{
+		candidate = __find_byte_pair(h, (size_t)(end - h) - l + 1, n[0], n[l - 1], l - 1);
+		if(candidate == NULL)
+		{
+			return NULL;
+		}
+
+		if(memcmp(candidate + 1, n + 1, l - 2) == 0)
+		{
+			return candidate;
+		}
+
+		h = candidate + 1;
+		st->wasted += l;
+
+		if(st->wasted > (size_t)(h - st->start) + SUBSTRING_FILTER_SLACK)
+		{
+			factor_needle(st);
+		}
+		else if((size_t)(end - h) < l)
+		{
+			return NULL;
+		}
+	}
+
+	return two_way(h, end, st);
+}
+
+const unsigned char* __find_substring(const unsigned char* h, size_t h_len,
+									  const unsigned char* n, size_t n_len, int terminated)
+{
+	search_t st = {.needle = n, .length = n_len, .start = h, .wasted = 0, .two_way = 0};
+	const unsigned char* match;
+	const unsigned char* nul;
+	size_t known;
+	size_t pos = 0;
+	size_t grow;
+
+	if(n_len == 0)
+	{
+		return h;
+	}
+
+	if(!terminated)
+	{
+		return search_window(h, h + h_len, &st);
+	}
+
+	// Bytes [0, known) are part of the haystack
+	for(known = 0;;)
+	{
+		// Every window holds at least one more needle length of candidates, so restarting
+		// Two-Way at each window doesn't add more than one comparison per haystack byte
+		grow = MAX(SUBSTRING_WINDOW_SIZE, 2 * n_len);
+		grow = (grow < h_len - known) ? grow : h_len - known;
+
+		nul = __find_byte(h + known, 0, grow);
+		if(nul)
+		{
+			h_len = (size_t)(nul - h);
+		}
+
+		known = nul ? h_len : known + grow;
+
+		match = search_window(h + pos, h + known, &st);
+		if(match || known == h_len)
+		{
+			return match;
+		}
+
+		if(known - pos >= n_len)
+		{
+			pos = known - n_len + 1;
+		}
+	}
+}
@@ -0,0 +1,16 @@
+#ifndef __SUBSTRING_H_
+#define __SUBSTRING_H_
+
+#include <stddef.h>
+
+/**
+ * Shared substring search for strstr(), strnstr(), and memmem() (see substring.c).
+ *
+ * Find the first occurrence of the n_len bytes at n in the h_len bytes at h, or NULL. If
+ * terminated is nonzero, the haystack also ends at its first NUL, and h_len may be SIZE_MAX.
+ * An empty needle matches at h.
+ */
+const unsigned char* __find_substring(const unsigned char* h, size_t h_len,
+									  const unsigned char* n, size_t n_len, int terminated);
+
+#endif // __SUBSTRING_H_
@@ -0,0 +1,317 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "string_tests.h"
+
+/// This file is compiled with the libc string functions renamed (see libc_string_host_args),
+/// so strlen(), strchr(), memchr(), etc. below are the libc versions.
+///
+/// These functions share the byte search kernel in find_byte.c, which reads whole aligned
+/// blocks. The tests cover every alignment within a group of blocks, a match at every
+/// position, and buffers that end right before an inaccessible page.
+
+// Internal libc functions, which the host's string.h doesn't declare
+void* __memrchr(const void* m, int c, size_t n);
+char* __strchrnul(const char* s, int c);
+
+#define MAX_LENGTH 300
+#define MAX_OFFSET 64
+#define BUFFER_SIZE (MAX_LENGTH + MAX_OFFSET + 64)
+
+/// The byte that is searched for. Its neighbors and the same value without the high bit
+/// are placed around it, to catch word-at-a-time tricks that flag the wrong byte.
+#define TARGET 0xC1
+
+static unsigned char buf_[BUFFER_SIZE];
+
+#pragma mark - Helpers -
+
+/// Fill the buffer with nonzero bytes that never equal TARGET, including TARGET ^ 1,
+/// TARGET ^ 0x80, and bytes with the high bit set. The two bytes before offset are TARGET and
+/// NUL, which a search starting at offset must not find.
+static void fill_background(size_t offset)
+{
+	for(size_t i = 0; i < BUFFER_SIZE; i++)
+	{
+		unsigned char b = (unsigned char)(i * 37 + 11);
+
+		if(i % 3 == 0)
+		{
+			b = TARGET ^ 1;
+		}
+		else if(i % 5 == 0)
+		{
+			b = TARGET ^ 0x80;
+		}
+
+		buf_[i] = (b == 0 || b == TARGET) ? 0x01 : b;
+	}
+
+	if(offset >= 1)
+	{
+		buf_[offset - 1] = TARGET;
+	}
+
+	if(offset >= 2)
+	{
+		buf_[offset - 2] = '\0';
+	}
+}
+
+/// Map a page with inaccessible pages on both sides. Returns the start of the accessible page.
+static unsigned char* map_guarded_page(size_t page_size)
+{
+	unsigned char* pages = mmap(NULL, 3 * page_size, PROT_READ | PROT_WRITE,
+								MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	assert_true(pages != MAP_FAILED);
+	assert_int_equal(0, mprotect(pages, page_size, PROT_NONE));
+	assert_int_equal(0, mprotect(pages + 2 * page_size, page_size, PROT_NONE));
+
+	return pages + page_size;
+}
+
+#pragma mark - Tests -
+
+static void strlen_test(void** state)
+{
+	(void)state;
+
+	for(size_t offset = 0; offset < MAX_OFFSET; offset++)
+	{
+		char* s = (char*)buf_ + offset;
+
+		fill_background(offset);
+
+		for(size_t length = 0; length <= MAX_LENGTH; length++)
+		{
+			unsigned char saved = buf_[offset + length];
+
+			buf_[offset + length] = '\0';
+
+			if(strlen(s) != length)
+			{
+				fail_msg("offset %zu, length %zu: strlen() returned %zu", offset, length,
+						 strlen(s));
+			}
+
+			assert_int_equal(length, strnlen(s, SIZE_MAX));
+			assert_int_equal(length, strnlen(s, length + 1));
+			assert_int_equal(length, strnlen(s, length));
+			assert_int_equal(length / 2, strnlen(s, length / 2));
+
+			buf_[offset + length] = saved;
+		}
+	}
+
+	assert_int_equal(0, strnlen((char*)buf_, 0));
+}
+
+static void strchr_test(void** state)
+{
+	(void)state;
+
+	for(size_t offset = 0; offset < MAX_OFFSET; offset++)
+	{
+		char* s = (char*)buf_ + offset;
+
+		fill_background(offset);
+
+		for(size_t length = 0; length <= MAX_LENGTH; length += (length < 80) ? 1 : 7)
+		{
+			buf_[offset + length] = '\0';
+
+			assert_null(strchr(s, TARGET));
+			assert_null(strrchr(s, TARGET));
+			assert_ptr_equal(s + length, strchr(s, '\0'));
+			assert_ptr_equal(s + length, strrchr(s, '\0'));
+			assert_ptr_equal(s + length, __strchrnul(s, TARGET));
+
+			for(size_t pos = 0; pos < length; pos++)
+			{
+				buf_[offset + pos] = TARGET;
+
+				if(strchr(s, TARGET) != s + pos)
+				{
+					fail_msg("offset %zu, length %zu: strchr() missed %zu", offset, length, pos);
+				}
+
+				// The character is converted to unsigned char
+				assert_ptr_equal(s + pos, strchr(s, (int)TARGET - 256));
+				assert_ptr_equal(s + pos, strrchr(s, TARGET));
+				assert_ptr_equal(s + pos, __strchrnul(s, TARGET));
+
+				// A second occurrence at the start changes strchr(), but not strrchr()
+				if(pos > 0)
+				{
+					unsigned char saved = buf_[offset];
+
+					buf_[offset] = TARGET;
+					assert_ptr_equal(s, strchr(s, TARGET));
+					assert_ptr_equal(s + pos, strrchr(s, TARGET));
+					buf_[offset] = saved;
+				}
+
+				fill_background(offset);
+				buf_[offset + length] = '\0';
+			}
+
+			fill_background(offset);
+		}
+	}
+}
+
+static void memchr_test(void** state)
+{
+	(void)state;
+
+	for(size_t offset = 0; offset < MAX_OFFSET; offset++)
+	{
+		unsigned char* s = buf_ + offset;
+
+		fill_background(offset);
+
+		for(size_t length = 0; length <= MAX_LENGTH; length += (length < 80) ? 1 : 7)
+		{
+			// NUL bytes don't end the search
+			buf_[offset + length / 2] = '\0';
+
+			assert_null(memchr(s, TARGET, length));
+			assert_null(__memrchr(s, TARGET, length));
+
+			// Matches right outside of the buffer must not be found
+			buf_[offset + length] = TARGET;
+
+			assert_null(memchr(s, TARGET, length));
+			assert_null(__memrchr(s, TARGET, length));
+
+			for(size_t pos = 0; pos < length; pos++)
+			{
+				unsigned char saved = s[pos];
+
+				s[pos] = TARGET;
+
+				if(memchr(s, TARGET, length) != s + pos)
+				{
+					fail_msg("offset %zu, length %zu: memchr() missed %zu", offset, length, pos);
+				}
+
+				if(__memrchr(s, TARGET, length) != s + pos)
+				{
+					fail_msg("offset %zu, length %zu: memrchr() missed %zu", offset, length, pos);
+				}
+
+				assert_ptr_equal(s + pos, memchr(s, (int)TARGET + 256, length));
+				assert_null(memchr(s, TARGET, pos));
+				assert_null(__memrchr(s + pos + 1, TARGET, length - pos - 1));
+
+				s[pos] = saved;
+			}
+
+			fill_background(offset);
+		}
+	}
+}
+
+static void memchr_unbounded_test(void** state)
+{
+	(void)state;
+
+	fill_background(0);
+
+	// The length can't be used to compute the end of the buffer, as that overflows
+	for(size_t offset = 0; offset < MAX_OFFSET; offset++)
+	{
+		for(size_t pos = offset; pos < offset + 200; pos++)
+		{
+			buf_[pos] = TARGET;
+			assert_ptr_equal(buf_ + pos, memchr(buf_ + offset, TARGET, SIZE_MAX));
+			assert_ptr_equal(buf_ + pos, memchr(buf_ + offset, TARGET, SIZE_MAX - offset));
+			buf_[pos] = (unsigned char)(TARGET ^ 1);
+		}
+	}
+}
+
+static void page_boundary_test(void** state)
+{
+	size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+	unsigned char* page = map_guarded_page(page_size);
+	unsigned char* end = page + page_size;
+	(void)state;
+
+	memset(page, TARGET ^ 1, page_size);
+
+	// Every length of buffer that ends at the inaccessible page, with and without a match
+	for(size_t length = 1; length <= MAX_LENGTH; length++)
+	{
+		unsigned char* s = end - length;
+
+		end[-1] = '\0';
+		assert_int_equal(length - 1, strlen((char*)s));
+		assert_int_equal(length - 1, strnlen((char*)s, SIZE_MAX));
+		assert_null(strchr((char*)s, TARGET));
+		assert_null(strrchr((char*)s, TARGET));
+		assert_ptr_equal(end - 1, strchr((char*)s, '\0'));
+
+		end[-1] = TARGET ^ 1;
+		assert_int_equal(length, strnlen((char*)s, length));
+		assert_null(memchr(s, TARGET, length));
+		assert_null(__memrchr(s, TARGET, length));
+
+		end[-1] = TARGET;
+		assert_ptr_equal(end - 1, memchr(s, TARGET, length));
+		assert_ptr_equal(end - 1, __memrchr(s, TARGET, length));
+
+		s[0] = TARGET;
+		assert_ptr_equal(s, memchr(s, TARGET, length));
+		assert_ptr_equal(end - 1, __memrchr(s, TARGET, length));
+		s[0] = TARGET ^ 1;
+
+		end[-1] = TARGET ^ 1;
+	}
+
+	// Reverse searches that reach the start of the page
+	for(size_t length = 1; length <= MAX_LENGTH; length++)
+	{
+		assert_null(__memrchr(page, TARGET, length));
+
+		page[0] = TARGET;
+		assert_ptr_equal(page, __memrchr(page, TARGET, length));
+		page[0] = TARGET ^ 1;
+	}
+
+	assert_int_equal(0, munmap(page - page_size, 3 * page_size));
+}
+
+#pragma mark - Public Functions -
+
+int find_byte_test_suite(void)
+{
+	const struct CMUnitTest find_byte_tests[] = {
+		cmocka_unit_test(strlen_test),
+		cmocka_unit_test(strchr_test),
+		cmocka_unit_test(memchr_test),
+		cmocka_unit_test(memchr_unbounded_test),
+		cmocka_unit_test(page_boundary_test),
+	};
+
+	return cmocka_run_group_tests_name("find_byte", find_byte_tests, NULL, NULL);
+}
@@ -0,0 +1,204 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "string_tests.h"
+
+/// This file is compiled with the libc string functions renamed (see libc_string_host_args),
+/// so memcmp() below is the libc version.
+
+/// Every alignment of both buffers is tested against every mismatch position up to this length
+#define FULL_SWEEP_LENGTH 80
+#define MAX_LENGTH 300
+#define MAX_OFFSET 16
+#define BUFFER_SIZE (MAX_LENGTH + MAX_OFFSET + 16)
+
+static uint8_t a_buf_[BUFFER_SIZE];
+static uint8_t b_buf_[BUFFER_SIZE];
+
+#pragma mark - Helpers -
+
+static int sign(int value)
+{
+	return (value > 0) - (value < 0);
+}
+
+/// Fill both buffers with the same data, including bytes with the high bit set
+static void fill_equal(void)
+{
+	for(size_t i = 0; i < BUFFER_SIZE; i++)
+	{
+		a_buf_[i] = (uint8_t)(i * 37 + 11);
+		b_buf_[i] = a_buf_[i];
+	}
+}
+
+/// Introduce a difference at pos, and check that it decides the result in both directions.
+/// A later difference in the opposite direction must not change the result.
+static void check_mismatch(size_t a_offset, size_t b_offset, size_t length, size_t pos)
+{
+	uint8_t* a = a_buf_ + a_offset;
+	uint8_t* b = b_buf_ + b_offset;
+	uint8_t saved_a = a[pos];
+	uint8_t saved_b = b[pos];
+	uint8_t saved_later = b[length - 1];
+
+	// 0x80 vs 0x7F checks that bytes are compared as unsigned
+	a[pos] = 0x80;
+	b[pos] = 0x7F;
+
+	if(pos + 1 < length)
+	{
+		b[length - 1] = (uint8_t)(a[length - 1] + 1);
+	}
+
+	if(sign(memcmp(a, b, length)) != 1 || sign(memcmp(b, a, length)) != -1)
+	{
+		fail_msg("length %zu, offsets %zu/%zu: mismatch at %zu not detected", length, a_offset,
+				 b_offset, pos);
+	}
+
+	// The bytes before the mismatch are equal
+	assert_int_equal(0, memcmp(a, b, pos));
+
+	a[pos] = saved_a;
+	b[pos] = saved_b;
+	b[length - 1] = saved_later;
+}
+
+#pragma mark - Tests -
+
+static void memcmp_equal_test(void** state)
+{
+	(void)state;
+
+	fill_equal();
+
+	for(size_t length = 0; length <= MAX_LENGTH; length++)
+	{
+		for(size_t offset = 0; offset < MAX_OFFSET; offset++)
+		{
+			// The same data at different offsets is in different buffers
+			for(size_t i = 0; i < length; i++)
+			{
+				b_buf_[offset + i] = a_buf_[i];
+			}
+
+			assert_int_equal(0, memcmp(a_buf_, b_buf_ + offset, length));
+		}
+
+		fill_equal();
+	}
+
+	assert_int_equal(0, memcmp(a_buf_, a_buf_, MAX_LENGTH));
+}
+
+static void memcmp_every_alignment_test(void** state)
+{
+	(void)state;
+
+	fill_equal();
+
+	for(size_t length = 1; length <= FULL_SWEEP_LENGTH; length++)
+	{
+		for(size_t a_offset = 0; a_offset < MAX_OFFSET; a_offset++)
+		{
+			for(size_t b_offset = 0; b_offset < MAX_OFFSET; b_offset++)
+			{
+				// Both buffers have to hold the same data before the mismatch
+				for(size_t i = 0; i < length; i++)
+				{
+					b_buf_[b_offset + i] = a_buf_[a_offset + i];
+				}
+
+				for(size_t pos = 0; pos < length; pos++)
+				{
+					check_mismatch(a_offset, b_offset, length, pos);
+				}
+			}
+		}
+	}
+}
+
+static void memcmp_long_buffer_test(void** state)
+{
+	static const size_t offsets[] = {0, 1, 7, 8, 15};
+	const size_t offset_count = sizeof(offsets) / sizeof(offsets[0]);
+	(void)state;
+
+	fill_equal();
+
+	for(size_t length = FULL_SWEEP_LENGTH; length <= MAX_LENGTH; length++)
+	{
+		for(size_t i = 0; i < offset_count; i++)
+		{
+			for(size_t j = 0; j < offset_count; j++)
+			{
+				for(size_t k = 0; k < length; k++)
+				{
+					b_buf_[offsets[j] + k] = a_buf_[offsets[i] + k];
+				}
+
+				for(size_t pos = 0; pos < length; pos++)
+				{
+					check_mismatch(offsets[i], offsets[j], length, pos);
+				}
+			}
+		}
+	}
+}
+
+static void memcmp_no_overread_test(void** state)
+{
+	(void)state;
+
+	// Exact-size heap buffers, so that a read past the end is caught by a sanitizer
+	for(size_t length = 1; length <= 200; length++)
+	{
+		uint8_t* a = malloc(length);
+		uint8_t* b = malloc(length);
+
+		assert_non_null(a);
+		assert_non_null(b);
+
+		for(size_t i = 0; i < length; i++)
+		{
+			a[i] = (uint8_t)i;
+			b[i] = (uint8_t)i;
+		}
+
+		assert_int_equal(0, memcmp(a, b, length));
+
+		b[length - 1] = 0xFF;
+		assert_int_equal(-1, sign(memcmp(a, b, length)));
+
+		free(a);
+		free(b);
+	}
+}
+
+#pragma mark - Public Functions -
+
+int memcmp_test_suite(void)
+{
+	const struct CMUnitTest memcmp_tests[] = {
+		cmocka_unit_test(memcmp_equal_test),
+		cmocka_unit_test(memcmp_every_alignment_test),
+		cmocka_unit_test(memcmp_long_buffer_test),
+		cmocka_unit_test(memcmp_no_overread_test),
+	};
+
+	return cmocka_run_group_tests_name("memcmp", memcmp_tests, NULL, NULL);
+}
@@ -0,0 +1,197 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <string.h>
+#include "string_tests.h"
+
+/// This file is compiled with the libc string functions renamed (see libc_string_host_args),
+/// so memcpy() and memmove() below are the libc versions. The helpers use plain loops so that
+/// they don't depend on the functions under test.
+
+/// Larger than MEMCPY_NONTEMPORAL_THRESHOLD, so that the streaming path is covered
+#define LARGE_SIZE (2 * 1024 * 1024 + 77)
+#define GUARD 64
+#define BUFFER_SIZE (LARGE_SIZE + 4 * GUARD)
+#define GUARD_BYTE 0xA5
+
+static uint8_t src_buf_[BUFFER_SIZE];
+static uint8_t dst_buf_[BUFFER_SIZE];
+
+#pragma mark - Helpers -
+
+static uint8_t pattern(size_t i)
+{
+	return (uint8_t)((i * 7) ^ (i >> 8));
+}
+
+static void fill_pattern(uint8_t* buf, size_t size)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		buf[i] = pattern(i);
+	}
+}
+
+static void fill_guard(uint8_t* buf, size_t size)
+{
+	for(size_t i = 0; i < size; i++)
+	{
+		buf[i] = GUARD_BYTE;
+	}
+}
+
+/// Copy src to a zero-based offset of dst and check the result, including that
+/// no byte outside of the destination range was written
+static void check_copy(size_t size, size_t src_offset, size_t dst_offset)
+{
+	uint8_t* src = src_buf_ + GUARD + src_offset;
+	uint8_t* dst = dst_buf_ + GUARD + dst_offset;
+
+	fill_guard(dst_buf_, size + 2 * GUARD + dst_offset);
+
+	assert_ptr_equal(dst, memcpy(dst, src, size));
+
+	for(size_t i = 0; i < size; i++)
+	{
+		if(dst[i] != src[i])
+		{
+			fail_msg("size %zu, src offset %zu, dst offset %zu: byte %zu differs", size,
+					 src_offset, dst_offset, i);
+		}
+	}
+
+	for(size_t i = 0; i < GUARD; i++)
+	{
+		assert_int_equal(GUARD_BYTE, dst[-1 - (ptrdiff_t)i]);
+		assert_int_equal(GUARD_BYTE, dst[size + i]);
+	}
+}
+
+/// Move size bytes within one buffer, from offset src to offset dst, and compare
+/// against a copy made with a byte loop
+static void check_move(size_t size, size_t src_offset, size_t dst_offset)
+{
+	uint8_t* buf = dst_buf_ + GUARD;
+
+	fill_pattern(dst_buf_, size + 2 * GUARD + (src_offset > dst_offset ? src_offset : dst_offset));
+
+	assert_ptr_equal(buf + dst_offset, memmove(buf + dst_offset, buf + src_offset, size));
+
+	for(size_t i = 0; i < size; i++)
+	{
+		if(buf[dst_offset + i] != pattern(GUARD + src_offset + i))
+		{
+			fail_msg("size %zu, src offset %zu, dst offset %zu: byte %zu differs", size,
+					 src_offset, dst_offset, i);
+		}
+	}
+
+	// Bytes outside of the destination keep their original values
+	assert_int_equal(pattern(GUARD + dst_offset - 1), buf[dst_offset - 1]);
+	assert_int_equal(pattern(GUARD + dst_offset + size), buf[dst_offset + size]);
+}
+
+#pragma mark - Tests -
+
+static void memcpy_small_test(void** state)
+{
+	(void)state;
+
+	fill_pattern(src_buf_, BUFFER_SIZE);
+
+	// Every size that has its own code path, at every combination of 32-byte alignments
+	for(size_t size = 0; size <= 300; size++)
+	{
+		for(size_t src_offset = 0; src_offset < 32; src_offset++)
+		{
+			for(size_t dst_offset = 0; dst_offset < 32; dst_offset += 3)
+			{
+				check_copy(size, src_offset, dst_offset);
+			}
+		}
+	}
+}
+
+static void memcpy_large_test(void** state)
+{
+	static const size_t sizes[] = {511, 4096, 4096 + 15, 65536 + 33, LARGE_SIZE};
+	(void)state;
+
+	fill_pattern(src_buf_, BUFFER_SIZE);
+
+	for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		check_copy(sizes[i], 0, 0);
+		check_copy(sizes[i], 1, 0);
+		check_copy(sizes[i], 0, 31);
+		check_copy(sizes[i], 17, 40);
+	}
+}
+
+static void memmove_overlap_test(void** state)
+{
+	(void)state;
+
+	// Source and destination closer than a vector, and further apart than the unrolled loop
+	for(size_t size = 0; size <= 600; size += (size < 140 ? 1 : 37))
+	{
+		for(size_t distance = 1; distance <= 200; distance += (distance < 40 ? 1 : 23))
+		{
+			check_move(size, distance, 0);
+			check_move(size, 0, distance);
+			check_move(size, distance + 3, 5);
+			check_move(size, 5, distance + 3);
+		}
+	}
+}
+
+static void memmove_large_overlap_test(void** state)
+{
+	(void)state;
+
+	// Overlapping moves never use the streaming path, but large non-overlapping ones do
+	check_move(LARGE_SIZE - 200, 100, 0);
+	check_move(LARGE_SIZE - 200, 0, 100);
+	check_move(1024 * 1024 + 100, 0, 1024 * 1024 + 101);
+	check_move(1024 * 1024 + 100, 1024 * 1024 + 101, 0);
+}
+
+static void memmove_same_buffer_test(void** state)
+{
+	uint8_t* buf = dst_buf_ + GUARD;
+	(void)state;
+
+	fill_pattern(dst_buf_, 1024);
+	assert_ptr_equal(buf, memmove(buf, buf, 512));
+
+	for(size_t i = 0; i < 512; i++)
+	{
+		assert_int_equal(pattern(GUARD + i), buf[i]);
+	}
+}
+
+#pragma mark - Public Functions -
+
+int memcpy_test_suite(void)
+{
+	const struct CMUnitTest memcpy_tests[] = {
+		cmocka_unit_test(memcpy_small_test),
+		cmocka_unit_test(memcpy_large_test),
+		cmocka_unit_test(memmove_overlap_test),
+		cmocka_unit_test(memmove_large_overlap_test),
+		cmocka_unit_test(memmove_same_buffer_test),
+	};
+
+	return cmocka_run_group_tests_name("memcpy", memcpy_tests, NULL, NULL);
+}
@@ -0,0 +1,137 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <string.h>
+#include "string_tests.h"
+
+/// This file is compiled with the libc string functions renamed (see libc_string_host_args),
+/// so memset() below is the libc version.
+
+// The host's string.h doesn't always declare these
+void* memset_explicit(void* dest, int c, size_t n);
+void explicit_bzero(void* dest, size_t n);
+
+/// Larger than MEMSET_ERMS_THRESHOLD, so that the rep stosb path is covered
+#define LARGE_SIZE (1024 * 1024 + 77)
+#define GUARD 64
+#define MAX_OFFSET 64
+#define BUFFER_SIZE (LARGE_SIZE + MAX_OFFSET + 2 * GUARD)
+#define GUARD_BYTE 0xA5
+
+static uint8_t buf_[BUFFER_SIZE];
+
+#pragma mark - Helpers -
+
+/// Fill size bytes at offset, with GUARD_BYTE around them, and check the result
+static void check_fill(size_t size, size_t offset, int c)
+{
+	uint8_t* dst = buf_ + GUARD + offset;
+	uint8_t expected = (uint8_t)c;
+
+	for(size_t i = 0; i < size + 2 * GUARD + offset; i++)
+	{
+		buf_[i] = GUARD_BYTE;
+	}
+
+	assert_ptr_equal(dst, memset(dst, c, size));
+
+	for(size_t i = 0; i < size; i++)
+	{
+		if(dst[i] != expected)
+		{
+			fail_msg("size %zu, offset %zu: byte %zu is 0x%x", size, offset, i, dst[i]);
+		}
+	}
+
+	for(size_t i = 0; i < GUARD; i++)
+	{
+		assert_int_equal(GUARD_BYTE, dst[-1 - (ptrdiff_t)i]);
+		assert_int_equal(GUARD_BYTE, dst[size + i]);
+	}
+}
+
+#pragma mark - Tests -
+
+static void memset_small_test(void** state)
+{
+	(void)state;
+
+	// Every size that has its own code path, at every alignment within a cache line
+	for(size_t size = 0; size <= 300; size++)
+	{
+		for(size_t offset = 0; offset < MAX_OFFSET; offset++)
+		{
+			check_fill(size, offset, 0);
+			check_fill(size, offset, 0x7E);
+		}
+	}
+}
+
+static void memset_large_test(void** state)
+{
+	static const size_t sizes[] = {511, 2047, 2048, 4096 + 15, 65536 + 33, LARGE_SIZE};
+	(void)state;
+
+	for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+	{
+		check_fill(sizes[i], 0, 0);
+		check_fill(sizes[i], 1, 0xFF);
+		check_fill(sizes[i], 31, 0x80);
+		check_fill(sizes[i], 63, 0x01);
+	}
+}
+
+static void memset_value_test(void** state)
+{
+	(void)state;
+
+	// The value is converted to unsigned char
+	check_fill(100, 3, 0x1234);
+	check_fill(100, 3, -1);
+	check_fill(3000, 5, 0x1280);
+}
+
+static void memset_explicit_test(void** state)
+{
+	uint8_t* dst = buf_ + GUARD;
+	(void)state;
+
+	for(size_t i = 0; i < 100; i++)
+	{
+		dst[i] = (uint8_t)(i + 1);
+	}
+
+	assert_ptr_equal(dst, memset_explicit(dst, 0x5C, 50));
+	explicit_bzero(dst + 50, 40);
+
+	for(size_t i = 0; i < 100; i++)
+	{
+		uint8_t expected = (i < 50) ? 0x5C : (i < 90) ? 0 : (uint8_t)(i + 1);
+		assert_int_equal(expected, dst[i]);
+	}
+}
+
+#pragma mark - Public Functions -
+
+int memset_test_suite(void)
+{
+	const struct CMUnitTest memset_tests[] = {
+		cmocka_unit_test(memset_small_test),
+		cmocka_unit_test(memset_large_test),
+		cmocka_unit_test(memset_value_test),
+		cmocka_unit_test(memset_explicit_test),
+	};
+
+	return cmocka_run_group_tests_name("memset", memset_tests, NULL, NULL);
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef LIBC_STRING_TESTS_H_
+#define LIBC_STRING_TESTS_H_
+
+int find_byte_test_suite(void);
+int memcmp_test_suite(void);
+int memcpy_test_suite(void);
+int memset_test_suite(void);
+int substring_test_suite(void);
+int tokenize_test_suite(void);
+
+#endif // LIBC_STRING_TESTS_H_
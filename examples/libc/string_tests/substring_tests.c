@@ -0,0 +1,260 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <string.h>
+#include "string_tests.h"
+
+/// This file is compiled with the libc string functions renamed (see libc_string_host_args),
+/// so strstr(), strnstr(), and memmem() below are the libc versions.
+///
+/// Results are compared against a naive search. Small alphabets make partial matches, and so
+/// the Two-Way fallback, common.
+
+// The host's string.h doesn't always declare these
+char* strnstr(const char* s, const char* find, size_t slen);
+void* memmem(const void* l, size_t l_len, const void* s, size_t s_len);
+
+#define MAX_HAYSTACK 2000
+#define MAX_NEEDLE 64
+#define ADVERSARIAL_LENGTH (256 * 1024)
+
+static char haystack_[ADVERSARIAL_LENGTH + 1];
+static char needle_[ADVERSARIAL_LENGTH + 1];
+
+#pragma mark - Helpers -
+
+static uint32_t random_state_ = 12345;
+
+static uint32_t next_random(void)
+{
+	// xorshift32
+	random_state_ ^= random_state_ << 13;
+	random_state_ ^= random_state_ >> 17;
+	random_state_ ^= random_state_ << 5;
+
+	return random_state_;
+}
+
+static void fill_random(char* s, size_t length, const char* alphabet)
+{
+	size_t alphabet_size = strlen(alphabet);
+
+	for(size_t i = 0; i < length; i++)
+	{
+		s[i] = alphabet[next_random() % alphabet_size];
+	}
+
+	s[length] = '\0';
+}
+
+/// The index of the first occurrence of n in h, or SIZE_MAX if there is none
+static size_t naive_search(const char* h, size_t h_len, const char* n, size_t n_len)
+{
+	for(size_t i = 0; i + n_len <= h_len; i++)
+	{
+		size_t k = 0;
+
+		while(k < n_len && h[i + k] == n[k])
+		{
+			k++;
+		}
+
+		if(k == n_len)
+		{
+			return i;
+		}
+	}
+
+	return SIZE_MAX;
+}
+
+/// Check every entry point with the needle n_len bytes at n, and the haystack h_len bytes at h
+static void check_search(const char* h, size_t h_len, const char* n, size_t n_len)
+{
+	size_t expected = naive_search(h, h_len, n, n_len);
+	const char* expected_ptr = (expected == SIZE_MAX) ? NULL : h + expected;
+	char saved_needle_end = n[n_len];
+	char saved_haystack_end = h[h_len];
+
+	((char*)n)[n_len] = '\0';
+	((char*)h)[h_len] = '\0';
+
+	if(strstr(h, n) != expected_ptr)
+	{
+		fail_msg("strstr(\"%.40s\" (%zu), \"%.40s\" (%zu)) returned %td, expected %zu", h, h_len,
+				 n, n_len, strstr(h, n) ? strstr(h, n) - h : -1, expected);
+	}
+
+	// memmem() doesn't match an empty needle
+	assert_ptr_equal((n_len == 0) ? NULL : expected_ptr, memmem(h, h_len, n, n_len));
+	assert_ptr_equal(expected_ptr, strnstr(h, n, h_len));
+	assert_ptr_equal(expected_ptr, strnstr(h, n, SIZE_MAX));
+
+	// A limit that ends right before the match, or within it
+	if(expected_ptr && n_len > 0)
+	{
+		size_t limit = expected + n_len - 1;
+		size_t next = naive_search(h, limit, n, n_len);
+		const char* next_ptr = (next == SIZE_MAX) ? NULL : h + next;
+
+		assert_ptr_equal(next_ptr, strnstr(h, n, limit));
+		assert_ptr_equal(next_ptr, memmem(h, limit, n, n_len));
+	}
+
+	((char*)n)[n_len] = saved_needle_end;
+	((char*)h)[h_len] = saved_haystack_end;
+}
+
+#pragma mark - Tests -
+
+static void substring_exhaustive_test(void** state)
+{
+	char h[16];
+	char n[8];
+	(void)state;
+
+	// Every haystack over {a, b} up to 10 bytes, against every needle up to 5 bytes
+	for(size_t h_len = 0; h_len <= 10; h_len++)
+	{
+		for(uint32_t hv = 0; hv < (1U << h_len); hv++)
+		{
+			for(size_t i = 0; i < h_len; i++)
+			{
+				h[i] = (hv & (1U << i)) ? 'b' : 'a';
+			}
+
+			for(size_t n_len = 0; n_len <= 5; n_len++)
+			{
+				for(uint32_t nv = 0; nv < (1U << n_len); nv++)
+				{
+					for(size_t i = 0; i < n_len; i++)
+					{
+						n[i] = (nv & (1U << i)) ? 'b' : 'a';
+					}
+
+					check_search(h, h_len, n, n_len);
+				}
+			}
+		}
+	}
+}
+
+static void substring_random_test(void** state)
+{
+	static const char* alphabets[] = {"ab", "abc", "aab", "abcdefghijklmnopqrstuvwxyz"};
+	(void)state;
+
+	for(size_t a = 0; a < sizeof(alphabets) / sizeof(alphabets[0]); a++)
+	{
+		for(unsigned round = 0; round < 300; round++)
+		{
+			size_t h_len = next_random() % MAX_HAYSTACK;
+			size_t n_len = 1 + next_random() % MAX_NEEDLE;
+
+			fill_random(haystack_, h_len, alphabets[a]);
+			fill_random(needle_, n_len, alphabets[a]);
+			check_search(haystack_, h_len, needle_, n_len);
+
+			// A needle taken from the haystack always matches
+			if(n_len <= h_len)
+			{
+				size_t pos = next_random() % (h_len - n_len + 1);
+
+				memcpy(needle_, haystack_ + pos, n_len);
+				check_search(haystack_, h_len, needle_, n_len);
+			}
+		}
+	}
+}
+
+static void substring_binary_test(void** state)
+{
+	static const char h[] = "ab\0cd\0ab\0cd\xff\x80";
+	static const char n[] = "\0cd\xff";
+	(void)state;
+
+	// memmem() searches past NUL bytes, and strstr() stops at them
+	assert_ptr_equal(h + 8, memmem(h, sizeof(h) - 1, n, 4));
+	assert_ptr_equal(h + 2, memmem(h, sizeof(h) - 1, n, 3));
+	assert_ptr_equal(h + 11, memmem(h, sizeof(h) - 1, "\xff\x80", 2));
+	assert_null(strstr(h, "cd"));
+	assert_ptr_equal(h, strstr(h, ""));
+	assert_null(memmem(h, 0, "a", 1));
+}
+
+static void substring_adversarial_test(void** state)
+{
+	static const size_t needle_lengths[] = {2, 3, 16, 17, 100, 1000, 10000};
+	(void)state;
+
+	for(size_t i = 0; i < sizeof(needle_lengths) / sizeof(needle_lengths[0]); i++)
+	{
+		size_t n_len = needle_lengths[i];
+
+		// "aaa...a" against "aa...ab" makes every position a candidate. A quadratic search
+		// would take minutes here.
+		memset(haystack_, 'a', ADVERSARIAL_LENGTH);
+		haystack_[ADVERSARIAL_LENGTH] = '\0';
+		memset(needle_, 'a', n_len);
+		needle_[n_len - 1] = 'b';
+		needle_[n_len] = '\0';
+
+		assert_null(strstr(haystack_, needle_));
+		assert_null(memmem(haystack_, ADVERSARIAL_LENGTH, needle_, n_len));
+
+		haystack_[ADVERSARIAL_LENGTH - 1] = 'b';
+		assert_ptr_equal(haystack_ + ADVERSARIAL_LENGTH - n_len, strstr(haystack_, needle_));
+		assert_ptr_equal(haystack_ + ADVERSARIAL_LENGTH - n_len,
+						 memmem(haystack_, ADVERSARIAL_LENGTH, needle_, n_len));
+		assert_ptr_equal(haystack_ + ADVERSARIAL_LENGTH - n_len,
+						 strnstr(haystack_, needle_, ADVERSARIAL_LENGTH));
+		assert_null(strnstr(haystack_, needle_, ADVERSARIAL_LENGTH - 1));
+
+		// "ba...a" mismatches at the first byte instead of the last, and a periodic
+		// needle with a mismatch at the end of each period
+		needle_[n_len - 1] = 'a';
+		needle_[0] = 'b';
+		assert_null(strstr(haystack_, needle_));
+
+		for(size_t k = 0; k < n_len; k++)
+		{
+			needle_[k] = (k % 4 == 3) ? 'b' : 'a';
+		}
+
+		for(size_t k = 0; k < ADVERSARIAL_LENGTH; k++)
+		{
+			haystack_[k] = (k % 4 == 3 && k % 512 != 511) ? 'b' : 'a';
+		}
+
+		check_search(haystack_, ADVERSARIAL_LENGTH, needle_, n_len);
+	}
+}
+
+#pragma mark - Public Functions -
+
+int substring_test_suite(void)
+{
+	const struct CMUnitTest substring_tests[] = {
+		cmocka_unit_test(substring_exhaustive_test),
+		cmocka_unit_test(substring_random_test),
+		cmocka_unit_test(substring_binary_test),
+		cmocka_unit_test(substring_adversarial_test),
+	};
+
+	return cmocka_run_group_tests_name("substring", substring_tests, NULL, NULL);
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+// Cmocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <stdint.h>
+#include <string.h>
+#include "string_tests.h"
+
+/// This file is compiled with the libc string functions renamed (see libc_string_host_args),
+/// so strspn(), strcspn(), strpbrk(), strtok(), and strtok_r() below are the libc versions.
+///
+/// Results are compared against naive versions that scan the whole set for each byte. The
+/// sets include bytes with the high bit set, which land in the upper half of the bitmap.
+
+#define MAX_LENGTH 200
+#define MAX_SET 8
+
+static char string_[MAX_LENGTH + 1];
+static char copy_[MAX_LENGTH + 1];
+static char set_[MAX_SET + 1];
+
+/// Bytes used by the random strings and sets. '\x80' and '\xff' land in the last words of the
+/// bitmap, and '\x01' and '\x3f' / '\x40' sit on either side of a 64-bit word boundary.
+static const char alphabet_[] = "ab,;\x01\x3f\x40\x80\xff";
+
+#pragma mark - Helpers -
+
+static uint32_t random_state_ = 54321;
+
+static uint32_t next_random(void)
+{
+	// xorshift32
+	random_state_ ^= random_state_ << 13;
+	random_state_ ^= random_state_ >> 17;
+	random_state_ ^= random_state_ << 5;
+
+	return random_state_;
+}
+
+static void fill_random(char* s, size_t length)
+{
+	for(size_t i = 0; i < length; i++)
+	{
+		s[i] = alphabet_[next_random() % (sizeof(alphabet_) - 1)];
+	}
+
+	s[length] = '\0';
+}
+
+static size_t naive_span(const char* s, const char* set, int complement)
+{
+	size_t i = 0;
+
+	for(; s[i] != '\0'; i++)
+	{
+		if((strchr(set, s[i]) != NULL) == complement)
+		{
+			break;
+		}
+	}
+
+	return i;
+}
+
+/// Check the span functions, and tokenize a copy of the string with strtok_r()
+static void check_string(const char* s, const char* set)
+{
+	size_t accept = naive_span(s, set, 0);
+	size_t reject = naive_span(s, set, 1);
+	char* tok;
+	char* last = NULL;
+	const char* cur = s;
+
+	assert_int_equal(accept, strspn(s, set));
+	assert_int_equal(reject, strcspn(s, set));
+	assert_ptr_equal((s[reject] != '\0') ? s + reject : NULL, strpbrk(s, set));
+
+	strcpy(copy_, s);
+
+	for(tok = strtok_r(copy_, set, &last); tok != NULL; tok = strtok_r(NULL, set, &last))
+	{
+		size_t length;
+
+		cur += naive_span(cur, set, 0);
+		length = naive_span(cur, set, 1);
+
+		assert_ptr_equal(copy_ + (cur - s), tok);
+		assert_int_equal(length, strlen(tok));
+		assert_true(length > 0);
+
+		cur += length;
+
+		if(*cur != '\0')
+		{
+			cur++;
+		}
+	}
+
+	// Every token was found
+	assert_int_equal(strlen(cur), naive_span(cur, set, 0));
+	assert_null(last);
+}
+
+#pragma mark - Tests -
+
+static void span_test(void** state)
+{
+	static const char s[] = "\xff\x80" "abc,;def";
+	(void)state;
+
+	assert_int_equal(0, strspn("", "abc"));
+	assert_int_equal(0, strspn("abc", ""));
+	assert_int_equal(3, strspn("aaab", "a"));
+	assert_int_equal(4, strspn("abcd", "dcba"));
+	assert_int_equal(2, strspn(s, "\x80\xff"));
+	assert_int_equal(5, strspn(s, "\x80\xff" "abc"));
+
+	assert_int_equal(0, strcspn("", "abc"));
+	assert_int_equal(3, strcspn("abc", ""));
+	assert_int_equal(2, strcspn("aab", "b"));
+	assert_int_equal(5, strcspn(s, ",;"));
+	assert_int_equal(1, strcspn(s, "\x80"));
+	assert_int_equal(0, strcspn(s, "a\xff"));
+
+	assert_ptr_equal(s + 5, strpbrk(s, ";,"));
+	assert_ptr_equal(s + 1, strpbrk(s, "\x80"));
+	assert_null(strpbrk(s, "xyz"));
+	assert_null(strpbrk(s, ""));
+	assert_null(strpbrk("", "abc"));
+}
+
+static void span_random_test(void** state)
+{
+	(void)state;
+
+	for(unsigned round = 0; round < 2000; round++)
+	{
+		fill_random(string_, next_random() % MAX_LENGTH);
+		fill_random(set_, next_random() % (MAX_SET + 1));
+		check_string(string_, set_);
+	}
+}
+
+static void strtok_test(void** state)
+{
+	char s[] = ",,a,bc;;d,,";
+	char empty[] = "";
+	char delimiters[] = ",;,;";
+	(void)state;
+
+	assert_ptr_equal(s + 2, strtok(s, ",;"));
+	assert_ptr_equal(s + 4, strtok(NULL, ","));
+	assert_string_equal("bc;;d", s + 4);
+	assert_null(strtok(NULL, ",;"));
+	assert_null(strtok(NULL, ",;"));
+
+	assert_null(strtok(empty, ","));
+	assert_null(strtok(delimiters, ",;"));
+
+	// The delimiters can change between calls
+	strcpy(s, "a;b,c");
+	assert_ptr_equal(s, strtok(s, ";"));
+	assert_ptr_equal(s + 2, strtok(NULL, ","));
+	assert_ptr_equal(s + 4, strtok(NULL, ","));
+	assert_null(strtok(NULL, ","));
+}
+
+static void strtok_r_reentrant_test(void** state)
+{
+	char outer[] = "a=1;b=22;c=333";
+	char* outer_last = NULL;
+	char* inner_last = NULL;
+	size_t count = 0;
+	(void)state;
+
+	// Each field is split again while the outer tokenization is in progress
+	for(char* field = strtok_r(outer, ";", &outer_last); field != NULL;
+		field = strtok_r(NULL, ";", &outer_last))
+	{
+		char* key = strtok_r(field, "=", &inner_last);
+		char* value = strtok_r(NULL, "=", &inner_last);
+
+		assert_int_equal(1, strlen(key));
+		assert_int_equal(count + 1, strlen(value));
+		assert_null(strtok_r(NULL, "=", &inner_last));
+		count++;
+	}
+
+	assert_int_equal(3, count);
+}
+
+#pragma mark - Public Functions -
+
+int tokenize_test_suite(void)
+{
+	const struct CMUnitTest tokenize_tests[] = {
+		cmocka_unit_test(span_test),
+		cmocka_unit_test(span_random_test),
+		cmocka_unit_test(strtok_test),
+		cmocka_unit_test(strtok_r_reentrant_test),
+	};
+
+	return cmocka_run_group_tests_name("tokenize", tokenize_tests, NULL, NULL);
+}
@@ -0,0 +1,42 @@
+#ifndef LIBC_HOST_PROTOTYPES_H_
+#define LIBC_HOST_PROTOTYPES_H_
+
+#include <stddef.h>
+
+/**
+ * Prototypes for host builds of the libc sources
+ *
+ * Host builds (see libc_stdlib_host_args and libc_malloc_freelist_host_args) compile the
+ * sources against the host's headers, which don't declare these libc functions. This header
+ * declares them instead, and is included in those builds with -include. It matches the
+ * libc's own stdlib.h and strings.h, and is never used when building the libc itself.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif //__cplusplus
+
+int fls(int mask);
+int flsl(long mask);
+
+int heapsort(void* vbase, size_t nmemb, size_t size, int (*compar)(const void*, const void*));
+
+// Host C libraries may declare a qsort_r() with a different signature, so this is only
+// declared when the build renames it
+#ifdef qsort_r
+void qsort_r(void* a, size_t n, size_t es, void* thunk,
+			 int (*cmp)(void*, const void*, const void*));
+#endif
+
+void qsort_parallel(void* base, size_t n, size_t es, int (*cmp)(void*, const void*, const void*),
+					void* thunk, unsigned nthreads);
+
+size_t malloc_usable_size(void* ptr);
+int malloc_resize_in_place(void* ptr, size_t size);
+void* reallocf(void* ptr, size_t size);
+
+#ifdef __cplusplus
+}
+#endif //__cplusplus
+
+#endif // LIBC_HOST_PROTOTYPES_H_
@@ -0,0 +1,73 @@
+#ifndef X86_64_CPU_FEATURES_H_
+#define X86_64_CPU_FEATURES_H_
+
+#include <cpuid.h>
+
+/**
+ * Runtime CPU feature checks for the x86_64 string functions. Each function queries cpuid,
+ * so callers should check once and cache the result (e.g. in a dispatch pointer).
+ */
+
+/// Enhanced REP MOVSB/STOSB, in CPUID.(EAX=7, ECX=0):EBX
+#define CPU_FEATURE_ERMS (1U << 9)
+
+/// AVX2 needs support from the processor, and the OS must save the YMM registers
+static inline int cpu_has_avx2(void)
+{
+	unsigned int eax;
+	unsigned int ebx;
+	unsigned int ecx;
+	unsigned int edx;
+	unsigned int xcr0_lo;
+	unsigned int xcr0_hi;
+
+	if(!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_OSXSAVE) || !(ecx & bit_AVX))
+	{
+		return 0;
+	}
+
+	// XCR0 bits 1 and 2: the OS saves the XMM and YMM state on a context switch
+	__asm__ volatile("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	if((xcr0_lo & 0x6) != 0x6)
+	{
+		return 0;
+	}
+
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+	{
+		return 0;
+	}
+
+	return (ebx & bit_AVX2) != 0;
+}
+
+/**
+ * Whether to dispatch to the AVX2 versions. Define X86_64_STRING_FORCE_SSE2 to always use the
+ * SSE2 versions, so that they can be tested on hosts that support AVX2.
+ */
+static inline int cpu_use_avx2(void)
+{
+#ifdef X86_64_STRING_FORCE_SSE2
+	return 0;
+#else
+	return cpu_has_avx2();
+#endif
+}
+
+/// With ERMS, rep movsb/stosb is the fastest way to handle large buffers
+static inline int cpu_has_erms(void)
+{
+	unsigned int eax;
+	unsigned int ebx;
+	unsigned int ecx;
+	unsigned int edx;
+
+	if(!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+	{
+		return 0;
+	}
+
+	return (ebx & CPU_FEATURE_ERMS) != 0;
+}
+
+#endif // X86_64_CPU_FEATURES_H_
@@ -0,0 +1,190 @@
+#include <emmintrin.h>
+#include <stdint.h>
+#include <string.h>
+
+/**
+ * x86_64 memcmp()
+ *
+ * Buffers of 16 bytes or more are compared 16 bytes at a time with SSE2: pcmpeqb marks the
+ * equal bytes, and pmovmskb turns that into a bit mask, so the index of the first mismatch is
+ * the lowest clear bit. Four vectors are compared per iteration, and the last block overlaps
+ * bytes that were already compared, so no byte loop is needed.
+ *
+ * Shorter buffers are compared as overlapping head and tail words. Byte-swapping a word puts
+ * its first byte in the most significant position, so an integer comparison of two
+ * byte-swapped words gives the memcmp() ordering.
+ */
+
+#pragma mark - Private Functions -
+
+static inline uint64_t load64(const uint8_t* p)
+{
+	uint64_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return __builtin_bswap64(v);
+}
+
+static inline uint32_t load32(const uint8_t* p)
+{
+	uint32_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return __builtin_bswap32(v);
+}
+
+static inline __m128i load128(const uint8_t* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+/// Bit i of the result is set if byte i of the two vectors is equal
+static inline unsigned equal_mask(const uint8_t* s1, const uint8_t* s2)
+{
+	return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(load128(s1), load128(s2)));
+}
+
+/// Compare the byte at the first clear bit of mask, which must not be 0xFFFF
+static inline int first_difference(const uint8_t* s1, const uint8_t* s2, unsigned mask)
+{
+	unsigned i = (unsigned)__builtin_ctz(~mask);
+
+	return s1[i] - s2[i];
+}
+
+/// Compare fewer than 16 bytes
+static inline int compare_small(const uint8_t* s1, const uint8_t* s2, size_t n)
+{
+	if(n >= 8)
+	{
+		uint64_t a = load64(s1);
+		uint64_t b = load64(s2);
+
+		if(a == b)
+		{
+			a = load64(s1 + n - 8);
+			b = load64(s2 + n - 8);
+		}
+
+		return (a == b) ? 0 : (a > b) ? 1 : -1;
+	}
+
+	if(n >= 4)
+	{
+		uint32_t a = load32(s1);
+		uint32_t b = load32(s2);
+
+		if(a == b)
+		{
+			a = load32(s1 + n - 4);
+			b = load32(s2 + n - 4);
+		}
+
+		return (a == b) ? 0 : (a > b) ? 1 : -1;
+	}
+
+	for(; n > 0; n--, s1++, s2++)
+	{
+		if(*s1 != *s2)
+		{
+			return *s1 - *s2;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Compare four vectors, at offset 0 and at offsets o1, o2 and o3. The vectors may overlap, but
+ * every byte in front of a vector must be covered by the vectors before it, so that the first
+ * mismatch found is the first in the range. The offsets don't have to increase: for n < 48,
+ * memcmp() passes o2 = n - 32 < o1, and that vector lies within the first two. The position
+ * of a mismatch is only searched for once the combined comparison has found one.
+ */
+static inline int compare_four(const uint8_t* s1, const uint8_t* s2, size_t o1, size_t o2,
+							   size_t o3)
+{
+	const size_t offsets[4] = {0, o1, o2, o3};
+	__m128i e0 = _mm_cmpeq_epi8(load128(s1), load128(s2));
+	__m128i e1 = _mm_cmpeq_epi8(load128(s1 + o1), load128(s2 + o1));
+	__m128i e2 = _mm_cmpeq_epi8(load128(s1 + o2), load128(s2 + o2));
+	__m128i e3 = _mm_cmpeq_epi8(load128(s1 + o3), load128(s2 + o3));
+	__m128i all = _mm_and_si128(_mm_and_si128(e0, e1), _mm_and_si128(e2, e3));
+
+	if(_mm_movemask_epi8(all) == 0xFFFF)
+	{
+		return 0;
+	}
+
+	// Vectors are checked in order, so the first mismatch found is the first in the range
+	for(unsigned i = 0; i < 4; i++)
+	{
+		unsigned mask = equal_mask(s1 + offsets[i], s2 + offsets[i]);
+		if(mask != 0xFFFF)
+		{
+			return first_difference(s1 + offsets[i], s2 + offsets[i], mask);
+		}
+	}
+
+	return 0;
+}
+
+#pragma mark - APIs -
+
+int __attribute__((weak)) memcmp(const void* p1, const void* p2, size_t n)
+{
+	const uint8_t* s1 = p1;
+	const uint8_t* s2 = p2;
+	unsigned mask;
+	int result;
+
+	if(!p1)
+	{
+		return 1;
+	}
+
+	if(!p2)
+	{
+		return -1;
+	}
+
+	if(p1 == p2)
+	{
+		return 0;
+	}
+
+	if(n < 16)
+	{
+		return compare_small(s1, s2, n);
+	}
+
+	if(n <= 32)
+	{
+		mask = equal_mask(s1, s2);
+		if(mask != 0xFFFF)
+		{
+			return first_difference(s1, s2, mask);
+		}
+
+		s1 += n - 16;
+		s2 += n - 16;
+		mask = equal_mask(s1, s2);
+
+		return (mask == 0xFFFF) ? 0 : first_difference(s1, s2, mask);
+	}
+
+	if(n <= 64)
+	{
+		return compare_four(s1, s2, 16, n - 32, n - 16);
+	}
+
+	for(; n > 64; n -= 64, s1 += 64, s2 += 64)
+	{
+		result = compare_four(s1, s2, 16, 32, 48);
+		if(result != 0)
+		{
+			return result;
+		}
+	}
+
+	// The last block overlaps bytes that were already found to be equal
+	return compare_four(s1 + n - 64, s2 + n - 64, 16, 32, 48);
+}
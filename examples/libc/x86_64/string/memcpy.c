@@ -0,0 +1,452 @@
+#include <immintrin.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "cpu_features.h"
+
+/**
+ * x86_64 memcpy() and memmove()
+ *
+ * Both functions share one overlap-safe implementation:
+ *	- Up to eight vectors, the head and tail of the buffer are loaded into registers with
+ *	  (possibly overlapping) loads before anything is stored. This covers every size in
+ *	  that range without a loop, and is safe for any overlap.
+ *	- Larger copies save the vectors at both edges, then run an unrolled loop with aligned
+ *	  stores in whichever direction is safe, and finish by storing the saved vectors.
+ *	- Copies above MEMCPY_NONTEMPORAL_THRESHOLD that don't overlap use non-temporal stores,
+ *	  which bypass the cache instead of evicting the working set with data that won't be
+ *	  read again soon.
+ *
+ * The SSE2 loop is always available on x86_64. The AVX2 loop is selected at runtime with
+ * cpuid when both the processor and the OS (via XSAVE) support it, unless
+ * X86_64_STRING_FORCE_SSE2 is defined.
+ */
+
+#pragma mark - Definitions -
+
+#ifndef MEMCPY_NONTEMPORAL_THRESHOLD
+/// Copies larger than this bypass the cache. This should be around the size of the
+/// last-level cache that a single core can use.
+#define MEMCPY_NONTEMPORAL_THRESHOLD (1024 * 1024)
+#endif
+
+typedef void* (*copy_fn_t)(unsigned char* dst, const unsigned char* src, size_t n);
+
+#pragma mark - Declarations -
+
+static void* copy_dispatch(unsigned char* dst, const unsigned char* src, size_t n);
+
+/// The selected implementation, resolved on the first call. Racing first calls may each
+/// resolve it, but they all store the same pointer. The pointer is all that's shared, so
+/// relaxed accesses are enough; they only keep the racing accesses well-defined.
+static _Atomic(copy_fn_t) copy_impl = copy_dispatch;
+
+#pragma mark - Private Functions -
+
+static inline uint64_t load64(const unsigned char* p)
+{
+	uint64_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void store64(unsigned char* p, uint64_t v)
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline uint32_t load32(const unsigned char* p)
+{
+	uint32_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void store32(unsigned char* p, uint32_t v)
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline uint16_t load16(const unsigned char* p)
+{
+	uint16_t v;
+	__builtin_memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static inline void store16(unsigned char* p, uint16_t v)
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+/// Copy up to 16 bytes. All loads happen before the stores, so overlap is allowed.
+static inline void copy_small(unsigned char* dst, const unsigned char* src, size_t n)
+{
+	if(n >= 8)
+	{
+		uint64_t head = load64(src);
+		uint64_t tail = load64(src + n - 8);
+		store64(dst, head);
+		store64(dst + n - 8, tail);
+	}
+	else if(n >= 4)
+	{
+		uint32_t head = load32(src);
+		uint32_t tail = load32(src + n - 4);
+		store32(dst, head);
+		store32(dst + n - 4, tail);
+	}
+	else if(n >= 2)
+	{
+		uint16_t head = load16(src);
+		uint16_t tail = load16(src + n - 2);
+		store16(dst, head);
+		store16(dst + n - 2, tail);
+	}
+	else if(n == 1)
+	{
+		*dst = *src;
+	}
+}
+
+/// True if [src, src + n) and [dst, dst + n) share any bytes
+static inline int regions_overlap(const unsigned char* dst, const unsigned char* src, size_t n)
+{
+	return (uintptr_t)dst - (uintptr_t)src < n || (uintptr_t)src - (uintptr_t)dst < n;
+}
+
+#pragma mark - SSE2 -
+
+static inline __m128i load128(const unsigned char* p)
+{
+	return _mm_loadu_si128((const __m128i*)p);
+}
+
+static inline void store128(unsigned char* p, __m128i v)
+{
+	_mm_storeu_si128((__m128i*)p, v);
+}
+
+/// Copy more than 128 bytes, 64 bytes per iteration
+static void* copy_sse2_loop(unsigned char* dst, const unsigned char* src, size_t n)
+{
+	if((uintptr_t)dst - (uintptr_t)src >= n)
+	{
+		// Forward: dst is below src, or the regions don't overlap. The first 16 and last 64
+		// bytes are saved up front, and cover whatever the aligned loop doesn't.
+		__m128i head = load128(src);
+		__m128i t0 = load128(src + n - 64);
+		__m128i t1 = load128(src + n - 48);
+		__m128i t2 = load128(src + n - 32);
+		__m128i t3 = load128(src + n - 16);
+		size_t skew = 16 - ((uintptr_t)dst & 15);
+		unsigned char* d = dst + skew;
+		const unsigned char* s = src + skew;
+		unsigned char* end = dst + n - 64;
+
+		if(n > MEMCPY_NONTEMPORAL_THRESHOLD && !regions_overlap(dst, src, n))
+		{
+			for(; d < end; d += 64, s += 64)
+			{
+				__m128i v0 = load128(s);
+				__m128i v1 = load128(s + 16);
+				__m128i v2 = load128(s + 32);
+				__m128i v3 = load128(s + 48);
+				_mm_stream_si128((__m128i*)d, v0);
+				_mm_stream_si128((__m128i*)(d + 16), v1);
+				_mm_stream_si128((__m128i*)(d + 32), v2);
+				_mm_stream_si128((__m128i*)(d + 48), v3);
+			}
+
+			// Non-temporal stores are weakly ordered
+			_mm_sfence();
+		}
+		else
+		{
+			for(; d < end; d += 64, s += 64)
+			{
+				__m128i v0 = load128(s);
+				__m128i v1 = load128(s + 16);
+				__m128i v2 = load128(s + 32);
+				__m128i v3 = load128(s + 48);
+				_mm_store_si128((__m128i*)d, v0);
+				_mm_store_si128((__m128i*)(d + 16), v1);
+				_mm_store_si128((__m128i*)(d + 32), v2);
+				_mm_store_si128((__m128i*)(d + 48), v3);
+			}
+		}
+
+		store128(dst, head);
+		store128(dst + n - 64, t0);
+		store128(dst + n - 48, t1);
+		store128(dst + n - 32, t2);
+		store128(dst + n - 16, t3);
+	}
+	else
+	{
+		// Backward: dst overlaps the end of src. This mirrors the forward copy.
+		__m128i h0 = load128(src);
+		__m128i h1 = load128(src + 16);
+		__m128i h2 = load128(src + 32);
+		__m128i h3 = load128(src + 48);
+		__m128i tail = load128(src + n - 16);
+		unsigned char* d = dst + n - ((uintptr_t)(dst + n) & 15);
+		const unsigned char* s = src + (d - dst);
+		unsigned char* end = dst + 64;
+
+		while(d > end)
+		{
+			d -= 64;
+			s -= 64;
+			__m128i v0 = load128(s);
+			__m128i v1 = load128(s + 16);
+			__m128i v2 = load128(s + 32);
+			__m128i v3 = load128(s + 48);
+			_mm_store_si128((__m128i*)d, v0);
+			_mm_store_si128((__m128i*)(d + 16), v1);
+			_mm_store_si128((__m128i*)(d + 32), v2);
+			_mm_store_si128((__m128i*)(d + 48), v3);
+		}
+
+		store128(dst + n - 16, tail);
+		store128(dst, h0);
+		store128(dst + 16, h1);
+		store128(dst + 32, h2);
+		store128(dst + 48, h3);
+	}
+
+	return dst;
+}
+
+static void* copy_sse2(unsigned char* dst, const unsigned char* src, size_t n)
+{
+	if(n <= 16)
+	{
+		copy_small(dst, src, n);
+		return dst;
+	}
+
+	if(n <= 32)
+	{
+		__m128i v0 = load128(src);
+		__m128i v1 = load128(src + n - 16);
+		store128(dst, v0);
+		store128(dst + n - 16, v1);
+		return dst;
+	}
+
+	if(n <= 64)
+	{
+		__m128i v0 = load128(src);
+		__m128i v1 = load128(src + 16);
+		__m128i v2 = load128(src + n - 32);
+		__m128i v3 = load128(src + n - 16);
+		store128(dst, v0);
+		store128(dst + 16, v1);
+		store128(dst + n - 32, v2);
+		store128(dst + n - 16, v3);
+		return dst;
+	}
+
+	if(n <= 128)
+	{
+		__m128i v0 = load128(src);
+		__m128i v1 = load128(src + 16);
+		__m128i v2 = load128(src + 32);
+		__m128i v3 = load128(src + 48);
+		__m128i v4 = load128(src + n - 64);
+		__m128i v5 = load128(src + n - 48);
+		__m128i v6 = load128(src + n - 32);
+		__m128i v7 = load128(src + n - 16);
+		store128(dst, v0);
+		store128(dst + 16, v1);
+		store128(dst + 32, v2);
+		store128(dst + 48, v3);
+		store128(dst + n - 64, v4);
+		store128(dst + n - 48, v5);
+		store128(dst + n - 32, v6);
+		store128(dst + n - 16, v7);
+		return dst;
+	}
+
+	return copy_sse2_loop(dst, src, n);
+}
+
+#pragma mark - AVX2 -
+
+__attribute__((target("avx2"))) static inline __m256i load256(const unsigned char* p)
+{
+	return _mm256_loadu_si256((const __m256i*)p);
+}
+
+__attribute__((target("avx2"))) static inline void store256(unsigned char* p, __m256i v)
+{
+	_mm256_storeu_si256((__m256i*)p, v);
+}
+
+/// Copy more than 256 bytes, 128 bytes per iteration. See copy_sse2_loop().
+__attribute__((target("avx2"))) static void* copy_avx2_loop(unsigned char* dst,
+															const unsigned char* src, size_t n)
+{
+	if((uintptr_t)dst - (uintptr_t)src >= n)
+	{
+		__m256i head = load256(src);
+		__m256i t0 = load256(src + n - 128);
+		__m256i t1 = load256(src + n - 96);
+		__m256i t2 = load256(src + n - 64);
+		__m256i t3 = load256(src + n - 32);
+		size_t skew = 32 - ((uintptr_t)dst & 31);
+		unsigned char* d = dst + skew;
+		const unsigned char* s = src + skew;
+		unsigned char* end = dst + n - 128;
+
+		if(n > MEMCPY_NONTEMPORAL_THRESHOLD && !regions_overlap(dst, src, n))
+		{
+			for(; d < end; d += 128, s += 128)
+			{
+				__m256i v0 = load256(s);
+				__m256i v1 = load256(s + 32);
+				__m256i v2 = load256(s + 64);
+				__m256i v3 = load256(s + 96);
+				_mm256_stream_si256((__m256i*)d, v0);
+				_mm256_stream_si256((__m256i*)(d + 32), v1);
+				_mm256_stream_si256((__m256i*)(d + 64), v2);
+				_mm256_stream_si256((__m256i*)(d + 96), v3);
+			}
+
+			_mm_sfence();
+		}
+		else
+		{
+			for(; d < end; d += 128, s += 128)
+			{
+				__m256i v0 = load256(s);
+				__m256i v1 = load256(s + 32);
+				__m256i v2 = load256(s + 64);
+				__m256i v3 = load256(s + 96);
+				_mm256_store_si256((__m256i*)d, v0);
+				_mm256_store_si256((__m256i*)(d + 32), v1);
+				_mm256_store_si256((__m256i*)(d + 64), v2);
+				_mm256_store_si256((__m256i*)(d + 96), v3);
+			}
+		}
+
+		store256(dst, head);
+		store256(dst + n - 128, t0);
+		store256(dst + n - 96, t1);
+		store256(dst + n - 64, t2);
+		store256(dst + n - 32, t3);
+	}
+	else
+	{
+		__m256i h0 = load256(src);
+		__m256i h1 = load256(src + 32);
+		__m256i h2 = load256(src + 64);
+		__m256i h3 = load256(src + 96);
+		__m256i tail = load256(src + n - 32);
+		unsigned char* d = dst + n - ((uintptr_t)(dst + n) & 31);
+		const unsigned char* s = src + (d - dst);
+		unsigned char* end = dst + 128;
+
+		while(d > end)
+		{
+			d -= 128;
+			s -= 128;
+			__m256i v0 = load256(s);
+			__m256i v1 = load256(s + 32);
+			__m256i v2 = load256(s + 64);
+			__m256i v3 = load256(s + 96);
+			_mm256_store_si256((__m256i*)d, v0);
+			_mm256_store_si256((__m256i*)(d + 32), v1);
+			_mm256_store_si256((__m256i*)(d + 64), v2);
+			_mm256_store_si256((__m256i*)(d + 96), v3);
+		}
+
+		store256(dst + n - 32, tail);
+		store256(dst, h0);
+		store256(dst + 32, h1);
+		store256(dst + 64, h2);
+		store256(dst + 96, h3);
+	}
+
+	return dst;
+}
+
+__attribute__((target("avx2"))) static void* copy_avx2(unsigned char* dst,
+													   const unsigned char* src, size_t n)
+{
+	if(n <= 32)
+	{
+		// The SSE2 version is already optimal here, and doesn't touch the upper lanes
+		return copy_sse2(dst, src, n);
+	}
+
+	if(n <= 64)
+	{
+		__m256i v0 = load256(src);
+		__m256i v1 = load256(src + n - 32);
+		store256(dst, v0);
+		store256(dst + n - 32, v1);
+		return dst;
+	}
+
+	if(n <= 128)
+	{
+		__m256i v0 = load256(src);
+		__m256i v1 = load256(src + 32);
+		__m256i v2 = load256(src + n - 64);
+		__m256i v3 = load256(src + n - 32);
+		store256(dst, v0);
+		store256(dst + 32, v1);
+		store256(dst + n - 64, v2);
+		store256(dst + n - 32, v3);
+		return dst;
+	}
+
+	if(n <= 256)
+	{
+		__m256i v0 = load256(src);
+		__m256i v1 = load256(src + 32);
+		__m256i v2 = load256(src + 64);
+		__m256i v3 = load256(src + 96);
+		__m256i v4 = load256(src + n - 128);
+		__m256i v5 = load256(src + n - 96);
+		__m256i v6 = load256(src + n - 64);
+		__m256i v7 = load256(src + n - 32);
+		store256(dst, v0);
+		store256(dst + 32, v1);
+		store256(dst + 64, v2);
+		store256(dst + 96, v3);
+		store256(dst + n - 128, v4);
+		store256(dst + n - 96, v5);
+		store256(dst + n - 64, v6);
+		store256(dst + n - 32, v7);
+		return dst;
+	}
+
+	return copy_avx2_loop(dst, src, n);
+}
+
+#pragma mark - Dispatch -
+
+static void* copy_dispatch(unsigned char* dst, const unsigned char* src, size_t n)
+{
+	copy_fn_t impl = cpu_use_avx2() ? copy_avx2 : copy_sse2;
+
+	atomic_store_explicit(&copy_impl, impl, memory_order_relaxed);
+
+	return impl(dst, src, n);
+}
+
+#pragma mark - APIs -
+
+// The copy functions return dst, so these compile to a tail call
+void* memcpy(void* __restrict dst, const void* __restrict src, size_t n)
+{
+	return atomic_load_explicit(&copy_impl, memory_order_relaxed)(dst, src, n);
+}
+
+void* __attribute__((weak)) memmove(void* dst, const void* src, size_t n)
+{
+	return atomic_load_explicit(&copy_impl, memory_order_relaxed)(dst, src, n);
+}
@@ -0,0 +1,262 @@
+#include <immintrin.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include "cpu_features.h"
+
+/**
+ * x86_64 memset()
+ *
+ * Fills of up to eight vectors are stored as (possibly overlapping) head and tail vectors,
+ * with no loop. Larger fills store unaligned vectors at both edges, and fill the middle
+ * with an unrolled loop of aligned stores.
+ *
+ * Fills of MEMSET_ERMS_THRESHOLD bytes or more use rep stosb when the processor has
+ * Enhanced REP MOVSB/STOSB (ERMS). Microcode then fills whole cache lines at a time, and
+ * beats any vector loop once its startup cost is amortized.
+ *
+ * As with memcpy(), the SSE2 or AVX2 version is selected with cpuid on the first call, and
+ * X86_64_STRING_FORCE_SSE2 forces the SSE2 version.
+ */
+
+#pragma mark - Definitions -
+
+#ifndef MEMSET_ERMS_THRESHOLD
+/// Fills of at least this many bytes use rep stosb, when the processor supports ERMS
+#define MEMSET_ERMS_THRESHOLD 2048
+#endif
+
+typedef void* (*fill_fn_t)(unsigned char* dst, int c, size_t n);
+
+#pragma mark - Declarations -
+
+static void* fill_dispatch(unsigned char* dst, int c, size_t n);
+
+/// The selected implementation, resolved on the first call. Racing first calls may each
+/// resolve it, but they all store the same values. fill_dispatch() stores use_erms_ first
+/// and publishes fill_impl with a release store, so a caller that loads the selected
+/// implementation (with acquire) also sees use_erms_.
+static _Atomic(fill_fn_t) fill_impl = fill_dispatch;
+
+/// Set by fill_dispatch() before fill_impl is
+static atomic_int use_erms_ = 0;
+
+#pragma mark - Private Functions -
+
+static inline void store64(unsigned char* p, uint64_t v)
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline void store32(unsigned char* p, uint32_t v)
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+static inline void store16(unsigned char* p, uint16_t v)
+{
+	__builtin_memcpy(p, &v, sizeof(v));
+}
+
+/// Fill fewer than 16 bytes with overlapping scalar stores
+static inline void fill_small(unsigned char* dst, int c, size_t n)
+{
+	uint64_t v = (uint64_t)(unsigned char)c * 0x0101010101010101ULL;
+
+	if(n >= 8)
+	{
+		store64(dst, v);
+		store64(dst + n - 8, v);
+	}
+	else if(n >= 4)
+	{
+		store32(dst, (uint32_t)v);
+		store32(dst + n - 4, (uint32_t)v);
+	}
+	else if(n >= 2)
+	{
+		store16(dst, (uint16_t)v);
+		store16(dst + n - 2, (uint16_t)v);
+	}
+	else if(n == 1)
+	{
+		*dst = (unsigned char)c;
+	}
+}
+
+static inline void fill_erms(unsigned char* dst, int c, size_t n)
+{
+	__asm__ volatile("rep stosb" : "+D"(dst), "+c"(n) : "a"(c) : "memory");
+}
+
+#pragma mark - SSE2 -
+
+static inline void store128(unsigned char* p, __m128i v)
+{
+	_mm_storeu_si128((__m128i*)p, v);
+}
+
+static void* fill_sse2(unsigned char* dst, int c, size_t n)
+{
+	__m128i v;
+	unsigned char* d;
+	unsigned char* end;
+
+	if(n < 16)
+	{
+		fill_small(dst, c, n);
+		return dst;
+	}
+
+	v = _mm_set1_epi8((char)c);
+
+	if(n <= 32)
+	{
+		store128(dst, v);
+		store128(dst + n - 16, v);
+		return dst;
+	}
+
+	if(n <= 64)
+	{
+		store128(dst, v);
+		store128(dst + 16, v);
+		store128(dst + n - 32, v);
+		store128(dst + n - 16, v);
+		return dst;
+	}
+
+	if(n <= 128)
+	{
+		store128(dst, v);
+		store128(dst + 16, v);
+		store128(dst + 32, v);
+		store128(dst + 48, v);
+		store128(dst + n - 64, v);
+		store128(dst + n - 48, v);
+		store128(dst + n - 32, v);
+		store128(dst + n - 16, v);
+		return dst;
+	}
+
+	if(atomic_load_explicit(&use_erms_, memory_order_relaxed) && n >= MEMSET_ERMS_THRESHOLD)
+	{
+		fill_erms(dst, c, n);
+		return dst;
+	}
+
+	// The head and tail stores cover whatever the aligned loop doesn't
+	store128(dst, v);
+	store128(dst + n - 64, v);
+	store128(dst + n - 48, v);
+	store128(dst + n - 32, v);
+	store128(dst + n - 16, v);
+
+	d = (unsigned char*)(((uintptr_t)dst + 16) & ~(uintptr_t)15);
+	end = dst + n - 64;
+
+	for(; d < end; d += 64)
+	{
+		_mm_store_si128((__m128i*)d, v);
+		_mm_store_si128((__m128i*)(d + 16), v);
+		_mm_store_si128((__m128i*)(d + 32), v);
+		_mm_store_si128((__m128i*)(d + 48), v);
+	}
+
+	return dst;
+}
+
+#pragma mark - AVX2 -
+
+__attribute__((target("avx2"))) static inline void store256(unsigned char* p, __m256i v)
+{
+	_mm256_storeu_si256((__m256i*)p, v);
+}
+
+__attribute__((target("avx2"))) static void* fill_avx2(unsigned char* dst, int c, size_t n)
+{
+	__m256i v;
+	unsigned char* d;
+	unsigned char* end;
+
+	if(n <= 32)
+	{
+		// The SSE2 version is already optimal here, and doesn't touch the upper lanes
+		return fill_sse2(dst, c, n);
+	}
+
+	v = _mm256_set1_epi8((char)c);
+
+	if(n <= 64)
+	{
+		store256(dst, v);
+		store256(dst + n - 32, v);
+		return dst;
+	}
+
+	if(n <= 128)
+	{
+		store256(dst, v);
+		store256(dst + 32, v);
+		store256(dst + n - 64, v);
+		store256(dst + n - 32, v);
+		return dst;
+	}
+
+	if(n <= 256)
+	{
+		store256(dst, v);
+		store256(dst + 32, v);
+		store256(dst + 64, v);
+		store256(dst + 96, v);
+		store256(dst + n - 128, v);
+		store256(dst + n - 96, v);
+		store256(dst + n - 64, v);
+		store256(dst + n - 32, v);
+		return dst;
+	}
+
+	if(atomic_load_explicit(&use_erms_, memory_order_relaxed) && n >= MEMSET_ERMS_THRESHOLD)
+	{
+		fill_erms(dst, c, n);
+		return dst;
+	}
+
+	store256(dst, v);
+	store256(dst + n - 128, v);
+	store256(dst + n - 96, v);
+	store256(dst + n - 64, v);
+	store256(dst + n - 32, v);
+
+	d = (unsigned char*)(((uintptr_t)dst + 32) & ~(uintptr_t)31);
+	end = dst + n - 128;
+
+	for(; d < end; d += 128)
+	{
+		_mm256_store_si256((__m256i*)d, v);
+		_mm256_store_si256((__m256i*)(d + 32), v);
+		_mm256_store_si256((__m256i*)(d + 64), v);
+		_mm256_store_si256((__m256i*)(d + 96), v);
+	}
+
+	return dst;
+}
+
+#pragma mark - Dispatch -
+
+static void* fill_dispatch(unsigned char* dst, int c, size_t n)
+{
+	fill_fn_t impl = cpu_use_avx2() ? fill_avx2 : fill_sse2;
+
+	atomic_store_explicit(&use_erms_, cpu_has_erms(), memory_order_relaxed);
+	atomic_store_explicit(&fill_impl, impl, memory_order_release);
+
+	return impl(dst, c, n);
+}
+
+#pragma mark - APIs -
+
+void* __attribute__((weak)) memset(void* dest, int c, size_t n)
+{
+	return atomic_load_explicit(&fill_impl, memory_order_acquire)(dest, c, n);
+}
@@ -13,6 +13,8 @@
 
 #include <fixed_point_tests.h>
 #include <circular_buffer_tests.h>
+#include <pool_alloc_tests.h>
+#include <arena_alloc_tests.h>
 
 int main(void)
 {
@@ -20,6 +22,8 @@ int main(void)
 
 	overall_result |= simple_fixed_point_test_suite();
 	overall_result |= circular_buffer_test_suite();
+	overall_result |= pool_alloc_test_suite();
+	overall_result |= arena_alloc_test_suite();
 
 	return overall_result;
 }
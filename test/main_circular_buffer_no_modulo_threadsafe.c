@@ -12,12 +12,14 @@
 // clang-format on
 
 #include <circular_buffer_tests.h>
+#include <circular_buffer_threadsafe_tests.h>
 
 int main(void)
 {
 	int overall_result = 0;
 
 	overall_result |= circular_buffer_test_suite();
+	overall_result |= circular_buffer_threadsafe_test_suite();
 
 	return overall_result;
 }
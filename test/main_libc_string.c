@@ -0,0 +1,28 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// CMocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <string_tests.h>
+
+int main(void)
+{
+	int overall_result = 0;
+
+	overall_result |= find_byte_test_suite();
+	overall_result |= memcmp_test_suite();
+	overall_result |= memcpy_test_suite();
+	overall_result |= memset_test_suite();
+	overall_result |= substring_test_suite();
+	overall_result |= tokenize_test_suite();
+
+	return overall_result;
+}
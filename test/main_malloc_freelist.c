@@ -0,0 +1,23 @@
+/*
+ * Copyright © 2021 Embedded Artistry LLC.
+ * See LICENSE file for licensing information.
+ */
+
+// CMocka needs these
+// clang-format off
+#include <setjmp.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <cmocka.h>
+// clang-format on
+
+#include <malloc_freelist_tests.h>
+
+int main(void)
+{
+	int overall_result = 0;
+
+	overall_result |= malloc_freelist_test_suite();
+
+	return overall_result;
+}